@@ -29,6 +29,7 @@ www.navitia.io
 */
 
 #include "autocomplete.h"
+#include "autocomplete_cache.h"
 #include "type/pt_data.h"
 namespace navitia { namespace autocomplete {
 
@@ -153,6 +154,8 @@ void Autocomplete<T>::compute_score(type::PT_Data &pt_data, georef::GeoRef &geor
         default:
             break;
     }
+    // the searches can now meet the best scores first
+    rank_by_score();
 }
 
 std::pair<size_t, size_t> longest_common_substring(const std::string& str1, const std::string& str2) {
@@ -36,12 +36,15 @@ www.navitia.io
 #include <boost/serialization/utility.hpp>
 #include <boost/serialization/map.hpp>
 #include <algorithm>
+#include <atomic>
 #include <boost/regex.hpp>
 #include <map>
+#include <memory>
 #include <unordered_map>
 #include <set>
 #include "type/type.h"
 #include "utils/functions.h"
+#include "autocomplete/prefix_index.h"
 
 namespace navitia { namespace autocomplete {
 
@@ -58,6 +61,8 @@ struct Compare {
 std::pair<size_t, size_t> longest_common_substring(const std::string&, const std::string&);
 
 using autocomplete_map = std::map<std::string, std::string, Compare>;
+
+template<class T> class AutocompleteCache;
 /** Map de type Autocomplete
   *
   * On associe une chaine de caractères, par exemple "rue jean jaures" à une valeur T (typiquement un pointeur
@@ -100,18 +105,20 @@ struct Autocomplete
     /// Type of object
     navitia::type::Type_e object_type;
 
+    /// Shard of the AutocompleteCache, not serialized.
+    /// The autocompletes built one after the other are on different shards.
+    size_t cache_shard = next_cache_shard();
+
     /// Structure temporaire pour construire l'indexe
     std::map<std::string, std::set<T> > temp_word_map;
 
-    /// À chaque mot (par exemple "rue" ou "jaures") on associe un tableau de T qui contient la liste des éléments contenant ce mot
-    typedef std::pair<std::string, std::vector<T> > vec_elt;
-
-    /// Structure principale de notre indexe
-    std::vector<vec_elt> word_dictionnary;
+    /// Structure principale de notre indexe : à chaque mot (par exemple "rue" ou "jaures")
+    /// on associe la liste triée des éléments contenant ce mot
+    PrefixIndex<T> word_index;
 
     /// Structure temporaire pour garder les patterns et leurs indexs
     std::map<std::string, std::set<T> > temp_pattern_map;
-    std::vector<vec_elt> pattern_dictionnary;
+    PrefixIndex<T> pattern_index;
 
     /// Structure pour garder les informations comme nombre des mots, la distance des mots...dans chaque Autocomplete (Position)
     std::map<T, word_quality> word_quality_list;
@@ -119,18 +126,24 @@ struct Autocomplete
     // for each T, we store the originaly indexed string (for better score handling)
     std::map<T, std::string> indexed_string;
 
+    // the elements in the decreasing order of their scores. Once rank_by_score
+    // has been called, word_index contains the ranks of the elements in this
+    // vector instead of the elements, so a search meets the best scores first
+    std::vector<T> ranked_elements;
+
     template<class Archive> void serialize(Archive & ar, const unsigned int) {
-        ar & word_dictionnary & word_quality_list & pattern_dictionnary & object_type & indexed_string;
+        ar & word_index & word_quality_list & pattern_index & object_type & indexed_string & ranked_elements;
     }
 
     /// Efface les structures de données sérialisées
     void clear() {
         temp_word_map.clear();
-        word_dictionnary.clear();
+        word_index.clear();
         temp_pattern_map.clear();
-        pattern_dictionnary.clear();
+        pattern_index.clear();
         word_quality_list.clear();
         indexed_string.clear();
+        ranked_elements.clear();
     }
 
     // Méthodes permettant de construire l'indexe
@@ -200,91 +213,116 @@ struct Autocomplete
       * Les map et les set sont bien pratiques, mais leurs performances sont mauvaises avec des petites données (comme des ints)
       */
     void build(){
-        word_dictionnary.reserve(temp_word_map.size());
-        for(auto key_val: temp_word_map){
-            word_dictionnary.push_back(std::make_pair(key_val.first, std::vector<T>(key_val.second.begin(), key_val.second.end())));
-        }
+        ranked_elements.clear();
+        word_index.build(temp_word_map);
 
         //Dictionnaire des patterns:
-        pattern_dictionnary.reserve((temp_pattern_map.size()));
-        for(auto key_val:temp_pattern_map){
-            pattern_dictionnary.push_back(std::make_pair(key_val.first, std::vector<T>(key_val.second.begin(), key_val.second.end())));
-        }
+        pattern_index.build(temp_pattern_map);
     }
 
     //Méthode pour calculer le score de chaque élément par son admin.
     void compute_score(type::PT_Data &pt_data, georef::GeoRef &georef,
                        const type::Type_e type);
-    // Méthodes premettant de retrouver nos éléments
-    /** Définit un fonctor permettant de parcourir notre structure un peu particulière */
-    struct comp{
-        /** Utilisé pour trouver la borne inf. Quand on cherche av, on veux que avenue soit également trouvé
-          * Il faut donc que "av" < "avenue" soit false
-          */
-        bool operator()(const std::string & a, const std::pair<std::string, std::vector<T> > & b){
-            if(b.first.find(a) == 0) return false;
-            return (a < b.first);
-        }
 
-        /** Utilisé pour la borne sup. Ici rien d'extraordinaire */
-        bool operator()(const std::pair<std::string, std::vector<T> > & b, const std::string & a){
-            return (b.first < a);
-        }
-    };
+    /// the element of an id of word_index
+    T element_of(T id) const {
+        return ranked_elements.empty() ? id : ranked_elements[id];
+    }
 
+    /// order the ids of word_index by decreasing scores, to be called once the scores are computed
+    void rank_by_score() {
+        std::vector<std::pair<int, T>> score_elements;
+        score_elements.reserve(word_quality_list.size());
+        for (const auto& elt_quality: word_quality_list) {
+            score_elements.push_back({- elt_quality.second.score, elt_quality.first});
+        }
+        std::sort(score_elements.begin(), score_elements.end());
+
+        std::vector<T> elements;
+        elements.reserve(score_elements.size());
+        std::unordered_map<T, T> rank_of;
+        for (const auto& score_elt: score_elements) {
+            rank_of[score_elt.second] = elements.size();
+            elements.push_back(score_elt.second);
+        }
+        word_index.transform([&](T id) { return rank_of.at(this->element_of(id)); });
+        ranked_elements = std::move(elements);
+    }
+    // Méthodes premettant de retrouver nos éléments
     /** Retrouve toutes les positions des élements contenant le mot des mots qui commencent par token */
-    std::vector<T> match(const std::string &token, const std::vector<vec_elt> &vec_source) const {
-        // Les éléments dans vec_map sont triés par ordre alphabétiques, il suffit donc de trouver la borne inf et sup
-        auto lower = std::lower_bound(vec_source.begin(), vec_source.end(), token, comp());
-        auto upper = std::upper_bound(vec_source.begin(), vec_source.end(), token, comp());
+    std::vector<T> match(const std::string &token, const PrefixIndex<T> &index) const {
+        // Les mots sont triés par ordre alphabétique, ceux qui commencent par token sont donc contigus
+        const auto range = index.prefix_range(token);
 
         std::vector<T> result;
 
         // On concatène tous les indexes
         // Pour les raisons de perfs mesurées expérimentalement, on accepte des doublons
-        for(; lower != upper; ++lower){
-            std::vector<T> other = lower->second;
-            result.insert(result.end(), other.begin(), other.end());
+        for (size_t i = range.first; i < range.second; ++i) {
+            index.append_elements(i, result);
         }
         return result;
     }
 
-    /** On passe une chaîne de charactère contenant des mots et on trouve toutes les positions contenant tous ces mots*/
-    std::vector<T> find(const std::set<std::string>& vecStr) const {
+    /** Comme match, mais triés et sans doublons */
+    std::vector<T> match_sorted(const std::string &token, const PrefixIndex<T> &index) const {
+        const auto range = index.prefix_range(token);
         std::vector<T> result;
-        auto vec = vecStr.begin();
-        if(vec != vecStr.end()){
-            // Premier résultat. Il y aura au plus ces indexes
-            result = match(*vec, word_dictionnary);
-
-            //If there is only one word to search we have to sort and delete duplicate results
-            if (vecStr.size() == 1) {
-                std::sort(result.begin(), result.end());
-                result.erase(unique(result.begin(), result.end()), result.end());
-            }
+        for (size_t i = range.first; i < range.second; ++i) {
+            index.append_elements(i, result);
+        }
+        // the elements of a single word are already sorted and unique
+        if (range.second - range.first > 1) {
+            std::sort(result.begin(), result.end());
+            result.erase(std::unique(result.begin(), result.end()), result.end());
+        }
+        return result;
+    }
 
-            for(++vec; vec != vecStr.end(); ++vec){
-                std::vector<T> new_result;
-                std::sort(result.begin(), result.end());
-                for(auto i : match(*vec, word_dictionnary)){
-                    // Binary search fait une recherche dichotomique pour savoir si l'élément i existe
-                    // S'il existe dans les deux cas, on le garde
-                    if(binary_search(result.begin(), result.end(), i)){
-                        new_result.push_back(i);
-                    }
-                }
-                //The function "unique" works only if the vector new_result is sorted.
-                std::sort(new_result.begin(), new_result.end());
+    /** On passe une chaîne de charactère contenant des mots et on trouve toutes les positions contenant tous ces mots*/
+    std::vector<T> find(const std::set<std::string>& vecStr) const {
+        auto result = find_ids(vecStr);
+        if (! ranked_elements.empty()) {
+            for (auto& id: result) { id = ranked_elements[id]; }
+            std::sort(result.begin(), result.end());
+        }
+        return result;
+    }
 
-                // std::unique retrie les donnée et fout les doublons à la fin
-                // La fonction retourne un itérateur vers le premier doublon
-                // Expérimentalement le gain est très faible
-                result.assign(new_result.begin(), std::unique(new_result.begin(), new_result.end()));
+    /// the sorted ids of word_index containing all the words (see element_of)
+    std::vector<T> find_ids(const std::set<std::string>& vecStr) const {
+        std::vector<std::vector<T>> elements_by_word;
+        elements_by_word.reserve(vecStr.size());
+        for (const auto& word: vecStr) {
+            elements_by_word.push_back(match_sorted(word, word_index));
+            if (elements_by_word.back().empty()) {
+                return {};
             }
         }
+        if (elements_by_word.empty()) {
+            return {};
+        }
+
+        // the lists are intersected from the smallest one, the intersection
+        // being at most as big as it
+        std::sort(elements_by_word.begin(), elements_by_word.end(),
+                  [](const std::vector<T>& a, const std::vector<T>& b) { return a.size() < b.size(); });
+        std::vector<T> result = std::move(elements_by_word.front());
+        for (size_t i = 1; i < elements_by_word.size() && ! result.empty(); ++i) {
+            result = galloping_intersection(result, elements_by_word[i]);
+        }
         return result;
     }
 
+    /// the ids among the sorted ids that contain also all the words (see find_ids)
+    std::vector<T> refine_ids(std::vector<T> ids, const std::set<std::string>& vecStr) const {
+        for (const auto& word: vecStr) {
+            if (ids.empty()) { break; }
+            ids = galloping_intersection(ids, match_sorted(word, word_index));
+        }
+        return ids;
+    }
+
     /** Définit un fonctor permettant de parcourir notqualityre structure un peu particulière : trier par la valeur "nb_found"*/
     /** associé au valeur du vector<T> */
     struct Compare{
@@ -340,24 +378,40 @@ struct Autocomplete
         );
     }
 
-    /** On passe une chaîne de charactère contenant des mots et on trouve toutes les positions contenant au moins un des mots*/
+    /** On passe une chaîne de charactère contenant des mots et on trouve toutes les positions contenant au moins un des mots
+      *
+      * The ids found for the previous queries are reused if a cache is given
+      */
     std::vector<fl_quality> find_complete(const std::string& str,
                                           size_t nbmax,
                                           std::function<bool(T)> keep_element,
-                                          const std::set<std::string>& ghostwords)
+                                          const std::set<std::string>& ghostwords,
+                                          AutocompleteCache<T>* cache = nullptr)
                                           const {
         auto vec = tokenize(str, ghostwords);
         int wordLength = 0;
         fl_quality quality;
-        std::vector<T> index_result;
         //Vector des ObjetTC index trouvés
-        index_result = find(vec);
+        std::shared_ptr<const std::vector<T>> index_result;
+        if (cache) {
+            index_result = cache->find_ids(*this, vec);
+        } else {
+            index_result = std::make_shared<const std::vector<T>>(find_ids(vec));
+        }
         wordLength = words_length(vec);
 
         // Créer un vector de réponse:
         std::vector<fl_quality> vec_quality;
 
-        for (auto i : index_result) {
+        for (auto id : *index_result) {
+            const T i = element_of(id);
+            // the ranked ids come by decreasing scores, and the score is the first
+            // criteria of the comparison: once nbmax elements are kept, an element
+            // with a lower score than the last kept cannot be in the result
+            if (! ranked_elements.empty() && ! vec_quality.empty() && vec_quality.size() >= nbmax
+                    && word_quality_list.at(i).score < std::get<0>(vec_quality.back().scores)) {
+                break;
+            }
             if (keep_element(i)) {
                 quality.idx = i;
                 quality.nb_found = word_quality_list.at(quality.idx).word_count;
@@ -407,14 +461,14 @@ struct Autocomplete
         auto vec = vec_pattern.begin();
         if (vec != vec_pattern.end()){
             //Premier résultat:
-            index_result = match(*vec, pattern_dictionnary);
+            index_result = match(*vec, pattern_index);
 
             //Incrémenter la propriété "nb_found" pour chaque index des mots autocomplete dans vec_map
             add_word_quality(fl_result,index_result);
 
             //Recherche des mots qui restent
             for (++vec; vec != vec_pattern.end(); ++vec){
-                index_result = match(*vec, pattern_dictionnary);
+                index_result = match(*vec, pattern_index);
 
                 //For each match of n-gram pattern word 1 is added to "nb_found"
                 add_word_quality(fl_result,index_result);
@@ -434,13 +488,17 @@ struct Autocomplete
                     quality.idx = pair.first;
                     quality.nb_found = pair.second.nb_found;
                     quality.word_len = wordLength;
-                    quality.scores = this->compute_result_scores(str, quality.idx);
                     quality.quality = calc_quality_pattern(quality, word_weight, max_score, pattern_count);
                     vec_quality.push_back(quality);
                 }
             }
         }
-        return sort_and_truncate_by_quality(vec_quality, nbmax);
+        vec_quality = sort_and_truncate_by_quality(vec_quality, nbmax);
+        // the scores are not used to sort, only the kept elements need them
+        for (auto& q: vec_quality) {
+            q.scores = this->compute_result_scores(str, q.idx);
+        }
+        return vec_quality;
     }
 
 
@@ -540,6 +598,11 @@ struct Autocomplete
         return vec;
     }
 
+private:
+    static size_t next_cache_shard() {
+        static std::atomic<size_t> nb_autocompletes{0};
+        return nb_autocompletes++;
+    }
 };
 
 extern template struct Autocomplete<navitia::type::idx_t>;
@@ -31,6 +31,7 @@ www.navitia.io
 #include "autocomplete_api.h"
 #include "type/pb_converter.h"
 #include "autocomplete/autocomplete.h"
+#include "autocomplete/autocomplete_cache.h"
 #include "utils/functions.h"
 
 namespace navitia { namespace autocomplete {
@@ -198,6 +199,8 @@ void autocomplete(navitia::PbCreator& pb_creator, const std::string &q,
 
     //Compute number of words in the query:
     std::set<std::string> query_word_vec = d.geo_ref->fl_admin.tokenize(q, d.geo_ref->ghostwords);
+    // the ids found for the previous keystrokes of the users
+    auto* cache = d.autocomplete_cache.get();
 
     ///Find max(100, count) éléments for each pt_object
     for(nt::Type_e type : filter) {
@@ -206,7 +209,7 @@ void autocomplete(navitia::PbCreator& pb_creator, const std::string &q,
         case nt::Type_e::StopArea:
             if (search_type==0) {
                 result = d.pt_data->stop_area_autocomplete.find_complete(q,
-                        nbmax, valid_admin_ptr(d.pt_data->stop_areas, admin_ptr), d.geo_ref->ghostwords);
+                        nbmax, valid_admin_ptr(d.pt_data->stop_areas, admin_ptr), d.geo_ref->ghostwords, cache);
             } else {
                 result = d.pt_data->stop_area_autocomplete.find_partial_with_pattern(q,
                         d.geo_ref->word_weight,
@@ -216,7 +219,7 @@ void autocomplete(navitia::PbCreator& pb_creator, const std::string &q,
         case nt::Type_e::StopPoint:
             if (search_type==0) {
                 result = d.pt_data->stop_point_autocomplete.find_complete(q,
-                        nbmax, valid_admin_ptr(d.pt_data->stop_points, admin_ptr), d.geo_ref->ghostwords);
+                        nbmax, valid_admin_ptr(d.pt_data->stop_points, admin_ptr), d.geo_ref->ghostwords, cache);
             } else {
                 result = d.pt_data->stop_point_autocomplete.find_partial_with_pattern(q,
                         d.geo_ref->word_weight, nbmax,
@@ -226,7 +229,7 @@ void autocomplete(navitia::PbCreator& pb_creator, const std::string &q,
         case nt::Type_e::Admin:
             if (search_type==0) {
                 result = d.geo_ref->fl_admin.find_complete(q,
-                        nbmax, valid_admin_ptr(d.geo_ref->admins, admin_ptr), d.geo_ref->ghostwords);
+                        nbmax, valid_admin_ptr(d.geo_ref->admins, admin_ptr), d.geo_ref->ghostwords, cache);
             } else {
                 result = d.geo_ref->fl_admin.find_partial_with_pattern(q,
                         d.geo_ref->word_weight,
@@ -235,12 +238,12 @@ void autocomplete(navitia::PbCreator& pb_creator, const std::string &q,
             break;
         case nt::Type_e::Address:
             result = d.geo_ref->find_ways(q, nbmax, search_type,
-                    valid_admin_ptr(d.geo_ref->ways, admin_ptr), d.geo_ref->ghostwords);
+                    valid_admin_ptr(d.geo_ref->ways, admin_ptr), d.geo_ref->ghostwords, cache);
             break;
         case nt::Type_e::POI:
             if (search_type==0) {
                 result = d.geo_ref->fl_poi.find_complete(q,
-                        nbmax, valid_admin_ptr(d.geo_ref->pois, admin_ptr), d.geo_ref->ghostwords);
+                        nbmax, valid_admin_ptr(d.geo_ref->pois, admin_ptr), d.geo_ref->ghostwords, cache);
             } else {
                 result = d.geo_ref->fl_poi.find_partial_with_pattern(q,
                         d.geo_ref->word_weight, nbmax,
@@ -250,7 +253,7 @@ void autocomplete(navitia::PbCreator& pb_creator, const std::string &q,
         case nt::Type_e::Network:
             if (search_type==0) {
                 result = d.pt_data->network_autocomplete.find_complete(q,
-                         nbmax, [](type::idx_t){return true;}, d.geo_ref->ghostwords);
+                         nbmax, [](type::idx_t){return true;}, d.geo_ref->ghostwords, cache);
             } else {
                 result = d.pt_data->network_autocomplete.find_partial_with_pattern(q,
                          d.geo_ref->word_weight, nbmax,
@@ -260,7 +263,7 @@ void autocomplete(navitia::PbCreator& pb_creator, const std::string &q,
         case nt::Type_e::CommercialMode:
             if (search_type==0) {
                 result = d.pt_data->mode_autocomplete.find_complete(q,
-                            nbmax, [](type::idx_t){return true;}, d.geo_ref->ghostwords);
+                            nbmax, [](type::idx_t){return true;}, d.geo_ref->ghostwords, cache);
             } else {
                 result = d.pt_data->mode_autocomplete.find_partial_with_pattern(q,
                             d.geo_ref->word_weight, nbmax,
@@ -270,7 +273,7 @@ void autocomplete(navitia::PbCreator& pb_creator, const std::string &q,
         case nt::Type_e::Line:
             if (search_type==0) {
                 result = d.pt_data->line_autocomplete.find_complete(q,
-                        nbmax, [](type::idx_t){return true;}, d.geo_ref->ghostwords);
+                        nbmax, [](type::idx_t){return true;}, d.geo_ref->ghostwords, cache);
             } else {
                 result = d.pt_data->line_autocomplete.find_partial_with_pattern(q,
                                             d.geo_ref->word_weight,
@@ -280,7 +283,7 @@ void autocomplete(navitia::PbCreator& pb_creator, const std::string &q,
         case nt::Type_e::Route:
             if (search_type==0) {
                 result = d.pt_data->route_autocomplete.find_complete(q,
-                            nbmax, [](type::idx_t){return true;}, d.geo_ref->ghostwords);
+                            nbmax, [](type::idx_t){return true;}, d.geo_ref->ghostwords, cache);
             } else {
                 result = d.pt_data->route_autocomplete.find_partial_with_pattern(q,
                             d.geo_ref->word_weight,
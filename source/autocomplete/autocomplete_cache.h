@@ -0,0 +1,208 @@
+/* Copyright © 2001-2014, Canal TP and/or its affiliates. All rights reserved.
+  
+This file is part of Navitia,
+    the software to build cool stuff with public transport.
+ 
+Hope you'll enjoy and contribute to this project,
+    powered by Canal TP (www.canaltp.fr).
+Help us simplify mobility and open public transport:
+    a non ending quest to the responsive locomotion way of traveling!
+  
+LICENCE: This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU Affero General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+   
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU Affero General Public License for more details.
+   
+You should have received a copy of the GNU Affero General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+  
+Stay tuned using
+twitter @navitia 
+IRC #navitia on freenode
+https://groups.google.com/d/forum/navitia
+www.navitia.io
+*/
+
+#pragma once
+#include "autocomplete/autocomplete.h"
+#include <array>
+#include <atomic>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace navitia { namespace autocomplete {
+
+/** LRU of the ids found by Autocomplete::find_ids, by autocomplete and set of tokens
+  *
+  * The users type their queries one character after the other ("b", "bo",
+  * "bou"...). The ids of a query are among the ids of an entry whose tokens
+  * are all prefixes of the tokens of the query: only the tokens of the query
+  * that are not in the entry have then to be intersected with them.
+  *
+  * The cache is bounded by the number of ids it keeps. The entries are split
+  * in shards by autocomplete, each with its own lock and its share of the ids,
+  * so that the autocompletes of a request do not evict each other. A list of
+  * ids bigger than a quarter of a shard (the short prefixes on the ways or the
+  * pois) is not kept.
+  *
+  * It is thread safe, to be shared by the workers using the same data.
+  */
+template<class T>
+class AutocompleteCache {
+public:
+    typedef std::shared_ptr<const std::vector<T>> Ids;
+
+    explicit AutocompleteCache(size_t max_nb_ids):
+        max_nb_ids_by_shard(max_nb_ids / nb_shards),
+        max_entry_nb_ids(max_nb_ids / nb_shards / 4) {}
+
+    Ids find_ids(const Autocomplete<T>& autocomplete, const std::set<std::string>& tokens) {
+        // without token, nothing is found, and this cannot be refined
+        if (tokens.empty()) {
+            return std::make_shared<const std::vector<T>>();
+        }
+
+        Shard& shard = shard_of(autocomplete);
+        Ids cached_ids;
+        std::set<std::string> new_tokens = tokens;
+        {
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            ++nb_calls;
+            const auto exact = shard.by_key.find(Key(&autocomplete, tokens));
+            if (exact != shard.by_key.end()) {
+                shard.entries.splice(shard.entries.begin(), shard.entries, exact->second);
+                ++nb_hits;
+                return exact->second->ids;
+            }
+            const auto best = find_best_entry(shard, autocomplete, tokens);
+            if (best != shard.entries.end()) {
+                shard.entries.splice(shard.entries.begin(), shard.entries, best);
+                ++nb_refined;
+                cached_ids = best->ids;
+                for (const auto& token: best->tokens) { new_tokens.erase(token); }
+            }
+        }
+
+        // the ids are computed without lock
+        Ids ids;
+        if (cached_ids) {
+            ids = std::make_shared<const std::vector<T>>(autocomplete.refine_ids(*cached_ids, new_tokens));
+        } else {
+            ids = std::make_shared<const std::vector<T>>(autocomplete.find_ids(tokens));
+        }
+        if (ids->size() > max_entry_nb_ids) {
+            return ids;
+        }
+
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        const Key key(&autocomplete, tokens);
+        // another worker may have found them meanwhile
+        if (shard.by_key.count(key)) {
+            return ids;
+        }
+        shard.entries.push_front({&autocomplete, tokens, ids});
+        shard.by_key[key] = shard.entries.begin();
+        shard.nb_ids += ids->size();
+        while (shard.nb_ids > max_nb_ids_by_shard || shard.entries.size() > max_nb_entries_by_shard) {
+            const Entry& lru = shard.entries.back();
+            shard.nb_ids -= lru.ids->size();
+            shard.by_key.erase(Key(lru.autocomplete, lru.tokens));
+            shard.entries.pop_back();
+        }
+        return ids;
+    }
+
+    void clear() {
+        for (auto& shard: shards) {
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            shard.entries.clear();
+            shard.by_key.clear();
+            shard.nb_ids = 0;
+        }
+    }
+
+    size_t get_nb_calls() const { return nb_calls; }
+    size_t get_nb_hits() const { return nb_hits; }
+    size_t get_nb_refined() const { return nb_refined; }
+    size_t get_nb_ids() {
+        size_t res = 0;
+        for (auto& shard: shards) {
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            res += shard.nb_ids;
+        }
+        return res;
+    }
+
+private:
+    struct Entry {
+        const Autocomplete<T>* autocomplete;
+        std::set<std::string> tokens;
+        Ids ids;
+    };
+    typedef std::pair<const Autocomplete<T>*, std::set<std::string>> Key;
+
+    struct Shard {
+        std::mutex mutex;
+        // the most recently used first
+        std::list<Entry> entries;
+        std::map<Key, typename std::list<Entry>::iterator> by_key;
+        size_t nb_ids = 0;
+    };
+    static const size_t nb_shards = 8;
+    // bounds the scan of the entries to refine
+    static const size_t max_nb_entries_by_shard = 64;
+
+    Shard& shard_of(const Autocomplete<T>& autocomplete) {
+        return shards[autocomplete.cache_shard % nb_shards];
+    }
+
+    // true if each token of the entry begins a token of the query
+    static bool is_refined_by(const std::set<std::string>& entry_tokens,
+                              const std::set<std::string>& tokens) {
+        for (const auto& entry_token: entry_tokens) {
+            bool found = false;
+            for (const auto& token: tokens) {
+                if (token.compare(0, entry_token.size(), entry_token) == 0) {
+                    found = true;
+                    break;
+                }
+            }
+            if (! found) { return false; }
+        }
+        return true;
+    }
+
+    // the entry to refine with the fewest ids
+    static typename std::list<Entry>::iterator
+    find_best_entry(Shard& shard, const Autocomplete<T>& autocomplete, const std::set<std::string>& tokens) {
+        auto best = shard.entries.end();
+        for (auto it = shard.entries.begin(); it != shard.entries.end(); ++it) {
+            if (it->autocomplete != &autocomplete) { continue; }
+            if (! is_refined_by(it->tokens, tokens)) { continue; }
+            if (best == shard.entries.end() || it->ids->size() < best->ids->size()) {
+                best = it;
+            }
+        }
+        return best;
+    }
+
+    size_t max_nb_ids_by_shard;
+    size_t max_entry_nb_ids;
+    std::array<Shard, nb_shards> shards;
+    std::atomic<size_t> nb_calls{0};
+    std::atomic<size_t> nb_hits{0};
+    std::atomic<size_t> nb_refined{0};
+};
+
+}} // namespace navitia::autocomplete
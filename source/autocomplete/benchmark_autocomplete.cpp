@@ -0,0 +1,122 @@
+/* Copyright © 2001-2014, Canal TP and/or its affiliates. All rights reserved.
+  
+This file is part of Navitia,
+    the software to build cool stuff with public transport.
+ 
+Hope you'll enjoy and contribute to this project,
+    powered by Canal TP (www.canaltp.fr).
+Help us simplify mobility and open public transport:
+    a non ending quest to the responsive locomotion way of traveling!
+  
+LICENCE: This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU Affero General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+   
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU Affero General Public License for more details.
+   
+You should have received a copy of the GNU Affero General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+  
+Stay tuned using
+twitter @navitia 
+IRC #navitia on freenode
+https://groups.google.com/d/forum/navitia
+www.navitia.io
+*/
+
+#include "autocomplete.h"
+#include "type/data.h"
+#include "type/pt_data.h"
+#include "georef/georef.h"
+#include "utils/timer.h"
+#include "utils/init.h"
+#include <boost/program_options.hpp>
+#include <fstream>
+#include <iostream>
+
+using namespace navitia;
+using namespace autocomplete;
+namespace po = boost::program_options;
+
+static void run(const std::string& name,
+                const Autocomplete<type::idx_t>& ac,
+                const std::vector<std::string>& keystrokes,
+                const georef::GeoRef& geo_ref,
+                size_t nbmax) {
+    const auto keep_all = [](type::idx_t) { return true; };
+    size_t nb_found = 0, nb_found_partial = 0;
+    {
+        Timer t(name + ": find_complete");
+        for (const auto& q: keystrokes) {
+            nb_found += ac.find_complete(q, nbmax, keep_all, geo_ref.ghostwords).size();
+        }
+    }
+    {
+        Timer t(name + ": find_partial_with_pattern");
+        for (const auto& q: keystrokes) {
+            nb_found_partial += ac.find_partial_with_pattern(q, geo_ref.word_weight, nbmax,
+                                                             keep_all, geo_ref.ghostwords).size();
+        }
+    }
+    std::cout << name << ": " << ac.word_index.size() << " words, "
+              << (ac.ranked_elements.empty() ? "not " : "") << "ranked by score, "
+              << nb_found << " found (" << nb_found_partial << " with the patterns)" << std::endl;
+}
+
+int main(int argc, char** argv) {
+    navitia::init_app();
+    po::options_description desc("Benchmark of the autocomplete");
+    std::string file, queries_file;
+    size_t nbmax;
+
+    desc.add_options()
+            ("help", "Show this message")
+            ("queries,q", po::value<std::string>(&queries_file)->required(),
+                     "File of the queries of the users, one per line")
+            ("nbmax,n", po::value<size_t>(&nbmax)->default_value(10 * 10),
+                     "Max number of results by type, autocomplete asks 10 times the count of the request")
+            ("file,f", po::value<std::string>(&file)->default_value("data.nav.lz4"),
+                     "Path to data.nav.lz4");
+    po::variables_map vm;
+    po::store(po::parse_command_line(argc, argv, desc), vm);
+
+    if (vm.count("help")) {
+        std::cout << "This is used to benchmark the autocomplete on the keystrokes of real queries" << std::endl;
+        std::cout << desc << std::endl;
+        return 1;
+    }
+    po::notify(vm);
+
+    // each query is replayed as typed: "b", "bo", "bou"...
+    std::vector<std::string> keystrokes;
+    std::ifstream queries(queries_file);
+    std::string query;
+    while (std::getline(queries, query)) {
+        for (size_t len = 1; len <= query.size(); ++len) {
+            // a multi bytes character is typed at once
+            if (len < query.size() && (query[len] & 0xC0) == 0x80) { continue; }
+            keystrokes.push_back(query.substr(0, len));
+        }
+    }
+    if (keystrokes.empty()) {
+        std::cout << "no query in " << queries_file << std::endl;
+        return 1;
+    }
+
+    type::Data data;
+    {
+        Timer t("Loading data: " + file);
+        data.load(file);
+    }
+    std::cout << keystrokes.size() << " keystrokes" << std::endl;
+
+    run("stop areas", data.pt_data->stop_area_autocomplete, keystrokes, *data.geo_ref, nbmax);
+    run("admins", data.geo_ref->fl_admin, keystrokes, *data.geo_ref, nbmax);
+    run("ways", data.geo_ref->fl_way, keystrokes, *data.geo_ref, nbmax);
+    run("pois", data.geo_ref->fl_poi, keystrokes, *data.geo_ref, nbmax);
+    return 0;
+}
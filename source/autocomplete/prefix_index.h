@@ -0,0 +1,262 @@
+/* Copyright © 2001-2014, Canal TP and/or its affiliates. All rights reserved.
+  
+This file is part of Navitia,
+    the software to build cool stuff with public transport.
+ 
+Hope you'll enjoy and contribute to this project,
+    powered by Canal TP (www.canaltp.fr).
+Help us simplify mobility and open public transport:
+    a non ending quest to the responsive locomotion way of traveling!
+  
+LICENCE: This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU Affero General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+   
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU Affero General Public License for more details.
+   
+You should have received a copy of the GNU Affero General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+  
+Stay tuned using
+twitter @navitia 
+IRC #navitia on freenode
+https://groups.google.com/d/forum/navitia
+www.navitia.io
+*/
+
+#pragma once
+#include <boost/serialization/serialization.hpp>
+#include <boost/serialization/vector.hpp>
+#include <algorithm>
+#include <cstdint>
+#include <map>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace navitia { namespace autocomplete {
+
+/** Compact index of the words and of the elements containing them
+  *
+  * The words are sorted and front coded by blocks of block_size words: the
+  * first word of a block is stored fully, the next ones as the length of
+  * the prefix shared with the previous word followed by the rest of the
+  * word. A prefix is looked up by a binary search on the first words of the
+  * blocks, and gives the range of the words beginning with it.
+  *
+  * The sorted elements of each word are stored as varint encoded deltas.
+  */
+template<class T>
+struct PrefixIndex {
+    static constexpr uint32_t block_size = 16;
+
+    uint32_t nb_words = 0;
+    /// front coded words
+    std::vector<uint8_t> words;
+    /// offset in words of the first word of each block
+    std::vector<uint32_t> block_offsets;
+    /// delta encoded elements of the words
+    std::vector<uint8_t> postings;
+    /// offset in postings of the elements of each word, plus the end
+    std::vector<uint32_t> posting_offsets;
+
+    template<class Archive> void serialize(Archive & ar, const unsigned int) {
+        ar & nb_words & words & block_offsets & postings & posting_offsets;
+    }
+
+    void clear() {
+        nb_words = 0;
+        words.clear();
+        block_offsets.clear();
+        postings.clear();
+        posting_offsets.clear();
+    }
+
+    size_t size() const { return nb_words; }
+
+    void build(const std::map<std::string, std::set<T>>& word_map) {
+        clear();
+        std::string previous;
+        for (const auto& word_elts: word_map) {
+            const std::string& word = word_elts.first;
+            size_t shared = 0;
+            if (nb_words % block_size == 0) {
+                block_offsets.push_back(words.size());
+            } else {
+                const size_t max_shared = std::min(word.size(), previous.size());
+                while (shared < max_shared && word[shared] == previous[shared]) { ++shared; }
+            }
+            write_varint(shared, words);
+            write_varint(word.size() - shared, words);
+            words.insert(words.end(), word.begin() + shared, word.end());
+            previous = word;
+
+            posting_offsets.push_back(postings.size());
+            T last = 0;
+            for (const auto elt: word_elts.second) {
+                write_varint(elt - last, postings);
+                last = elt;
+            }
+            ++nb_words;
+        }
+        posting_offsets.push_back(postings.size());
+        words.shrink_to_fit();
+        postings.shrink_to_fit();
+    }
+
+    /// the word at the given position, mostly for debug purpose
+    std::string word(size_t word_idx) const {
+        const uint8_t* it = words.data() + block_offsets[word_idx / block_size];
+        std::string res;
+        for (size_t i = word_idx - word_idx % block_size; i <= word_idx; ++i) {
+            read_word(it, res);
+        }
+        return res;
+    }
+
+    /// position of the first word not lesser than str
+    size_t lower_bound(const std::string& str) const {
+        // first block whose first word is not lesser than str
+        size_t lo = 0, hi = block_offsets.size();
+        std::string word;
+        while (lo < hi) {
+            const size_t mid = lo + (hi - lo) / 2;
+            const uint8_t* it = words.data() + block_offsets[mid];
+            read_word(it, word);
+            if (word < str) {
+                lo = mid + 1;
+            } else {
+                hi = mid;
+            }
+        }
+        if (lo == 0) { return 0; }
+
+        // the first word of the previous block is lesser than str, the word
+        // we look for is thus in this block, or is the first of the next one
+        const uint8_t* it = words.data() + block_offsets[lo - 1];
+        size_t word_idx = (lo - 1) * block_size;
+        const size_t end = std::min<size_t>(word_idx + block_size, nb_words);
+        for (; word_idx < end; ++word_idx) {
+            read_word(it, word);
+            if (! (word < str)) { break; }
+        }
+        return word_idx;
+    }
+
+    /// range [first, last[ of the positions of the words beginning with prefix
+    std::pair<size_t, size_t> prefix_range(const std::string& prefix) const {
+        const size_t first = lower_bound(prefix);
+
+        // the smallest string greater than every word beginning with prefix
+        std::string next = prefix;
+        while (! next.empty() && uint8_t(next.back()) == 0xFF) { next.pop_back(); }
+        if (next.empty()) { return {first, nb_words}; }
+        next.back() = char(uint8_t(next.back()) + 1);
+        return {first, lower_bound(next)};
+    }
+
+    /// append the sorted elements of the word at the given position
+    void append_elements(size_t word_idx, std::vector<T>& res) const {
+        const uint8_t* it = postings.data() + posting_offsets[word_idx];
+        const uint8_t* end = postings.data() + posting_offsets[word_idx + 1];
+        T value = 0;
+        while (it != end) {
+            value += T(read_varint(it));
+            res.push_back(value);
+        }
+    }
+
+    /// replace each element by f(element), keeping the elements of each word sorted
+    template<typename F>
+    void transform(const F& f) {
+        if (posting_offsets.empty()) { return; }
+        std::vector<uint8_t> new_postings;
+        new_postings.reserve(postings.size());
+        std::vector<T> elements;
+        for (size_t word_idx = 0; word_idx < nb_words; ++word_idx) {
+            elements.clear();
+            append_elements(word_idx, elements);
+            for (auto& elt: elements) { elt = f(elt); }
+            std::sort(elements.begin(), elements.end());
+
+            posting_offsets[word_idx] = new_postings.size();
+            T last = 0;
+            for (const auto elt: elements) {
+                write_varint(elt - last, new_postings);
+                last = elt;
+            }
+        }
+        posting_offsets.back() = new_postings.size();
+        new_postings.shrink_to_fit();
+        postings = std::move(new_postings);
+    }
+
+private:
+    static void write_varint(uint64_t value, std::vector<uint8_t>& out) {
+        while (value >= 0x80) {
+            out.push_back(uint8_t(value) | 0x80);
+            value >>= 7;
+        }
+        out.push_back(uint8_t(value));
+    }
+
+    static uint64_t read_varint(const uint8_t*& it) {
+        uint64_t value = 0;
+        for (int shift = 0; ; shift += 7) {
+            const uint8_t byte = *it++;
+            value |= uint64_t(byte & 0x7F) << shift;
+            if (byte < 0x80) { return value; }
+        }
+    }
+
+    /// read the word at it, word containing the previous word of the block
+    static void read_word(const uint8_t*& it, std::string& word) {
+        const size_t shared = read_varint(it);
+        const size_t len = read_varint(it);
+        word.resize(shared);
+        word.append(reinterpret_cast<const char*>(it), len);
+        it += len;
+    }
+};
+
+template<class T>
+constexpr uint32_t PrefixIndex<T>::block_size;
+
+/** Intersection of 2 sorted vectors without duplicates
+  *
+  * Each element of the smallest vector is searched in the other one by
+  * galloping: the searched range is doubled from the last position found
+  * until it contains the element, and is then binary searched.
+  */
+template<class T>
+std::vector<T> galloping_intersection(const std::vector<T>& vec1, const std::vector<T>& vec2) {
+    const auto& small = vec1.size() <= vec2.size() ? vec1 : vec2;
+    const auto& large = vec1.size() <= vec2.size() ? vec2 : vec1;
+    std::vector<T> res;
+    size_t lo = 0;
+    for (const auto& elt: small) {
+        // every element before lo is lesser than elt
+        size_t hi = lo;
+        size_t step = 1;
+        while (hi < large.size() && large[hi] < elt) {
+            lo = hi + 1;
+            hi += step;
+            step *= 2;
+        }
+        hi = std::min(hi, large.size());
+        lo = std::lower_bound(large.begin() + lo, large.begin() + hi, elt) - large.begin();
+        if (lo == large.size()) { break; }
+        if (large[lo] == elt) {
+            res.push_back(elt);
+            ++lo;
+        }
+    }
+    return res;
+}
+
+}} // namespace navitia::autocomplete
@@ -33,6 +33,7 @@ www.navitia.io
 
 #include "autocomplete/autocomplete.h"
 #include "autocomplete/autocomplete_api.h"
+#include "autocomplete/autocomplete_cache.h"
 #include "type/data.h"
 #include <boost/test/unit_test.hpp>
 #include <vector>
@@ -1941,3 +1942,194 @@ BOOST_AUTO_TEST_CASE(longuest_substring_test_2) {
     BOOST_CHECK_EQUAL(res.first, std::string("ligne").size());
     BOOST_CHECK_EQUAL(res.second, 10); // position of the end of 'ligne' in str2
 }
+
+BOOST_AUTO_TEST_CASE(prefix_index_test) {
+    std::map<std::string, std::set<unsigned int>> word_map;
+    for (unsigned int i = 0; i < 100; ++i) {
+        // enough words for several blocks
+        word_map["rue" + std::to_string(i)].insert({i, i + 1000, i + 100000});
+    }
+    word_map["ru"] = {7};
+    word_map["avenue"] = {3, 5};
+    word_map["r"] = {};
+
+    PrefixIndex<unsigned int> index;
+    index.build(word_map);
+    BOOST_REQUIRE_EQUAL(index.size(), word_map.size());
+    size_t i = 0;
+    for (const auto& word_elts: word_map) {
+        BOOST_CHECK_EQUAL(index.word(i), word_elts.first);
+        std::vector<unsigned int> elts;
+        index.append_elements(i, elts);
+        BOOST_CHECK_EQUAL_COLLECTIONS(elts.begin(), elts.end(),
+                                      word_elts.second.begin(), word_elts.second.end());
+        ++i;
+    }
+
+    auto range = index.prefix_range("av");
+    BOOST_CHECK_EQUAL(range.second - range.first, 1);
+    BOOST_CHECK_EQUAL(index.word(range.first), "avenue");
+    range = index.prefix_range("rue1");
+    BOOST_CHECK_EQUAL(range.second - range.first, 11);
+    range = index.prefix_range("r");
+    BOOST_CHECK_EQUAL(range.second - range.first, 102);
+    range = index.prefix_range("");
+    BOOST_CHECK_EQUAL(range.second - range.first, word_map.size());
+    range = index.prefix_range("rues");
+    BOOST_CHECK_EQUAL(range.first, range.second);
+    range = index.prefix_range("b");
+    BOOST_CHECK_EQUAL(range.first, range.second);
+}
+
+BOOST_AUTO_TEST_CASE(galloping_intersection_test) {
+    std::vector<unsigned int> small = {3, 50, 51, 999, 2000};
+    std::vector<unsigned int> large;
+    for (unsigned int i = 0; i < 1000; i += 3) { large.push_back(i); }
+    std::vector<unsigned int> expected = {3, 51, 999};
+    auto res = galloping_intersection(small, large);
+    BOOST_CHECK_EQUAL_COLLECTIONS(res.begin(), res.end(), expected.begin(), expected.end());
+    res = galloping_intersection(large, small);
+    BOOST_CHECK_EQUAL_COLLECTIONS(res.begin(), res.end(), expected.begin(), expected.end());
+    BOOST_CHECK(galloping_intersection(small, std::vector<unsigned int>()).empty());
+}
+
+BOOST_AUTO_TEST_CASE(ranked_by_score_test) {
+    autocomplete_map synonyms;
+    std::set<std::string> ghostwords;
+    Autocomplete<unsigned int> ac;
+    ac.add_string("rue jean jaures", 0, ghostwords, synonyms);
+    ac.add_string("place jean jaures", 1, ghostwords, synonyms);
+    ac.add_string("rue jeanne d'arc", 2, ghostwords, synonyms);
+    ac.add_string("avenue jean jaures", 3, ghostwords, synonyms);
+    ac.add_string("rue jean moulin", 4, ghostwords, synonyms);
+    ac.add_string("boulevard poniatowski", 5, ghostwords, synonyms);
+    ac.build();
+    ac.word_quality_list.at(0).score = 10;
+    ac.word_quality_list.at(1).score = 50;
+    ac.word_quality_list.at(2).score = 30;
+    ac.word_quality_list.at(3).score = 40;
+    ac.word_quality_list.at(4).score = 30;
+
+    const auto keep_all = [](unsigned int) { return true; };
+    const auto unranked = ac.find_complete("jean", 3, keep_all, ghostwords);
+    ac.rank_by_score();
+    BOOST_CHECK_EQUAL(ac.ranked_elements.size(), 6);
+    BOOST_CHECK_EQUAL(ac.ranked_elements.front(), 1);
+
+    // find still gives the sorted elements
+    auto res = ac.find({"r", "jean"});
+    std::vector<unsigned int> expected = {0, 2, 4};
+    BOOST_CHECK_EQUAL_COLLECTIONS(res.begin(), res.end(), expected.begin(), expected.end());
+
+    // the search stops once the best scores are found, with the same result
+    const auto ranked = ac.find_complete("jean", 3, keep_all, ghostwords);
+    BOOST_REQUIRE_EQUAL(ranked.size(), 3);
+    BOOST_REQUIRE_EQUAL(unranked.size(), 3);
+    for (size_t i = 0; i < 2; ++i) {
+        BOOST_CHECK_EQUAL(ranked[i].idx, unranked[i].idx);
+    }
+    BOOST_CHECK_EQUAL(ranked[0].idx, 1);
+    BOOST_CHECK_EQUAL(ranked[1].idx, 3);
+    // 2 and 4 have the same scores
+    BOOST_CHECK(ranked[2].idx == 2 || ranked[2].idx == 4);
+
+    // ranking again after a change of the scores
+    ac.word_quality_list.at(0).score = 100;
+    ac.rank_by_score();
+    const auto reranked = ac.find_complete("jean", 1, keep_all, ghostwords);
+    BOOST_REQUIRE_EQUAL(reranked.size(), 1);
+    BOOST_CHECK_EQUAL(reranked[0].idx, 0);
+}
+
+BOOST_AUTO_TEST_CASE(autocomplete_cache_test) {
+    autocomplete_map synonyms;
+    std::set<std::string> ghostwords;
+    Autocomplete<unsigned int> ac;
+    ac.add_string("rue jean jaures", 0, ghostwords, synonyms);
+    ac.add_string("place jean jaures", 1, ghostwords, synonyms);
+    ac.add_string("rue jeanne d'arc", 2, ghostwords, synonyms);
+    ac.add_string("avenue jean jaures", 3, ghostwords, synonyms);
+    ac.add_string("rue jean moulin", 4, ghostwords, synonyms);
+    ac.add_string("boulevard poniatowski", 5, ghostwords, synonyms);
+    ac.build();
+
+    // a single autocomplete, thus a single shard of 12 ids, keeping the lists of at most 3 ids
+    AutocompleteCache<unsigned int> cache(8 * 12);
+    const auto keep_all = [](unsigned int) { return true; };
+    const auto check_same_result = [&](const std::string& query) {
+        const auto expected = ac.find_complete(query, 10, keep_all, ghostwords);
+        const auto res = ac.find_complete(query, 10, keep_all, ghostwords, &cache);
+        BOOST_REQUIRE_EQUAL(res.size(), expected.size());
+        for (size_t i = 0; i < res.size(); ++i) {
+            BOOST_CHECK_EQUAL(res[i].idx, expected[i].idx);
+        }
+    };
+
+    // the users type one character after the other
+    check_same_result("r");
+    check_same_result("ru");
+    check_same_result("rue j");
+    check_same_result("rue jean m");
+    BOOST_CHECK_EQUAL(cache.get_nb_calls(), 4);
+    BOOST_CHECK_EQUAL(cache.get_nb_hits(), 0);
+    BOOST_CHECK_EQUAL(cache.get_nb_refined(), 3);
+    BOOST_CHECK_EQUAL(cache.get_nb_ids(), 3 + 3 + 3 + 1);
+
+    check_same_result("rue jean m");
+    BOOST_CHECK_EQUAL(cache.get_nb_hits(), 1);
+
+    // "j" is found in 5 elements, too many to be kept
+    check_same_result("j");
+    check_same_result("j");
+    BOOST_CHECK_EQUAL(cache.get_nb_hits(), 1);
+    BOOST_CHECK_EQUAL(cache.get_nb_ids(), 10);
+
+    // "b" and "a" go over the 12 ids, "r" is evicted
+    check_same_result("b");
+    check_same_result("a");
+    BOOST_CHECK_LE(cache.get_nb_ids(), 12);
+    check_same_result("r");
+    BOOST_CHECK_EQUAL(cache.get_nb_hits(), 1);
+    BOOST_CHECK_EQUAL(cache.get_nb_refined(), 3);
+
+    // the ids are not kept after a clear
+    cache.clear();
+    BOOST_CHECK_EQUAL(cache.get_nb_ids(), 0);
+    check_same_result("r");
+    BOOST_CHECK_EQUAL(cache.get_nb_calls(), 11);
+    BOOST_CHECK_EQUAL(cache.get_nb_hits(), 1);
+    BOOST_CHECK_EQUAL(cache.get_nb_refined(), 3);
+}
+
+// the autocompletes are on different shards, they do not evict the ids of each other
+BOOST_AUTO_TEST_CASE(autocomplete_cache_shards_test) {
+    autocomplete_map synonyms;
+    std::set<std::string> ghostwords;
+    Autocomplete<unsigned int> stop_area_ac;
+    Autocomplete<unsigned int> way_ac;
+    for (auto* ac: {&stop_area_ac, &way_ac}) {
+        ac->add_string("rue jean jaures", 0, ghostwords, synonyms);
+        ac->add_string("place jean jaures", 1, ghostwords, synonyms);
+        ac->add_string("rue jeanne d'arc", 2, ghostwords, synonyms);
+        ac->add_string("avenue jean jaures", 3, ghostwords, synonyms);
+        ac->add_string("rue jean moulin", 4, ghostwords, synonyms);
+        ac->add_string("boulevard poniatowski", 5, ghostwords, synonyms);
+        ac->build();
+    }
+
+    AutocompleteCache<unsigned int> cache(8 * 12);
+    const auto keep_all = [](unsigned int) { return true; };
+    stop_area_ac.find_complete("r", 10, keep_all, ghostwords, &cache);
+    stop_area_ac.find_complete("rue j", 10, keep_all, ghostwords, &cache);
+    BOOST_CHECK_EQUAL(cache.get_nb_ids(), 3 + 3);
+
+    // enough ids on the way autocomplete to fill a shard
+    for (const auto& query: {"r", "ru", "rue j", "rue jean m", "b", "a", "p"}) {
+        way_ac.find_complete(query, 10, keep_all, ghostwords, &cache);
+    }
+    BOOST_CHECK_EQUAL(cache.get_nb_hits(), 0);
+
+    stop_area_ac.find_complete("r", 10, keep_all, ghostwords, &cache);
+    stop_area_ac.find_complete("rue j", 10, keep_all, ghostwords, &cache);
+    BOOST_CHECK_EQUAL(cache.get_nb_hits(), 2);
+}
@@ -36,7 +36,6 @@ www.navitia.io
 #include "utils/exception.h"
 #include <boost/geometry.hpp>
 #include <boost/geometry/geometry.hpp>
-#include <boost/range/algorithm/find_if.hpp>
 #include "type/datetime.h"
 #include <boost/range/algorithm/max_element.hpp>
 
@@ -52,6 +51,9 @@ void Data::sort(){
 
     std::for_each(shapes_from_prev.begin(), shapes_from_prev.end(), Indexer<nt::idx_t>());
     std::sort(stops.begin(), stops.end(), Less());
+
+    validity_patterns_by_days.clear();
+    nb_indexed_validity_patterns = 0;
 }
 
 void Data::add_feed_info(const std::string& key, const std::string& value){
@@ -153,17 +155,18 @@ make_stop_area_stop_points_map(const std::vector<ed::types::StopPoint*>& stop_po
 
 
 types::ValidityPattern* Data::get_or_create_validity_pattern(const types::ValidityPattern& vp) {
-    auto find_vp_predicate = [&vp](types::ValidityPattern* vp2) {
-        return vp.days == vp2->days;
-    };
-    auto it = boost::find_if(validity_patterns,
-            find_vp_predicate);
-    if(it != validity_patterns.end()) {
-        return *(it);
-    } else {
-         validity_patterns.push_back(new types::ValidityPattern(vp));
-         return validity_patterns.back();
-    }
+    for (; nb_indexed_validity_patterns < validity_patterns.size(); ++nb_indexed_validity_patterns) {
+        auto* vp2 = validity_patterns[nb_indexed_validity_patterns];
+        validity_patterns_by_days.emplace(vp2->days, vp2);
+    }
+    auto it = validity_patterns_by_days.find(vp.days);
+    if(it != validity_patterns_by_days.end()) {
+        return it->second;
+    }
+    validity_patterns.push_back(new types::ValidityPattern(vp));
+    validity_patterns_by_days.emplace(vp.days, validity_patterns.back());
+    ++nb_indexed_validity_patterns;
+    return validity_patterns.back();
 }
 
 // Please not that VP is not in the list of validity_patterns
@@ -184,6 +187,9 @@ void Data::shift_vp_left(types::ValidityPattern& vp) {
             vp_->days <<= 1;
             vp_->beginning_date = begin_date;
         }
+        // every pattern has been shifted, they must be indexed again
+        validity_patterns_by_days.clear();
+        nb_indexed_validity_patterns = 0;
         vp.beginning_date = begin_date;
         vp.days <<= 1;
 
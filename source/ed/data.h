@@ -163,6 +163,12 @@ public:
         //we don't want stoptime to derive from Header so we use a custom container
     std::map<const ed::types::StopTime*, std::vector<std::string>> stoptime_comments;
 
+    // validity patterns by days, for get_or_create_validity_pattern. The
+    // patterns pushed in validity_patterns are indexed lazily from
+    // nb_indexed_validity_patterns, thus they must not be modified once indexed
+    std::unordered_map<types::ValidityPattern::year_bitset, types::ValidityPattern*> validity_patterns_by_days;
+    size_t nb_indexed_validity_patterns = 0;
+
     size_t count_too_long_connections = 0,
            count_empty_connections = 0;
 
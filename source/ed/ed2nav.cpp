@@ -37,6 +37,7 @@ www.navitia.io
 #include "utils/init.h"
 #include "utils/functions.h"
 #include "type/meta_data.h"
+#include "georef/street_network.h"
 
 #include <boost/date_time/posix_time/posix_time.hpp>
 #include <boost/program_options.hpp>
@@ -163,6 +164,7 @@ int main(int argc, char * argv[])
     auto logger = log4cplus::Logger::getInstance("log");
     std::string output, connection_string, region_name, cities_connection_string;
     double min_non_connected_graph_ratio;
+    std::vector<std::string> ch_modes;
     po::options_description desc("Allowed options");
     desc.add_options()
         ("help,h", "Show this message")
@@ -178,6 +180,9 @@ int main(int argc, char * argv[])
         ("full_street_network_geometries", "If true export street network geometries allowing kraken to return accurate"
          "geojson for street network sections. Also improve projections accuracy. "
          "WARNING : memory intensive. The lz4 can more than double in size and kraken will consume significantly more memory.")
+        ("contraction_hierarchies", po::value<std::vector<std::string>>(&ch_modes)->multitoken(),
+         "Modes (walking, bike, car, bss) for which the contraction hierarchy of the street network is built, "
+         "used by kraken for the direct paths. It takes time and memory on big coverages.")
         ("connection-string", po::value<std::string>(&connection_string)->required(),
          "database connection parameters: host=localhost user=navitia dbname=navitia password=navitia")
         ("cities-connection-string", po::value<std::string>(&cities_connection_string)->default_value(""),
@@ -237,6 +242,18 @@ int main(int argc, char * argv[])
 
     read = (pt::microsec_clock::local_time() - start).total_milliseconds();
     data.complete();
+    if (! ch_modes.empty()) {
+        std::vector<navitia::type::Mode_e> modes;
+        for (const auto& mode: ch_modes) {
+            try {
+                modes.push_back(navitia::type::static_data::get()->modeByCaption(mode));
+            } catch (const std::out_of_range&) {
+                throw navitia::exception("unknown mode for the contraction hierarchies: " + mode);
+            }
+        }
+        Timer t("building of the contraction hierarchies");
+        navitia::georef::build_contraction_hierarchies(*data.geo_ref, modes);
+    }
     data.meta->publication_date = pt::microsec_clock::local_time();
 
     LOG4CPLUS_INFO(logger, "line: " << data.pt_data->lines.size());
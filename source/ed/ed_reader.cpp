@@ -201,7 +201,7 @@ void EdReader::fill_admin_stop_areas(navitia::type::Data&, pqxx::work& work) {
 
         navitia::type::StopArea* sa = it_sa->second;
 
-        admin->main_stop_areas.push_back(sa);
+        admin->main_stop_areas.push_back(sa->idx);
         nb_valid_admin++;
     }
     LOG4CPLUS_INFO(log, nb_valid_admin << " admin with at least one main stop");
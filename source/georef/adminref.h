@@ -64,10 +64,13 @@ namespace navitia {
             nt::GeographicalCoord coord;
             polygon_type boundary;
             std::vector<const Admin*> admin_list;
-            std::vector<const nt::StopArea*> main_stop_areas;
+            // The admins are shared between the Data snapshots built by realtime
+            // (see Data::clone_from), so we only keep the idx of the pt objects,
+            // they have to be resolved with the pt_data of the current Data
+            std::vector<nt::idx_t> main_stop_areas;
 
             // TODO ODT NTFSv0.3: remove that when we stop to support NTFSv0.1
-            std::vector<const nt::StopPoint*> odt_stop_points; // zone odt stop points for the admin
+            std::vector<nt::idx_t> odt_stop_points; // idx of the zone odt stop points for the admin
             std::vector<std::string> postal_codes;
 
             Admin():level(-1){}
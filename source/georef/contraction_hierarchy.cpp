@@ -0,0 +1,432 @@
+/* Copyright © 2001-2014, Canal TP and/or its affiliates. All rights reserved.
+  
+This file is part of Navitia,
+    the software to build cool stuff with public transport.
+ 
+Hope you'll enjoy and contribute to this project,
+    powered by Canal TP (www.canaltp.fr).
+Help us simplify mobility and open public transport:
+    a non ending quest to the responsive locomotion way of traveling!
+  
+LICENCE: This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU Affero General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+   
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU Affero General Public License for more details.
+   
+You should have received a copy of the GNU Affero General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+  
+Stay tuned using
+twitter @navitia 
+IRC #navitia on freenode
+https://groups.google.com/d/forum/navitia
+www.navitia.io
+*/
+
+#include "contraction_hierarchy.h"
+#include "utils/exception.h"
+#include <algorithm>
+#include <functional>
+#include <queue>
+#include <tuple>
+
+namespace navitia { namespace georef {
+
+constexpr uint32_t ContractionHierarchy::no_vertex;
+
+namespace {
+
+template<typename T>
+using min_heap = std::priority_queue<std::pair<T, uint32_t>,
+                                     std::vector<std::pair<T, uint32_t>>,
+                                     std::greater<std::pair<T, uint32_t>>>;
+
+// add the arc to vertex, or shorten it if it already exists
+void add_arc(std::vector<ChEdge>& arcs, const uint32_t vertex, const uint32_t duration, const uint32_t middle) {
+    for (auto& arc: arcs) {
+        if (arc.vertex != vertex) { continue; }
+        if (duration < arc.duration) {
+            arc.duration = duration;
+            arc.middle = middle;
+        }
+        return;
+    }
+    arcs.emplace_back(vertex, duration, middle);
+}
+
+void remove_arc(std::vector<ChEdge>& arcs, const uint32_t vertex) {
+    arcs.erase(std::remove_if(arcs.begin(), arcs.end(), [&](const ChEdge& arc) { return arc.vertex == vertex; }),
+               arcs.end());
+}
+
+/*
+ * Contract the vertices of the graph, the not contracted part of the
+ * graph being kept in adjacency lists.
+ */
+struct Contractor {
+    // a witness search giving up after this number of settled vertices
+    // only adds a useless shortcut
+    static constexpr size_t max_settled = 500;
+    static constexpr uint64_t inf = std::numeric_limits<uint64_t>::max();
+
+    std::vector<std::vector<ChEdge>> out;
+    std::vector<std::vector<ChEdge>> in;
+    std::vector<bool> contracted;
+    std::vector<uint32_t> nb_contracted_neighbors;
+    std::vector<uint32_t> levels;
+
+    // witness search
+    std::vector<uint64_t> durations;
+    std::vector<uint32_t> visited;
+    std::vector<std::pair<uint64_t, uint32_t>> heap;
+    std::vector<bool> is_target;
+    std::vector<ChArc> shortcuts;
+
+    Contractor(const size_t nb_vertices, const std::vector<ChArc>& arcs):
+        out(nb_vertices), in(nb_vertices), contracted(nb_vertices, false),
+        nb_contracted_neighbors(nb_vertices, 0), levels(nb_vertices, 0), durations(nb_vertices, inf), is_target(nb_vertices, false) {
+        for (const auto& arc: arcs) {
+            if (arc.source == arc.target) { continue; }
+            add_arc(out[arc.source], arc.target, arc.duration, ContractionHierarchy::no_vertex);
+            add_arc(in[arc.target], arc.source, arc.duration, ContractionHierarchy::no_vertex);
+        }
+    }
+
+    // dijkstra from source on the not contracted vertices without going through avoided,
+    // stopped once the targets are settled
+    void witness_search(const uint32_t source, const uint32_t avoided,
+                        const uint64_t max_duration, size_t nb_targets) {
+        for (const auto v: visited) { durations[v] = inf; }
+        visited.clear();
+        heap.clear();
+        durations[source] = 0;
+        visited.push_back(source);
+        heap.push_back({0, source});
+        size_t nb_settled = 0;
+        while (! heap.empty()) {
+            std::pop_heap(heap.begin(), heap.end(), std::greater<std::pair<uint64_t, uint32_t>>());
+            const auto top = heap.back();
+            heap.pop_back();
+            if (top.first > durations[top.second]) { continue; }
+            if (top.first > max_duration || ++nb_settled > max_settled) { break; }
+            if (is_target[top.second] && --nb_targets == 0) { break; }
+            for (const auto& arc: out[top.second]) {
+                if (arc.vertex == avoided) { continue; }
+                const uint64_t duration = top.first + arc.duration;
+                if (duration >= durations[arc.vertex]) { continue; }
+                if (durations[arc.vertex] == inf) { visited.push_back(arc.vertex); }
+                durations[arc.vertex] = duration;
+                heap.push_back({duration, arc.vertex});
+                std::push_heap(heap.begin(), heap.end(), std::greater<std::pair<uint64_t, uint32_t>>());
+            }
+        }
+    }
+
+    // fill shortcuts with the ones needed to contract v
+    void compute_shortcuts(const uint32_t v) {
+        shortcuts.clear();
+        for (const auto& out_arc: out[v]) { is_target[out_arc.vertex] = true; }
+        for (const auto& in_arc: in[v]) {
+            uint64_t max_duration = 0;
+            size_t nb_targets = 0;
+            for (const auto& out_arc: out[v]) {
+                if (out_arc.vertex == in_arc.vertex) { continue; }
+                max_duration = std::max<uint64_t>(max_duration, uint64_t(in_arc.duration) + out_arc.duration);
+                ++nb_targets;
+            }
+            if (nb_targets == 0) { continue; }
+            // the source is settled first, it must not count as a target
+            witness_search(in_arc.vertex, v, max_duration, nb_targets + (is_target[in_arc.vertex] ? 1 : 0));
+            for (const auto& out_arc: out[v]) {
+                if (out_arc.vertex == in_arc.vertex) { continue; }
+                const uint64_t duration = uint64_t(in_arc.duration) + out_arc.duration;
+                if (durations[out_arc.vertex] <= duration) { continue; }
+                const auto capped = uint32_t(std::min<uint64_t>(duration, std::numeric_limits<uint32_t>::max()));
+                shortcuts.push_back({in_arc.vertex, out_arc.vertex, capped});
+            }
+        }
+        for (const auto& out_arc: out[v]) { is_target[out_arc.vertex] = false; }
+    }
+
+    // edge difference, plus the contracted neighbors and the level to contract uniformly
+    int64_t priority(const uint32_t v) {
+        compute_shortcuts(v);
+        return 2 * (int64_t(shortcuts.size()) - int64_t(in[v].size() + out[v].size()))
+            + int64_t(nb_contracted_neighbors[v]) + int64_t(levels[v]);
+    }
+
+    // the remaining arcs of v lead to higher ranked vertices and are moved to up and down
+    void contract(const uint32_t v, std::vector<ChEdge>& up, std::vector<ChEdge>& down) {
+        compute_shortcuts(v);
+        for (const auto& shortcut: shortcuts) {
+            add_arc(out[shortcut.source], shortcut.target, shortcut.duration, v);
+            add_arc(in[shortcut.target], shortcut.source, shortcut.duration, v);
+        }
+        for (const auto& arc: out[v]) {
+            remove_arc(in[arc.vertex], v);
+            ++nb_contracted_neighbors[arc.vertex];
+            levels[arc.vertex] = std::max(levels[arc.vertex], levels[v] + 1);
+        }
+        for (const auto& arc: in[v]) {
+            remove_arc(out[arc.vertex], v);
+            ++nb_contracted_neighbors[arc.vertex];
+            levels[arc.vertex] = std::max(levels[arc.vertex], levels[v] + 1);
+        }
+        contracted[v] = true;
+        up.swap(out[v]);
+        down.swap(in[v]);
+    }
+};
+
+constexpr size_t Contractor::max_settled;
+constexpr uint64_t Contractor::inf;
+
+void fill_csr(const std::vector<std::vector<ChEdge>>& lists,
+              std::vector<uint32_t>& first,
+              std::vector<ChEdge>& edges) {
+    first.clear();
+    edges.clear();
+    first.reserve(lists.size() + 1);
+    for (const auto& list: lists) {
+        first.push_back(edges.size());
+        edges.insert(edges.end(), list.begin(), list.end());
+    }
+    first.push_back(edges.size());
+}
+
+}
+
+void ContractionHierarchy::build(const size_t nb_vertices, const std::vector<ChArc>& arcs) {
+    if (nb_vertices >= no_vertex) {
+        throw navitia::exception("too many vertices for a contraction hierarchy");
+    }
+    Contractor contractor(nb_vertices, arcs);
+    std::vector<std::vector<ChEdge>> up(nb_vertices);
+    std::vector<std::vector<ChEdge>> down(nb_vertices);
+
+    // lazy updates: a vertex is contracted only if its priority is still
+    // the lowest once recomputed. The neighbors are not updated after each
+    // contraction, it is far longer for the same hierarchy on street networks
+    std::vector<int64_t> priorities(nb_vertices, 0);
+    min_heap<int64_t> heap;
+    for (uint32_t v = 0; v < nb_vertices; ++v) {
+        if (contractor.out[v].empty() && contractor.in[v].empty()) { continue; }
+        priorities[v] = contractor.priority(v);
+        heap.push({priorities[v], v});
+    }
+    while (! heap.empty()) {
+        const auto top = heap.top();
+        heap.pop();
+        const auto v = top.second;
+        if (contractor.contracted[v] || top.first != priorities[v]) { continue; }
+        priorities[v] = contractor.priority(v);
+        if (! heap.empty() && priorities[v] > heap.top().first) {
+            heap.push({priorities[v], v});
+            continue;
+        }
+        contractor.contract(v, up[v], down[v]);
+    }
+
+    fill_csr(up, up_first, up_edges);
+    fill_csr(down, down_first, down_edges);
+}
+
+const ChEdge& ContractionHierarchy::find_up_edge(const uint32_t source, const uint32_t target) const {
+    for (auto i = up_first[source]; i < up_first[source + 1]; ++i) {
+        if (up_edges[i].vertex == target) { return up_edges[i]; }
+    }
+    throw navitia::exception("invalid shortcut in the contraction hierarchy");
+}
+
+const ChEdge& ContractionHierarchy::find_down_edge(const uint32_t source, const uint32_t target) const {
+    for (auto i = down_first[target]; i < down_first[target + 1]; ++i) {
+        if (down_edges[i].vertex == source) { return down_edges[i]; }
+    }
+    throw navitia::exception("invalid shortcut in the contraction hierarchy");
+}
+
+void ContractionHierarchy::unpack(const uint32_t source,
+                                  const uint32_t target,
+                                  const uint32_t middle,
+                                  std::vector<uint32_t>& path) const {
+    // a shortcut source->target is made of the edges source->middle
+    // (down edge of the middle) and middle->target (up edge of the middle)
+    std::vector<std::tuple<uint32_t, uint32_t, uint32_t>> stack{std::make_tuple(source, target, middle)};
+    while (! stack.empty()) {
+        uint32_t from, to, mid;
+        std::tie(from, to, mid) = stack.back();
+        stack.pop_back();
+        if (mid == no_vertex) {
+            path.push_back(to);
+            continue;
+        }
+        stack.emplace_back(mid, to, find_up_edge(mid, to).middle);
+        stack.emplace_back(from, mid, find_down_edge(from, mid).middle);
+    }
+}
+
+void ContractionHierarchyQuery::Search::init(const size_t nb_vertices) {
+    if (durations.size() != nb_vertices) {
+        durations.assign(nb_vertices, std::numeric_limits<double>::infinity());
+        parents.assign(nb_vertices, ContractionHierarchy::no_vertex);
+        middles.assign(nb_vertices, ContractionHierarchy::no_vertex);
+        visited.clear();
+        return;
+    }
+    for (const auto v: visited) {
+        durations[v] = std::numeric_limits<double>::infinity();
+    }
+    visited.clear();
+}
+
+bool ContractionHierarchyQuery::Search::update(const uint32_t v,
+                                               const double duration,
+                                               const uint32_t parent,
+                                               const uint32_t middle) {
+    if (duration >= durations[v]) { return false; }
+    if (durations[v] == std::numeric_limits<double>::infinity()) { visited.push_back(v); }
+    durations[v] = duration;
+    parents[v] = parent;
+    middles[v] = middle;
+    return true;
+}
+
+template<typename OnSettle>
+void ContractionHierarchyQuery::upward_search(const ContractionHierarchy& ch,
+                                              Search& search,
+                                              const bool forward_edges,
+                                              const double speed_factor,
+                                              const double max_duration,
+                                              OnSettle on_settle) {
+    const auto& first = forward_edges ? ch.up_first : ch.down_first;
+    const auto& edges = forward_edges ? ch.up_edges : ch.down_edges;
+    min_heap<double> heap;
+    for (const auto v: search.visited) {
+        heap.push({search.durations[v], v});
+    }
+    while (! heap.empty()) {
+        const auto top = heap.top();
+        heap.pop();
+        if (top.first > search.durations[top.second]) { continue; }
+        if (top.first > max_duration || ! on_settle(top.second, top.first)) { break; }
+        for (auto i = first[top.second]; i < first[top.second + 1]; ++i) {
+            const auto& edge = edges[i];
+            const double duration = top.first + edge.duration / speed_factor;
+            if (search.update(edge.vertex, duration, top.second, edge.middle)) {
+                heap.push({duration, edge.vertex});
+            }
+        }
+    }
+}
+
+std::vector<uint32_t>
+ContractionHierarchyQuery::shortest_path(const ContractionHierarchy& ch,
+                                         const std::vector<std::pair<uint32_t, double>>& sources,
+                                         const uint32_t target,
+                                         const double speed_factor,
+                                         const double max_duration) {
+    const auto no_vertex = ContractionHierarchy::no_vertex;
+    const size_t nb_vertices = ch.nb_vertices();
+    if (target >= nb_vertices) { return {}; }
+
+    // the backward search goes up the hierarchy from the target
+    backward.init(nb_vertices);
+    backward.update(target, 0, no_vertex, no_vertex);
+    upward_search(ch, backward, false, speed_factor, max_duration, [](uint32_t, double) { return true; });
+
+    // the forward search goes up the hierarchy from the sources until it
+    // can't improve the best meeting with the backward search
+    forward.init(nb_vertices);
+    for (const auto& source: sources) {
+        if (source.first >= nb_vertices) { continue; }
+        forward.update(source.first, source.second, no_vertex, no_vertex);
+    }
+    double best = std::numeric_limits<double>::infinity();
+    uint32_t meeting = no_vertex;
+    upward_search(ch, forward, true, speed_factor, max_duration, [&](const uint32_t v, const double duration) {
+        if (duration >= best) { return false; }
+        const double total = duration + backward.durations[v];
+        if (total < best) {
+            best = total;
+            meeting = v;
+        }
+        return true;
+    });
+    if (meeting == no_vertex || best > max_duration) { return {}; }
+
+    std::vector<uint32_t> up_vertices;
+    uint32_t source = meeting;
+    for (; forward.parents[source] != no_vertex; source = forward.parents[source]) {
+        up_vertices.push_back(source);
+    }
+    std::vector<uint32_t> path{source};
+    for (auto it = up_vertices.rbegin(); it != up_vertices.rend(); ++it) {
+        ch.unpack(forward.parents[*it], *it, forward.middles[*it], path);
+    }
+    for (auto v = meeting; backward.parents[v] != no_vertex; v = backward.parents[v]) {
+        ch.unpack(v, backward.parents[v], backward.middles[v], path);
+    }
+    return path;
+}
+
+std::vector<ChBucketEntry>
+ContractionHierarchyQuery::backward_buckets(const ContractionHierarchy& ch,
+                                            const std::vector<uint32_t>& targets,
+                                            const double speed_factor,
+                                            const double max_duration) {
+    const auto no_vertex = ContractionHierarchy::no_vertex;
+    const size_t nb_vertices = ch.nb_vertices();
+    std::vector<ChBucketEntry> buckets;
+    for (uint32_t target_idx = 0; target_idx < targets.size(); ++target_idx) {
+        if (targets[target_idx] >= nb_vertices) { continue; }
+        backward.init(nb_vertices);
+        backward.update(targets[target_idx], 0, no_vertex, no_vertex);
+        upward_search(ch, backward, false, speed_factor, max_duration,
+                      [&](const uint32_t v, const double duration) {
+            buckets.push_back({v, target_idx, duration});
+            return true;
+        });
+    }
+    std::sort(buckets.begin(), buckets.end(), [](const ChBucketEntry& lhs, const ChBucketEntry& rhs) {
+        return lhs.vertex < rhs.vertex;
+    });
+    return buckets;
+}
+
+std::vector<double>
+ContractionHierarchyQuery::bucket_durations(const ContractionHierarchy& ch,
+                                            const std::vector<ChBucketEntry>& buckets,
+                                            const size_t nb_targets,
+                                            const std::vector<std::pair<uint32_t, double>>& sources,
+                                            const double speed_factor,
+                                            const double max_duration) {
+    const auto no_vertex = ContractionHierarchy::no_vertex;
+    const size_t nb_vertices = ch.nb_vertices();
+    std::vector<double> result(nb_targets, std::numeric_limits<double>::infinity());
+    forward.init(nb_vertices);
+    for (const auto& source: sources) {
+        if (source.first >= nb_vertices) { continue; }
+        forward.update(source.first, source.second, no_vertex, no_vertex);
+    }
+    // every settled vertex meets the backward searches that went through it
+    upward_search(ch, forward, true, speed_factor, max_duration, [&](const uint32_t v, const double duration) {
+        auto it = std::lower_bound(buckets.begin(), buckets.end(), v, [](const ChBucketEntry& entry, uint32_t vertex) {
+            return entry.vertex < vertex;
+        });
+        for (; it != buckets.end() && it->vertex == v; ++it) {
+            result[it->target] = std::min(result[it->target], duration + it->duration);
+        }
+        return true;
+    });
+    for (auto& duration: result) {
+        if (duration > max_duration) { duration = std::numeric_limits<double>::infinity(); }
+    }
+    return result;
+}
+
+}} //namespace navitia::georef
@@ -0,0 +1,178 @@
+/* Copyright © 2001-2014, Canal TP and/or its affiliates. All rights reserved.
+  
+This file is part of Navitia,
+    the software to build cool stuff with public transport.
+ 
+Hope you'll enjoy and contribute to this project,
+    powered by Canal TP (www.canaltp.fr).
+Help us simplify mobility and open public transport:
+    a non ending quest to the responsive locomotion way of traveling!
+  
+LICENCE: This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU Affero General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+   
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU Affero General Public License for more details.
+   
+You should have received a copy of the GNU Affero General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+  
+Stay tuned using
+twitter @navitia 
+IRC #navitia on freenode
+https://groups.google.com/d/forum/navitia
+www.navitia.io
+*/
+
+#pragma once
+#include <boost/serialization/serialization.hpp>
+#include <boost/serialization/vector.hpp>
+#include <cstdint>
+#include <limits>
+#include <utility>
+#include <vector>
+
+namespace navitia { namespace georef {
+
+/** Arc of the street network graph given to the contraction */
+struct ChArc {
+    uint32_t source;
+    uint32_t target;
+    uint32_t duration; //< in ticks of navitia::time_duration
+};
+
+/** Edge of a contraction hierarchy
+ *
+ * It is either an edge of the graph or a shortcut replacing the 2 edges
+ * going through the middle vertex, contracted before both ends.
+ */
+struct ChEdge {
+    uint32_t vertex = 0; //< the other end of the edge
+    uint32_t duration = 0; //< in ticks of navitia::time_duration
+    uint32_t middle = 0; //< contracted vertex of a shortcut, no_vertex for an edge of the graph
+
+    ChEdge() {}
+    ChEdge(uint32_t v, uint32_t d, uint32_t m): vertex(v), duration(d), middle(m) {}
+
+    template<class Archive> void serialize(Archive& ar, const unsigned int) {
+        ar & vertex & duration & middle;
+    }
+};
+
+/** Contraction hierarchy of the street network graph of a transportation mode
+ *
+ * The vertices are contracted one by one, the least important first,
+ * adding shortcuts between their neighbors when no other path (witness)
+ * is as short. A shortest path can then be found by two searches only
+ * going up in the hierarchy, settling a few hundred vertices where a
+ * dijkstra settles the whole region.
+ *
+ * The vertices are the ones of GeoRef::graph, the ones out of the mode
+ * layers have no edge.
+ */
+struct ContractionHierarchy {
+    static constexpr uint32_t no_vertex = std::numeric_limits<uint32_t>::max();
+
+    /// Edges to higher ranked vertices, by source
+    std::vector<uint32_t> up_first;
+    std::vector<ChEdge> up_edges;
+    /// Edges from higher ranked vertices, by target (ChEdge::vertex is the source)
+    std::vector<uint32_t> down_first;
+    std::vector<ChEdge> down_edges;
+
+    bool empty() const { return up_first.empty(); }
+    size_t nb_vertices() const { return empty() ? 0 : up_first.size() - 1; }
+
+    /// Contract the graph of nb_vertices vertices made of the arcs
+    void build(size_t nb_vertices, const std::vector<ChArc>& arcs);
+
+    /// Append to path the vertices of the graph replaced by the edge
+    /// from source (excluded) to target (included)
+    void unpack(uint32_t source, uint32_t target, uint32_t middle, std::vector<uint32_t>& path) const;
+
+    template<class Archive> void serialize(Archive& ar, const unsigned int) {
+        ar & up_first & up_edges & down_first & down_edges;
+    }
+
+private:
+    const ChEdge& find_down_edge(uint32_t source, uint32_t target) const;
+    const ChEdge& find_up_edge(uint32_t source, uint32_t target) const;
+};
+
+/** Entry of the buckets of a many to many search: the duration from a
+ * vertex to the target reached by the backward search of the target
+ */
+struct ChBucketEntry {
+    uint32_t vertex;
+    uint32_t target; //< index of the target
+    double duration;
+};
+
+/** Point to point and many to many queries on a ContractionHierarchy
+ *
+ * The search state is kept between the queries and only the visited
+ * vertices are reset, a query does not depend on the size of the graph.
+ * One instance by thread.
+ */
+struct ContractionHierarchyQuery {
+    /**
+     * Shortest path from the sources (with their initial duration) to the target,
+     * the edges durations are divided by the speed factor.
+     *
+     * Returns the vertices of the graph from a source to the target,
+     * empty if the target is not reachable within max_duration (in ticks).
+     */
+    std::vector<uint32_t> shortest_path(const ContractionHierarchy& ch,
+                                        const std::vector<std::pair<uint32_t, double>>& sources,
+                                        uint32_t target,
+                                        double speed_factor,
+                                        double max_duration = std::numeric_limits<double>::infinity());
+
+    /**
+     * Backward searches of a bucket based many to many query, from each target.
+     * Returns the buckets, sorted by vertex.
+     */
+    std::vector<ChBucketEntry> backward_buckets(const ContractionHierarchy& ch,
+                                                const std::vector<uint32_t>& targets,
+                                                double speed_factor,
+                                                double max_duration = std::numeric_limits<double>::infinity());
+
+    /**
+     * Forward search of a bucket based many to many query, from the sources.
+     * Returns the duration to each of the nb_targets targets of the buckets,
+     * infinity if not reachable within max_duration.
+     *
+     * The buckets are only read, they can be shared between the threads.
+     */
+    std::vector<double> bucket_durations(const ContractionHierarchy& ch,
+                                         const std::vector<ChBucketEntry>& buckets,
+                                         size_t nb_targets,
+                                         const std::vector<std::pair<uint32_t, double>>& sources,
+                                         double speed_factor,
+                                         double max_duration = std::numeric_limits<double>::infinity());
+
+private:
+    struct Search {
+        std::vector<double> durations;
+        std::vector<uint32_t> parents; //< the previous vertex of the search
+        std::vector<uint32_t> middles; //< the middle of the edge from the parent
+        std::vector<uint32_t> visited;
+
+        void init(size_t nb_vertices);
+        bool update(uint32_t v, double duration, uint32_t parent, uint32_t middle);
+    };
+    Search forward;
+    Search backward;
+
+    /// dijkstra on the up edges (forward) or the down edges (backward) from
+    /// the vertices already in the search, stopped when on_settle returns false
+    template<typename OnSettle>
+    void upward_search(const ContractionHierarchy& ch, Search& search, bool forward_edges,
+                       double speed_factor, double max_duration, OnSettle on_settle);
+};
+
+}} //namespace navitia::georef
@@ -42,6 +42,8 @@ www.navitia.io
 #include <boost/math/constants/constants.hpp>
 #include <array>
 #include <unordered_map>
+#include <thread>
+#include <exception>
 
 using navitia::type::idx_t;
 
@@ -359,6 +361,7 @@ void ProjectionData::init(const type::GeographicalCoord & coord, const GeoRef &
  *  the Vls has thus not it's own graph and all projections are done on the walking graph (hence its offset is the walking graph offset)
  */
 void GeoRef::init() {
+    clear_csr_graph();
     offsets[nt::Mode_e::Walking] = 0;
     offsets[nt::Mode_e::Bss] = 0;
 
@@ -374,6 +377,21 @@ void GeoRef::init() {
     }
 }
 
+void GeoRef::build_csr_graph() {
+    std::vector<std::pair<uint32_t, uint32_t>> edges;
+    std::vector<CsrEdge> properties;
+    // the edges are pushed by source, in the order of the out edge lists,
+    // so that the dijkstra explores the edges in the same order on both graphs
+    for (vertex_t u = 0; u < boost::num_vertices(graph); ++u) {
+        BOOST_FOREACH(edge_t e, boost::out_edges(u, graph)) {
+            edges.emplace_back(uint32_t(u), uint32_t(boost::target(e, graph)));
+            properties.push_back({graph[e].duration});
+        }
+    }
+    csr_graph = CsrGraph(boost::edges_are_sorted, edges.begin(), edges.end(), properties.begin(),
+                         boost::num_vertices(graph));
+}
+
 void GeoRef::build_proximity_list(){
     pl.clear();
 
@@ -480,7 +498,8 @@ void GeoRef::build_admin_map(){
     * Si le numéro est rensigné, on renvoie les coordonnées les plus proches
     * Sinon le barycentre de la rue
 */
-std::vector<nf::Autocomplete<nt::idx_t>::fl_quality> GeoRef::find_ways(const std::string & str, const int nbmax, const int search_type, std::function<bool(nt::idx_t)> keep_element, const std::set<std::string>& ghostwords) const{
+std::vector<nf::Autocomplete<nt::idx_t>::fl_quality> GeoRef::find_ways(const std::string & str, const int nbmax, const int search_type, std::function<bool(nt::idx_t)> keep_element, const std::set<std::string>& ghostwords,
+                  nf::AutocompleteCache<nt::idx_t>* cache) const{
     std::vector<nf::Autocomplete<nt::idx_t>::fl_quality> to_return;
     boost::tokenizer<> tokens(str);
 
@@ -501,7 +520,7 @@ std::vector<nf::Autocomplete<nt::idx_t>::fl_quality> GeoRef::find_ways(const std
         search_str = str;
     }
     if (search_type == 0){
-        to_return = fl_way.find_complete(search_str, nbmax, keep_element, ghostwords);
+        to_return = fl_way.find_complete(search_str, nbmax, keep_element, ghostwords, cache);
     }else{
         to_return = fl_way.find_partial_with_pattern(search_str, word_weight, nbmax, keep_element, ghostwords);
     }
@@ -516,7 +535,7 @@ std::vector<nf::Autocomplete<nt::idx_t>::fl_quality> GeoRef::find_ways(const std
     return to_return;
 }
 
-void GeoRef::project_stop_points(const std::vector<type::StopPoint*> &stop_points) {
+void GeoRef::project_stop_points(const std::vector<type::StopPoint*> &stop_points, size_t nb_threads) {
    enum class error {
        matched = 0,
        matched_walking,
@@ -529,11 +548,34 @@ void GeoRef::project_stop_points(const std::vector<type::StopPoint*> &stop_point
    };
    navitia::flat_enum_map<error, int> messages {{{}}};
 
+   // the projections are independent, they are computed on nb_threads threads
+   std::vector<std::pair<GeoRef::ProjectionByMode, bool>> projections(stop_points.size());
+   std::vector<std::exception_ptr> errors(std::max(nb_threads, size_t(1)));
+   auto project = [&](size_t thread_idx) {
+       try {
+           for (size_t i = thread_idx; i < stop_points.size(); i += errors.size()) {
+               projections[i] = project_stop_point(stop_points[i]);
+           }
+       } catch (...) {
+           errors[thread_idx] = std::current_exception();
+       }
+   };
+   std::vector<std::thread> threads;
+   for (size_t thread_idx = 1; thread_idx < errors.size() && thread_idx < stop_points.size(); ++thread_idx) {
+       threads.emplace_back(project, thread_idx);
+   }
+   project(0);
+   for (auto& thread: threads) { thread.join(); }
+   for (const auto& error: errors) {
+       if (error) { std::rethrow_exception(error); }
+   }
+
    this->projected_stop_points.clear();
    this->projected_stop_points.reserve(stop_points.size());
 
-   for(const type::StopPoint* stop_point : stop_points) {
-       std::pair<GeoRef::ProjectionByMode, bool> pair = project_stop_point(stop_point);
+   for (size_t i = 0; i < stop_points.size(); ++i) {
+       const type::StopPoint* stop_point = stop_points[i];
+       const std::pair<GeoRef::ProjectionByMode, bool>& pair = projections[i];
 
        this->projected_stop_points.push_back(pair.first);
        if (pair.second) {
@@ -765,6 +807,7 @@ bool GeoRef::add_bss_edges(const type::GeographicalCoord& coord) {
 
     // time needed to take the bike + time to walk between the edges
     edge.duration = dur_between_edges + default_time_bss_pickup;
+    clear_csr_graph();
     add_edge(walking_v, biking_v, edge, graph);
 
     // time needed to hang the bike back + time to walk between the edges
@@ -800,6 +843,7 @@ bool GeoRef::add_parking_edges(const type::GeographicalCoord& coord) {
 
     // time to walk between the edges + time needed to leave the parking
     edge.duration = dur_between_edges + default_time_parking_leave;
+    clear_csr_graph();
     add_edge(walking_v, car_v, edge, graph);
 
     // time needed to park the car + time to walk between the edges
@@ -32,10 +32,12 @@ www.navitia.io
 #include "autocomplete/autocomplete.h"
 #include "proximity_list/proximity_list.h"
 #include "adminref.h"
+#include "contraction_hierarchy.h"
 #include "utils/exception.h"
 #include "utils/flat_enum_map.h"
 #include <boost/graph/adjacency_list.hpp>
 #include <boost/graph/adj_list_serialize.hpp>
+#include <boost/graph/compressed_sparse_row_graph.hpp>
 #include <boost/serialization/serialization.hpp>
 #include "utils/serialization_vector.h"
 #include <boost/serialization/utility.hpp>
@@ -108,6 +110,20 @@ typedef boost::graph_traits<Graph>::vertex_descriptor vertex_t;
 /// Représentation d'un arc dans le graphe
 typedef boost::graph_traits<Graph>::edge_descriptor edge_t;
 
+/// Properties of the edges of the CsrGraph
+struct CsrEdge {
+    navitia::time_duration duration;
+};
+
+/** Read-only copy of the Graph in compressed sparse row layout
+  *
+  * The out edges are stored in contiguous offsets/targets/durations arrays,
+  * sorted by source, in the order of the out edge lists of the Graph.
+  * It only holds what the dijkstra needs to relax the edges.
+  */
+typedef boost::compressed_sparse_row_graph<boost::directedS, boost::no_property, CsrEdge,
+                                           boost::no_property, uint32_t, uint32_t> CsrGraph;
+
 /// Pour parcourir les segements du graphe
 typedef boost::graph_traits<Graph>::edge_iterator edge_iterator;
 
@@ -258,6 +274,19 @@ struct GeoRef {
 
     /// number of vertex by transportation mode
     nt::idx_t nb_vertex_by_mode = 0;
+
+    /** Copy of the graph for the dijkstra, not serialized (see build_csr_graph)
+      *
+      * It is a copy: the graph is still needed by the rest of the street
+      * network (projections, ways, geometries). On a grid of 4M edges the
+      * adjacency_list takes about 62 bytes per edge and the copy about 14
+      * more, the memory is traded for the contiguous scans of the dijkstra.
+      */
+    CsrGraph csr_graph;
+
+    /// Contraction hierarchies of the graph, only for the modes they have been built for
+    /// (see build_contraction_hierarchies)
+    flat_enum_map<nt::Mode_e, ContractionHierarchy> contraction_hierarchies;
     navitia::autocomplete::autocomplete_map synonyms;
     std::set<std::string> ghostwords;
 
@@ -269,19 +298,27 @@ struct GeoRef {
     template<class Archive> void save(Archive & ar, const unsigned int) const {
         ar & ways & way_map & graph & offsets & fl_admin & fl_way & pl & projected_stop_points
                 & admins & admin_map &  pois & fl_poi & poitypes & poitype_map & poi_map & synonyms
-                & ghostwords & poi_proximity_list & nb_vertex_by_mode;
+                & ghostwords & poi_proximity_list & nb_vertex_by_mode & contraction_hierarchies;
     }
 
     template<class Archive> void load(Archive & ar, const unsigned int) {
         // La désérialisation d'une boost adjacency list ne vide pas le graphe
         // On avait donc une fuite de mémoire
         graph.clear();
+        clear_csr_graph();
         ar & ways & way_map & graph & offsets & fl_admin & fl_way & pl & projected_stop_points
                 & admins & admin_map & pois & fl_poi & poitypes & poitype_map & poi_map & synonyms
-                & ghostwords & poi_proximity_list & nb_vertex_by_mode;
+                & ghostwords & poi_proximity_list & nb_vertex_by_mode & contraction_hierarchies;
     }
     BOOST_SERIALIZATION_SPLIT_MEMBER()
 
+    /// Build csr_graph from the graph, to be done once the graph won't change anymore
+    void build_csr_graph();
+    /// Drop csr_graph, done by every method of the GeoRef modifying the graph
+    void clear_csr_graph() { csr_graph = CsrGraph(); }
+    /// true if csr_graph has been built and the graph not modified by the GeoRef since
+    bool has_csr_graph() const { return boost::num_vertices(csr_graph) > 0; }
+
     /** Construit l'indexe spatial */
     void build_proximity_list();
 
@@ -298,15 +335,16 @@ struct GeoRef {
     void build_pois_map();
 
     /// Recherche d'une adresse avec un numéro en utilisant Autocomplete
-    std::vector<nf::Autocomplete<nt::idx_t>::fl_quality> find_ways(const std::string & str, const int nbmax, const int search_type,std::function<bool(nt::idx_t)> keep_element, const std::set<std::string>& ghostwords) const;
+    std::vector<nf::Autocomplete<nt::idx_t>::fl_quality> find_ways(const std::string & str, const int nbmax, const int search_type,std::function<bool(nt::idx_t)> keep_element, const std::set<std::string>& ghostwords,
+              nf::AutocompleteCache<nt::idx_t>* cache = nullptr) const;
 
 
     std::vector<Admin*> find_admins(const type::GeographicalCoord&) const;
 
     /**
-     * Project each stop_point on the georef network
+     * Project each stop_point on the georef network, on nb_threads threads
      */
-    void project_stop_points(const std::vector<type::StopPoint*> & stop_points);
+    void project_stop_points(const std::vector<type::StopPoint*> & stop_points, size_t nb_threads = 1);
 
     /** project the stop point on all transportation mode
       * return a pair with :
@@ -33,6 +33,8 @@ www.navitia.io
 #include "georef.h"
 #include <boost/math/constants/constants.hpp>
 #include <chrono>
+#include <cmath>
+#include <thread>
 #ifdef _DEBUG_DIJKSTRA_QUANTUM_
 #include <boost/foreach.hpp>
 #endif
@@ -49,6 +51,21 @@ navitia::time_duration PathFinder::crow_fly_duration(const double distance) cons
     return navitia::seconds(distance / (default_speed[mode_] * speed_factor));
 }
 
+static edge_t get_best_edge(vertex_t u, vertex_t v, const GeoRef& georef) {
+    const auto& g = georef.graph;
+    boost::optional<edge_t> best_edge;
+    for (auto range = out_edges(u, g); range.first != range.second; ++range.first) {
+        if (target(*range.first, g) != v) { continue; }
+        if (! best_edge || g[*range.first].duration < g[*best_edge].duration) {
+            best_edge = *range.first;
+        }
+    }
+    if (! best_edge) {
+        throw navitia::exception("impossible to find an edge");
+    }
+    return *best_edge;
+}
+
 static bool is_projected_on_same_edge(const ProjectionData& p1, const ProjectionData& p2){
     // On the same edge if both use the same two vertices, are on the same way with the same duration
     return (((p1[source_e] == p2[source_e] && p1[target_e] == p2[target_e])
@@ -208,14 +225,33 @@ StreetNetwork::get_direct_path(const type::EntryPoint& origin, const type::Entry
                             origin.streetnetwork_params.mode,
                             origin.streetnetwork_params.speed_factor);
 
-    direct_path_finder.start_distance_or_target_dijkstra(max_dur, {dest_edge[source_e], dest_edge[target_e]});
+    if (! direct_path_finder.start_contraction_hierarchy_query(max_dur, {dest_edge[source_e], dest_edge[target_e]})) {
+        direct_path_finder.start_distance_or_target_dijkstra(max_dur, {dest_edge[source_e], dest_edge[target_e]});
+    }
     const auto dest_vertex = direct_path_finder.find_nearest_vertex(dest_edge, true);
     const auto res = direct_path_finder.get_path(dest_edge, dest_vertex);
     if (res.duration > max_dur) { return Path(); }
     return res;
 }
 
-PathFinder::PathFinder(const GeoRef& gref) : geo_ref(gref), color(boost::num_vertices(geo_ref.graph)) {}
+ModeLayers::ModeLayers(type::Mode_e mode, const GeoRef& geo_ref) : nb_vertex_by_mode(geo_ref.nb_vertex_by_mode) {
+    if (nb_vertex_by_mode == 0) {
+        nb_vertices = boost::num_vertices(geo_ref.graph);
+        return;
+    }
+    // the graphs allowed for the mode are stored one after the other
+    const size_t nb_graphs = (boost::num_vertices(geo_ref.graph) + nb_vertex_by_mode - 1) / nb_vertex_by_mode;
+    for (const auto graph_mode: {type::Mode_e::Walking, type::Mode_e::Bike, type::Mode_e::Car, type::Mode_e::Bss}) {
+        if (size_t(graph_mode) < nb_graphs && allowed_transportation_mode[mode][graph_mode]) {
+            positions[graph_mode] = nb_vertices;
+            nb_vertices += nb_vertex_by_mode;
+        } else {
+            positions[graph_mode] = invalid_position;
+        }
+    }
+}
+
+PathFinder::PathFinder(const GeoRef& gref) : geo_ref(gref), color(0) {}
 
 void PathFinder::init(const type::GeographicalCoord& start_coord, nt::Mode_e mode, const float speed_factor) {
     computation_launch = false;
@@ -228,35 +264,47 @@ void PathFinder::init(const type::GeographicalCoord& start_coord, nt::Mode_e mod
     starting_edge = ProjectionData(start_coord, this->geo_ref, offset, this->geo_ref.pl);
 
     distance_to_entry_point.clear();
-    //we initialize the distances to the maximum value
-    size_t n = boost::num_vertices(geo_ref.graph);
-    distances.assign(n, bt::pos_infin);
+    //we initialize the distances to the maximum value, only the graphs of the mode are stored
+    layers = ModeLayers(mode, geo_ref);
+    const size_t n = layers.nb_vertices;
+    if (distances.size() != n) {
+        distances.assign(n, bt::pos_infin);
+    } else {
+        // only the entries set by the previous search are to reset
+        for (const auto idx: touched) {
+            distances[idx] = bt::pos_infin;
+            color.data[idx / color.elements_per_char] = 0;
+        }
+    }
+    touched.clear();
     //for the predecessors no need to clean the values, the important one will be updated during search
     predecessors.resize(n);
     index_in_heap_map.resize(n);
 
     if (starting_edge.found) {
         //durations initializations
-        distances[starting_edge[source_e]] = crow_fly_duration(starting_edge.distances[source_e]); //for the projection, we use the default walking speed.
-        distances[starting_edge[target_e]] = crow_fly_duration(starting_edge.distances[target_e]);
-        predecessors[starting_edge[source_e]] = starting_edge[source_e];
-        predecessors[starting_edge[target_e]] = starting_edge[target_e];
+        set_distance(starting_edge[source_e], crow_fly_duration(starting_edge.distances[source_e])); //for the projection, we use the default walking speed.
+        set_distance(starting_edge[target_e], crow_fly_duration(starting_edge.distances[target_e]));
+        predecessors[layers[starting_edge[source_e]]] = starting_edge[source_e];
+        predecessors[layers[starting_edge[target_e]]] = starting_edge[target_e];
 
         if (starting_edge[target_e] != starting_edge[source_e]) { //if we're on a useless edge we do not enhance
             //small enchancement, if the projection is done on a node, we disable the crow fly
             if (starting_edge.distances[source_e] < 0.01) {
-                predecessors[starting_edge[target_e]] = starting_edge[source_e];
-                distances[starting_edge[target_e]] = bt::pos_infin;
+                predecessors[layers[starting_edge[target_e]]] = starting_edge[source_e];
+                distances[layers[starting_edge[target_e]]] = bt::pos_infin;
             } else if (starting_edge.distances[target_e] < 0.01) {
-                predecessors[starting_edge[source_e]] = starting_edge[target_e];
-                distances[starting_edge[source_e]] = bt::pos_infin;
+                predecessors[layers[starting_edge[source_e]]] = starting_edge[target_e];
+                distances[layers[starting_edge[source_e]]] = bt::pos_infin;
             }
         }
     }
 
     if (color.n != n) {
-        color = boost::two_bit_color_map<>(n);
+        // a new color map is white, the touched entries are reset before each dijkstra
+        color = boost::two_bit_color_map<ModeLayers>(n, layers);
     }
+    color.index = layers;
 }
 
 void PathFinder::start_distance_dijkstra(const navitia::time_duration& radius) {
@@ -266,17 +314,17 @@ void PathFinder::start_distance_dijkstra(const navitia::time_duration& radius) {
     // We start dijkstra from source and target nodes
     try {
 #ifndef _DEBUG_DIJKSTRA_QUANTUM_
-        dijkstra(starting_edge[source_e], distance_visitor(radius, distances));
+        dijkstra(starting_edge[source_e], distance_visitor(radius, distances, layers));
 #else
-        dijkstra(starting_edge[source_e], printer_distance_visitor(radius, distances, "source"));
+        dijkstra(starting_edge[source_e], printer_distance_visitor(radius, distances, layers, "source"));
 #endif
     } catch(DestinationFound){}
 
     try {
 #ifndef _DEBUG_DIJKSTRA_QUANTUM_
-        dijkstra(starting_edge[target_e], distance_visitor(radius, distances));
+        dijkstra(starting_edge[target_e], distance_visitor(radius, distances, layers));
 #else
-        dijkstra(starting_edge[target_e], printer_distance_visitor(radius, distances, "target"));
+        dijkstra(starting_edge[target_e], printer_distance_visitor(radius, distances, layers, "target"));
 #endif
     } catch(DestinationFound){}
 
@@ -289,24 +337,58 @@ void PathFinder::start_distance_or_target_dijkstra(const navitia::time_duration&
     // We start dijkstra from source and target nodes
     try {
 #ifndef _DEBUG_DIJKSTRA_QUANTUM_
-        dijkstra(starting_edge[source_e], distance_or_target_visitor(radius, distances, destinations));
+        dijkstra(starting_edge[source_e], distance_or_target_visitor(radius, distances, layers, destinations));
 #else
         dijkstra(starting_edge[source_e],
-                 printer_distance_or_target_visitor(radius, distances, destinations, "direct_path_source"));
+                 printer_distance_or_target_visitor(radius, distances, layers, destinations, "direct_path_source"));
 #endif
     } catch(DestinationFound&){}
 
     try {
 #ifndef _DEBUG_DIJKSTRA_QUANTUM_
-        dijkstra(starting_edge[target_e], distance_or_target_visitor(radius, distances, destinations));
+        dijkstra(starting_edge[target_e], distance_or_target_visitor(radius, distances, layers, destinations));
 #else
         dijkstra(starting_edge[target_e],
-                 printer_distance_or_target_visitor(radius, distances, destinations, "direct_path_target"));
+                 printer_distance_or_target_visitor(radius, distances, layers, destinations, "direct_path_target"));
 #endif
     } catch(DestinationFound&){}
 
 }
 
+bool PathFinder::start_contraction_hierarchy_query(const navitia::time_duration& radius,
+                                                   const std::vector<vertex_t>& destinations) {
+    const auto& ch = geo_ref.contraction_hierarchies[mode];
+    if (ch.empty() || ch.nb_vertices() != boost::num_vertices(geo_ref.graph) || ! starting_edge.found) {
+        return false;
+    }
+    computation_launch = true;
+
+    std::vector<std::pair<uint32_t, double>> sources;
+    for (const auto direction: {source_e, target_e}) {
+        const auto v = starting_edge[direction];
+        if (distances[layers[v]] == bt::pos_infin) { continue; }
+        sources.emplace_back(v, distances[layers[v]].ticks());
+    }
+    const double max_duration = radius.is_pos_infinity() ? std::numeric_limits<double>::infinity()
+                                                         : radius.ticks();
+    const SpeedDistanceCombiner combiner(speed_factor);
+    for (const auto destination: destinations) {
+        if (distances[layers[destination]] != bt::pos_infin) { continue; }
+        const auto path = ch_query.shortest_path(ch, sources, destination, speed_factor, max_duration);
+        // relaxation of the edges of the path, as done by the dijkstra
+        for (size_t i = 1; i < path.size(); ++i) {
+            const vertex_t u = path[i - 1];
+            const vertex_t v = path[i];
+            const auto duration = combiner(distances[layers[u]], geo_ref.graph[get_best_edge(u, v, geo_ref)].duration);
+            if (duration < distances[layers[v]]) {
+                set_distance(v, duration);
+                predecessors[layers[v]] = u;
+            }
+        }
+    }
+    return true;
+}
+
 std::vector<std::pair<type::idx_t, type::GeographicalCoord>>
 PathFinder::crow_fly_find_nearest_stop_points(const navitia::time_duration& radius,
                                               const proximitylist::ProximityList<type::idx_t>& pl) {
@@ -366,28 +448,56 @@ PathFinder::start_dijkstra_and_fill_duration_map(const navitia::time_duration& r
         //if our two points are projected on the same edge the
         // Dijkstra won't give us the correct value we need to handle
         // this case separately
-        auto& projection = dest.second;
-        auto& id = dest.first;
-        navitia::time_duration duration;
-        if(is_projected_on_same_edge(starting_edge, projection)){
-            //We calculate the duration for going to the edge, then to
-            //the projected destination on the edge and finally to the
-            //destination
-            duration = path_duration_on_same_edge(starting_edge, projection);
-        } else {
-            duration = find_nearest_vertex(projection, true).first;
-        }
-        if(duration <= radius){
-            result[id] = georef::RoutingElement(duration, georef::RoutingStatus_e::reached) ;
-        } else {
-            result[id] = georef::RoutingElement(navitia::time_duration(),
-                                                georef::RoutingStatus_e::unreached);
-        }
-
+        result[dest.first] = get_routing_element(dest.second, radius);
     }
     return result;
 }
 
+RoutingElement PathFinder::get_routing_element(const ProjectionData& projection,
+                                               const navitia::time_duration& radius) {
+    if (! projection.found) {
+        return RoutingElement(navitia::time_duration(), RoutingStatus_e::unknown);
+    }
+    //if our two points are projected on the same edge the
+    // Dijkstra won't give us the correct value we need to handle
+    // this case separately
+    navitia::time_duration duration;
+    if(is_projected_on_same_edge(starting_edge, projection)){
+        //We calculate the duration for going to the edge, then to
+        //the projected destination on the edge and finally to the
+        //destination
+        duration = path_duration_on_same_edge(starting_edge, projection);
+    } else {
+        duration = find_nearest_vertex(projection, true).first;
+    }
+    if(duration <= radius){
+        return RoutingElement(duration, RoutingStatus_e::reached);
+    }
+    return RoutingElement(navitia::time_duration(), RoutingStatus_e::unreached);
+}
+
+void PathFinder::update_distances_with_buckets(const ContractionHierarchy& ch,
+                                               const std::vector<ChBucketEntry>& buckets,
+                                               const std::vector<vertex_t>& targets) {
+    assert(speed_factor == 1);
+    if (! starting_edge.found) { return; }
+    std::vector<std::pair<uint32_t, double>> sources;
+    for (const auto direction: {source_e, target_e}) {
+        const auto v = starting_edge[direction];
+        if (distances[layers[v]] == bt::pos_infin) { continue; }
+        sources.emplace_back(v, distances[layers[v]].ticks());
+    }
+    const auto durations = ch_query.bucket_durations(ch, buckets, targets.size(), sources, speed_factor);
+    for (size_t i = 0; i < targets.size(); ++i) {
+        if (durations[i] == std::numeric_limits<double>::infinity()) { continue; }
+        // a sum of ticks, exact in a double, as the one of the dijkstra at this speed
+        const auto duration = navitia::time_duration(0, 0, 0, navitia::time_duration::tick_type(durations[i]));
+        if (duration < distances[layers[targets[i]]]) {
+            set_distance(targets[i], duration);
+        }
+    }
+}
+
 routing::map_stop_point_duration
 PathFinder::find_nearest_stop_points(const navitia::time_duration& radius,
                                      const proximitylist::ProximityList<type::idx_t>& pl) {
@@ -476,20 +586,20 @@ std::pair<navitia::time_duration, ProjectionData::Direction> PathFinder::find_ne
     if (! target.found)
         return {max, source_e};
 
-    if (distances[target[source_e]] == max) //if one distance has not been reached, both have not been reached
+    if (distances[layers[target[source_e]]] == max) //if one distance has not been reached, both have not been reached
         return {max, source_e};
 
     if (handle_on_node) {
         //handle if the projection is done on a node
         if (target.distances[source_e] < 0.01) {
-            return {distances[target[source_e]], source_e};
+            return {distances[layers[target[source_e]]], source_e};
         } else if (target.distances[target_e] < 0.01) {
-            return {distances[target[target_e]], target_e};
+            return {distances[layers[target[target_e]]], target_e};
         }
     }
 
-    auto source_dist = distances[target[source_e]] + crow_fly_duration(target.distances[source_e]);
-    auto target_dist = distances[target[target_e]] + crow_fly_duration(target.distances[target_e]);
+    auto source_dist = distances[layers[target[source_e]]] + crow_fly_duration(target.distances[source_e]);
+    auto target_dist = distances[layers[target[target_e]]] + crow_fly_duration(target.distances[target_e]);
 
     if (target_dist < source_dist)
         return {target_dist, target_e};
@@ -708,7 +818,16 @@ std::pair<navitia::time_duration, ProjectionData::Direction> PathFinder::update_
     assert(boost::edge(target[source_e], target[target_e], geo_ref.graph).second );
 
     computation_launch = true;
-    if (distances[target[source_e]] == max || distances[target[target_e]] == max) {
+    if (distances[layers[target[source_e]]] == max || distances[layers[target[target_e]]] == max) {
+        if (start_contraction_hierarchy_query(max, {target[source_e], target[target_e]})) {
+            if (distances[layers[target[source_e]]] == max || distances[layers[target[target_e]]] == max) {
+                LOG4CPLUS_WARN(log4cplus::Logger::getInstance("Logger"), "unable to find a way from start edge ["
+                               << starting_edge[source_e] << "-" << starting_edge[target_e]
+                               << "] to [" << target[source_e] << "-" << target[target_e] << "]");
+                return {max, source_e};
+            }
+            return find_nearest_vertex(target);
+        }
         bool found = false;
         try {
             dijkstra(starting_edge[source_e], target_all_visitor({target[source_e], target[target_e]}));
@@ -732,35 +851,118 @@ std::pair<navitia::time_duration, ProjectionData::Direction> PathFinder::update_
 
     }
     //if we succeded in the first search, we must have found one of the other distances
-    assert(distances[target[source_e]] != max && distances[target[target_e]] != max);
+    assert(distances[layers[target[source_e]]] != max && distances[layers[target[target_e]]] != max);
 
     return find_nearest_vertex(target);
 }
 
 Path PathFinder::build_path(vertex_t best_destination) const {
     std::vector<vertex_t> reverse_path;
-    while (best_destination != predecessors[best_destination]){
+    while (best_destination != predecessors[layers[best_destination]]){
         reverse_path.push_back(best_destination);
-        best_destination = predecessors[best_destination];
+        best_destination = predecessors[layers[best_destination]];
     }
     reverse_path.push_back(best_destination);
 
     return create_path(geo_ref, reverse_path, true, speed_factor);
 }
 
-static edge_t get_best_edge(vertex_t u, vertex_t v, const GeoRef& georef) {
-    const auto& g = georef.graph;
-    boost::optional<edge_t> best_edge;
-    for (auto range = out_edges(u, g); range.first != range.second; ++range.first) {
-        if (target(*range.first, g) != v) { continue; }
-        if (! best_edge || g[*range.first].duration < g[*best_edge].duration) {
-            best_edge = *range.first;
+std::vector<std::vector<RoutingElement>>
+compute_routing_matrix(const std::vector<PathFinder*>& path_finders,
+                       const std::vector<type::GeographicalCoord>& origins,
+                       const std::vector<type::GeographicalCoord>& destinations,
+                       const nt::Mode_e mode,
+                       const float speed_factor,
+                       const navitia::time_duration& radius) {
+    assert(! path_finders.empty());
+    const auto& geo_ref = path_finders.front()->geo_ref;
+
+    //on direct path with car we want to arrive on the walking graph
+    const auto offset = geo_ref.offsets[mode == nt::Mode_e::Car ? nt::Mode_e::Walking : mode];
+    std::vector<ProjectionData> projections;
+    bool one_projection_found = false;
+    for (const auto& coord: destinations) {
+        projections.emplace_back(coord, geo_ref, offset, geo_ref.pl);
+        one_projection_found |= projections.back().found;
+    }
+
+    // with a contraction hierarchy, the backward searches from the
+    // destinations are done once for all the origins.
+    // The dijkstra truncates each edge divided by the speed factor, a sum the
+    // shortcuts cannot give: the hierarchy is only used at the speed it was
+    // contracted with, where both sum the same ticks.
+    const auto& ch = geo_ref.contraction_hierarchies[mode];
+    const bool use_ch = speed_factor == 1 && ! ch.empty() && ch.nb_vertices() == boost::num_vertices(geo_ref.graph);
+    std::vector<vertex_t> targets;
+    std::vector<ChBucketEntry> buckets;
+    if (use_ch) {
+        for (const auto& projection: projections) {
+            if (! projection.found) { continue; }
+            targets.push_back(projection[source_e]);
+            targets.push_back(projection[target_e]);
         }
+        std::sort(targets.begin(), targets.end());
+        targets.erase(std::unique(targets.begin(), targets.end()), targets.end());
+        const std::vector<uint32_t> ch_targets(targets.begin(), targets.end());
+        buckets = path_finders.front()->ch_query.backward_buckets(ch, ch_targets, speed_factor);
     }
-    if (! best_edge) {
-        throw navitia::exception("impossible to find an edge");
+
+    std::vector<std::vector<RoutingElement>> result(origins.size());
+    std::vector<std::exception_ptr> errors(path_finders.size());
+    // the origins are interleaved between the path finders
+    auto compute_rows = [&](const size_t thread_idx) {
+        try {
+            auto& path_finder = *path_finders[thread_idx];
+            for (size_t i = thread_idx; i < origins.size(); i += path_finders.size()) {
+                path_finder.init(origins[i], mode, speed_factor);
+                if (! one_projection_found) {
+                    // nothing to compute, all the destinations are unknown
+                } else if (use_ch) {
+                    path_finder.update_distances_with_buckets(ch, buckets, targets);
+                } else {
+                    path_finder.start_distance_dijkstra(radius);
+                }
+                auto& row = result[i];
+                row.reserve(projections.size());
+                for (const auto& projection: projections) {
+                    row.push_back(path_finder.get_routing_element(projection, radius));
+                }
+            }
+        } catch (...) {
+            errors[thread_idx] = std::current_exception();
+        }
+    };
+    const size_t nb_threads = std::min(path_finders.size(), origins.size());
+    std::vector<std::thread> threads;
+    for (size_t thread_idx = 1; thread_idx < nb_threads; ++thread_idx) {
+        threads.emplace_back(compute_rows, thread_idx);
+    }
+    compute_rows(0);
+    for (auto& thread: threads) { thread.join(); }
+    for (const auto& error: errors) {
+        if (error) { std::rethrow_exception(error); }
+    }
+    return result;
+}
+
+void build_contraction_hierarchies(GeoRef& geo_ref, const std::vector<nt::Mode_e>& modes) {
+    auto logger = log4cplus::Logger::getInstance("Logger");
+    const auto& graph = geo_ref.graph;
+    for (const auto mode: modes) {
+        // same subgraph as the one filtered for the dijkstra of the mode
+        const TransportationModeFilter filter(mode, geo_ref);
+        std::vector<ChArc> arcs;
+        for (auto range = boost::edges(graph); range.first != range.second; ++range.first) {
+            const auto source = boost::source(*range.first, graph);
+            const auto target = boost::target(*range.first, graph);
+            if (! filter(source) || ! filter(target)) { continue; }
+            arcs.push_back({uint32_t(source), uint32_t(target), uint32_t(graph[*range.first].duration.ticks())});
+        }
+        auto& ch = geo_ref.contraction_hierarchies[mode];
+        ch.build(boost::num_vertices(graph), arcs);
+        LOG4CPLUS_INFO(logger, "contraction hierarchy for " << mode << ": " << arcs.size() << " edges, "
+                       << ch.up_edges.size() + ch.down_edges.size() << " edges in the hierarchy");
     }
-    return *best_edge;
 }
 
 Path create_path(const GeoRef& geo_ref,
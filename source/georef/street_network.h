@@ -35,6 +35,7 @@ www.navitia.io
 #include "type/time_duration.h"
 #include <boost/graph/filtered_graph.hpp>
 #include <boost/graph/two_bit_color_map.hpp>
+#include <boost/property_map/property_map.hpp>
 #include <boost/format.hpp>
 
 namespace bt = boost::posix_time;
@@ -96,6 +97,67 @@ struct TransportationModeFilter {
     }
 };
 
+/**
+ * Index of the vertices of the graphs used by a transportation mode (see
+ * TransportationModeFilter) in the state arrays of a PathFinder.
+ *
+ * Only the graphs allowed for the mode are stored, one after the other, so
+ * a walking or biking search needs one entry by vertex of its graph instead
+ * of one entry by vertex of all the graphs.
+ * The default constructed index is the identity.
+ */
+struct ModeLayers : public boost::put_get_helper<size_t, ModeLayers> {
+    typedef vertex_t key_type;
+    typedef size_t value_type;
+    typedef size_t reference;
+    typedef boost::readable_property_map_tag category;
+
+    static constexpr size_t invalid_position = std::numeric_limits<size_t>::max();
+
+    /// position in the state arrays of the first vertex of each graph
+    flat_enum_map<type::Mode_e, size_t> positions;
+    type::idx_t nb_vertex_by_mode = 0;
+    /// number of vertices of the graphs of the mode
+    size_t nb_vertices = 0;
+
+    ModeLayers() = default;
+    ModeLayers(type::Mode_e mode, const georef::GeoRef& geo_ref);
+
+    size_t operator[](vertex_t v) const {
+        if (nb_vertex_by_mode == 0) { return v; }
+        const auto position = positions[static_cast<type::Mode_e>(v / nb_vertex_by_mode)];
+        BOOST_ASSERT_MSG(position != invalid_position, "the vertex is not in a graph of the mode");
+        return position + v % nb_vertex_by_mode;
+    }
+};
+
+/**
+ * Distance map of the dijkstra of a PathFinder, remembering the entries it
+ * sets so that they are the only ones to reset for the next search
+ */
+struct TouchedDistanceMap {
+    typedef vertex_t key_type;
+    typedef navitia::time_duration value_type;
+    typedef const navitia::time_duration& reference;
+    typedef boost::read_write_property_map_tag category;
+
+    std::vector<navitia::time_duration>* distances;
+    std::vector<size_t>* touched;
+    ModeLayers layers;
+};
+
+inline const navitia::time_duration& get(const TouchedDistanceMap& map, vertex_t v) {
+    return (*map.distances)[map.layers[v]];
+}
+
+inline void put(const TouchedDistanceMap& map, vertex_t v, const navitia::time_duration& duration) {
+    auto& distance = (*map.distances)[map.layers[v]];
+    if (distance == bt::pos_infin) {
+        map.touched->push_back(map.layers[v]);
+    }
+    distance = duration;
+}
+
 enum class RoutingStatus_e {
     reached = 0,
     unreached = 1,
@@ -126,17 +188,30 @@ struct PathFinder {
     /// Distance map between entry point and stop point
     std::map<routing::SpIdx, navitia::time_duration> distance_to_entry_point;
 
-    /// Distance array for the Dijkstra
+    /// Index of the vertices in the arrays below, only the graphs of the mode are stored
+    ModeLayers layers;
+
+    /// Distance array for the Dijkstra (indexed by layers)
     std::vector<navitia::time_duration> distances;
 
-    /// Predecessors array for the Dijkstra
+    /**
+     * Entries of the arrays set since the last init (with duplicates): every
+     * finite distance and every non white color is in there, they are the
+     * only ones to reset between two searches, not the whole graph
+     */
+    std::vector<size_t> touched;
+
+    /// Predecessors array for the Dijkstra (indexed by layers)
     std::vector<vertex_t> predecessors;
 
     /// helper for dijkstra internal heap (to avoid extra alloc)
     std::vector<std::size_t> index_in_heap_map;
 
     /// Color map for the dijkstra shortest path (to avoid extra alloc)
-    boost::two_bit_color_map<> color;
+    boost::two_bit_color_map<ModeLayers> color;
+
+    /// Search state of the contraction hierarchy queries (to avoid extra alloc)
+    ContractionHierarchyQuery ch_query;
 
     PathFinder(const GeoRef& geo_ref);
 
@@ -149,6 +224,14 @@ struct PathFinder {
     void start_distance_dijkstra(const navitia::time_duration& radius);
     void start_distance_or_target_dijkstra(const navitia::time_duration& radius, const std::vector<vertex_t>& destinations);
 
+    /**
+     * Compute the path to each destination with the contraction hierarchy of the mode,
+     * the distances and predecessors are updated along the paths like a dijkstra would.
+     * Return false if there is no contraction hierarchy for the mode.
+     */
+    bool start_contraction_hierarchy_query(const navitia::time_duration& radius,
+                                           const std::vector<vertex_t>& destinations);
+
     /// compute the reachable stop points within the radius
     routing::map_stop_point_duration
     find_nearest_stop_points(const navitia::time_duration& radius,
@@ -158,9 +241,30 @@ struct PathFinder {
     get_duration_with_dijkstra(const navitia::time_duration& radius,
                                const std::vector<type::GeographicalCoord>& entry_points);
 
+    /**
+     * Duration from the starting point to the projected target, once the
+     * distances of the vertices of the target have been computed
+     */
+    RoutingElement get_routing_element(const ProjectionData& target, const navitia::time_duration& radius);
+
+    /**
+     * Set the distances of the targets with the forward search of a bucket
+     * based many to many query on the contraction hierarchy of the mode.
+     * The predecessors are not updated, no path can be built from them.
+     * Only at a speed factor of 1, see compute_routing_matrix.
+     */
+    void update_distances_with_buckets(const ContractionHierarchy& ch,
+                                       const std::vector<ChBucketEntry>& buckets,
+                                       const std::vector<vertex_t>& targets);
+
     /// compute the distance from the starting point to the target stop point
     navitia::time_duration get_distance(type::idx_t target_idx);
 
+    /// set the distance of a vertex outside of the dijkstra
+    void set_distance(vertex_t v, const navitia::time_duration& duration) {
+        put(TouchedDistanceMap{&distances, &touched, layers}, v, duration);
+    }
+
     /// return the path from the starting point to the target. the target has to have been previously visited.
     Path get_path(type::idx_t idx);
 
@@ -175,23 +279,43 @@ struct PathFinder {
     void dijkstra(vertex_t start, Visitor visitor) {
         // Note: the predecessors have been updated in init
 
-        // Fill color map in white before dijkstra
-        std::fill(color.data.get(),
-                  color.data.get() + (color.n + color.elements_per_char - 1) / color.elements_per_char,
-                  0);
+        // Fill color map in white before dijkstra, only the touched entries
+        // can be colored (the whole byte of an entry is cleared, its
+        // neighbours are either touched too or already white)
+        touched.push_back(layers[start]);
+        for (const auto idx: touched) {
+            color.data[idx / color.elements_per_char] = 0;
+        }
+
+#ifndef _DEBUG_DIJKSTRA_QUANTUM_
+        // the compact copy of the graph is used when available (the debug
+        // visitors need the vertex coordinates, only in the adjacency list)
+        if (geo_ref.has_csr_graph()) {
+            dijkstra(geo_ref.csr_graph, boost::get(&CsrEdge::duration, geo_ref.csr_graph), start, visitor);
+            return;
+        }
+#endif
+        dijkstra(geo_ref.graph, boost::get(&Edge::duration, geo_ref.graph), start, visitor);
+    }
+
+    template<class G, class WeightMap, class Visitor>
+    void dijkstra(const G& graph, WeightMap weights, vertex_t start, Visitor visitor) {
+        const typename boost::graph_traits<G>::vertex_descriptor source = start;
 
         //we filter the graph to only use certain mean of transport
-        using filtered_graph = boost::filtered_graph<georef::Graph, boost::keep_all, TransportationModeFilter>;
+        using filtered_graph = boost::filtered_graph<G, boost::keep_all, TransportationModeFilter>;
         boost::dijkstra_shortest_paths_no_init_with_heap(
-                filtered_graph(geo_ref.graph, {}, TransportationModeFilter(mode, geo_ref)),
-                &start, &start + 1, &predecessors[0], &distances[0],
-                boost::get(&Edge::duration, geo_ref.graph), // weigth map
+                filtered_graph(graph, {}, TransportationModeFilter(mode, geo_ref)),
+                &source, &source + 1,
+                boost::make_iterator_property_map(predecessors.begin(), layers),
+                TouchedDistanceMap{&distances, &touched, layers},
+                weights, // weigth map
                 std::less<navitia::time_duration>(),
                 SpeedDistanceCombiner(speed_factor), //we multiply the edge duration by a speed factor
                 navitia::seconds(0),
                 visitor,
                 color,
-                &index_in_heap_map[0]
+                boost::make_iterator_property_map(index_in_heap_map.begin(), layers)
                 );
     }
 
@@ -271,6 +395,25 @@ struct StreetNetwork {
     PathFinder direct_path_finder;
 };
 
+/**
+ * Duration matrix from each origin to each destination, within the radius.
+ *
+ * With a contraction hierarchy for the mode, the backward searches from the
+ * destinations are shared between all the origins (bucket based many to many),
+ * else there is one dijkstra by origin.
+ * The origins are shared between the path finders, one thread by path finder.
+ */
+std::vector<std::vector<RoutingElement>>
+compute_routing_matrix(const std::vector<PathFinder*>& path_finders,
+                       const std::vector<type::GeographicalCoord>& origins,
+                       const std::vector<type::GeographicalCoord>& destinations,
+                       nt::Mode_e mode,
+                       float speed_factor,
+                       const navitia::time_duration& radius);
+
+/// Build the contraction hierarchies of the graph for the given modes
+void build_contraction_hierarchies(GeoRef& geo_ref, const std::vector<nt::Mode_e>& modes);
+
 /// Build a path from a reverse path list
 Path create_path(const GeoRef& georef,
                  const std::vector<vertex_t>& reverse_path,
@@ -299,9 +442,11 @@ struct target_visitor : public boost::dijkstra_visitor<> {
 struct distance_visitor : virtual public boost::dijkstra_visitor<> {
     navitia::time_duration max_duration;
     const std::vector<navitia::time_duration>& durations;
+    ModeLayers layers; // index of the vertices in durations
 
-    distance_visitor(const time_duration& max_dur, const std::vector<time_duration>& dur):
-        max_duration(max_dur), durations(dur) {}
+    distance_visitor(const time_duration& max_dur, const std::vector<time_duration>& dur,
+                     const ModeLayers& layers = ModeLayers()):
+        max_duration(max_dur), durations(dur), layers(layers) {}
     distance_visitor(const distance_visitor& other) = default;
     virtual ~distance_visitor();
 
@@ -310,7 +455,7 @@ struct distance_visitor : virtual public boost::dijkstra_visitor<> {
      */
     template<typename G>
     void examine_vertex(typename boost::graph_traits<G>::vertex_descriptor u, const G&) {
-        if (durations[u] > max_duration)
+        if (durations[layers[u]] > max_duration)
             throw DestinationFound();
     }
 };
@@ -329,8 +474,9 @@ struct printer_distance_visitor : public distance_visitor {
         file_edge << std::setprecision(16) << "idx; lat from; lon from; lat to; long to; wkt; duration; edge" << std::endl;
     }
 
-    printer_distance_visitor(time_duration max_dur, const std::vector<time_duration>& dur, const std::string& name) :
-        distance_visitor(max_dur, dur), name(name) {
+    printer_distance_visitor(time_duration max_dur, const std::vector<time_duration>& dur,
+                             const ModeLayers& layers, const std::string& name) :
+        distance_visitor(max_dur, dur, layers), name(name) {
         init_files();
     }
 
@@ -355,7 +501,7 @@ struct printer_distance_visitor : public distance_visitor {
         file_edge << cpt_e++ << ";" << g[boost::source(e, g)].coord << ";" << g[boost::target(e, g)].coord
                   << ";LINESTRING(" << g[boost::source(e, g)].coord.lon() << " " << g[boost::source(e, g)].coord.lat()
                   << ", " << g[boost::target(e, g)].coord.lon() << " " << g[boost::target(e, g)].coord.lat() << ")"
-                  << ";" << this->durations[boost::source(e, g)].total_seconds() << ";" << e
+                  << ";" << this->durations[this->layers[boost::source(e, g)]].total_seconds() << ";" << e
                   << std::endl;
     }
 };
@@ -398,8 +544,9 @@ struct target_unique_visitor : public boost::dijkstra_visitor<> {
 struct distance_or_target_visitor: virtual public distance_visitor, virtual public target_all_visitor {
     distance_or_target_visitor(const time_duration& max_dur,
                                const std::vector<time_duration>& dur,
+                               const ModeLayers& layers,
                                const std::vector<vertex_t>& destinations):
-        distance_visitor(max_dur, dur), target_all_visitor(destinations) {}
+        distance_visitor(max_dur, dur, layers), target_all_visitor(destinations) {}
     distance_or_target_visitor(const distance_or_target_visitor& other) = default;
     virtual ~distance_or_target_visitor();
     template <typename graph_type>
@@ -419,9 +566,10 @@ struct printer_distance_or_target_visitor:
         virtual public target_all_visitor {
     printer_distance_or_target_visitor(const time_duration& max_dur,
                                const std::vector<time_duration>& dur,
+                               const ModeLayers& layers,
                                const std::vector<vertex_t>& destinations,
                                const std::string& name):
-        printer_distance_visitor(max_dur, dur, name), target_all_visitor(destinations) {}
+        printer_distance_visitor(max_dur, dur, layers, name), target_all_visitor(destinations) {}
     printer_distance_or_target_visitor(const printer_distance_or_target_visitor& other) = default;
     virtual ~printer_distance_or_target_visitor();
     template <typename graph_type>
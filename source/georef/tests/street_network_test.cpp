@@ -171,3 +171,217 @@ BOOST_AUTO_TEST_CASE(idempotence) {
         BOOST_CHECK(first_res == other_res);
     }
 }
+
+/*
+ * A 10x10 grid of vertices 100m apart, the edges of a street have different
+ * durations in both directions and some streets are one way
+ */
+static void build_grid(GraphBuilder& b) {
+    const size_t square_size(10);
+    for (size_t i = 0; i < square_size ; ++i) {
+        for (size_t j = 0; j < square_size ; ++j) {
+            b(get_name(i, j), i * 100, j * 100);
+        }
+    }
+    for (size_t i = 0; i < square_size; ++i) {
+        for (size_t j = 0; j < square_size; ++j) {
+            const auto name = get_name(i, j);
+            if (j + 1 < square_size) {
+                b.add_edge(name, get_name(i, j + 1), navitia::seconds(50 + (i * 7 + j * 13) % 40));
+                b.add_edge(get_name(i, j + 1), name, navitia::seconds(50 + (i * 11 + j * 3) % 40));
+            }
+            if (i + 1 < square_size) {
+                b.add_edge(name, get_name(i + 1, j), navitia::seconds(50 + (i * 5 + j * 17) % 40));
+                // a one way street
+                if ((i + j) % 4 != 0) {
+                    b.add_edge(get_name(i + 1, j), name, navitia::seconds(50 + (i * 3 + j * 7) % 40));
+                }
+            }
+        }
+    }
+    b.geo_ref.init();
+    b.geo_ref.build_proximity_list();
+}
+
+// the direct paths found with the contraction hierarchy have the same duration as with the dijkstra
+BOOST_AUTO_TEST_CASE(contraction_hierarchy_direct_path) {
+    GraphBuilder b;
+    build_grid(b);
+
+    GeoRef ch_geo_ref(b.geo_ref);
+    build_contraction_hierarchies(ch_geo_ref, {type::Mode_e::Walking});
+    BOOST_REQUIRE(! ch_geo_ref.contraction_hierarchies[type::Mode_e::Walking].empty());
+    BOOST_CHECK(ch_geo_ref.contraction_hierarchies[type::Mode_e::Car].empty());
+
+    StreetNetwork dijkstra_worker(b.geo_ref);
+    StreetNetwork ch_worker(ch_geo_ref);
+    auto origin = nt::EntryPoint();
+    auto destination = nt::EntryPoint();
+    origin.streetnetwork_params.max_duration = 3600_s;
+    destination.streetnetwork_params.max_duration = 3600_s;
+    const std::vector<std::pair<double, double>> coords = {{10, 20}, {830, 470}, {450, 130}, {120, 890}, {700, 700}};
+    for (const auto& from: coords) {
+        for (const auto& to: coords) {
+            origin.coordinates.set_xy(from.first, from.second);
+            destination.coordinates.set_xy(to.first, to.second);
+            dijkstra_worker.init(origin, destination);
+            ch_worker.init(origin, destination);
+            const auto expected = dijkstra_worker.get_direct_path(origin, destination);
+            const auto path = ch_worker.get_direct_path(origin, destination);
+            BOOST_CHECK_EQUAL(path.duration, expected.duration);
+            BOOST_CHECK_EQUAL(path.path_items.empty(), expected.path_items.empty());
+        }
+    }
+
+    // a short max duration prevents the path as with the dijkstra
+    origin.coordinates.set_xy(10, 20);
+    destination.coordinates.set_xy(830, 470);
+    origin.streetnetwork_params.max_duration = 60_s;
+    destination.streetnetwork_params.max_duration = 60_s;
+    ch_worker.init(origin, destination);
+    BOOST_CHECK(ch_worker.get_direct_path(origin, destination).path_items.empty());
+}
+
+// the matrix is the same as with one get_duration_with_dijkstra by origin,
+// with or without contraction hierarchy, whatever the speed and the number of threads
+BOOST_AUTO_TEST_CASE(street_network_routing_matrix) {
+    GraphBuilder b;
+    build_grid(b);
+
+    GeoRef ch_geo_ref(b.geo_ref);
+    build_contraction_hierarchies(ch_geo_ref, {type::Mode_e::Walking});
+
+    auto make_coords = [](const std::vector<std::pair<double, double>>& xys) {
+        std::vector<type::GeographicalCoord> coords;
+        for (const auto& xy: xys) {
+            coords.emplace_back(xy.first, xy.second, false);
+        }
+        return coords;
+    };
+    const auto origins = make_coords({{10, 20}, {830, 470}, {450, 130}, {120, 890}, {700, 700}});
+    // the last destination is too far from the graph to be projected
+    const auto destinations = make_coords({{10, 20}, {20, 25}, {900, 900}, {450, 130}, {300, 520}, {1e6, 1e6}});
+    const auto radius = 600_s;
+
+    for (const float speed_factor: {1.f, 1.3f}) {
+        PathFinder dijkstra_path_finder(b.geo_ref);
+        std::vector<std::vector<RoutingElement>> expected;
+        for (const auto& origin: origins) {
+            dijkstra_path_finder.init(origin, type::Mode_e::Walking, speed_factor);
+            const auto durations = dijkstra_path_finder.get_duration_with_dijkstra(radius, destinations);
+            expected.emplace_back();
+            for (const auto& destination: destinations) {
+                expected.back().push_back(durations.at(destination.uri()));
+            }
+        }
+
+        for (const auto* geo_ref: {&b.geo_ref, &ch_geo_ref}) {
+            for (const size_t nb_threads: {1, 3}) {
+                std::vector<std::unique_ptr<PathFinder>> owned_path_finders;
+                std::vector<PathFinder*> path_finders;
+                for (size_t i = 0; i < nb_threads; ++i) {
+                    owned_path_finders.emplace_back(new PathFinder(*geo_ref));
+                    path_finders.push_back(owned_path_finders.back().get());
+                }
+                const auto matrix = compute_routing_matrix(path_finders, origins, destinations,
+                                                           type::Mode_e::Walking, speed_factor, radius);
+                BOOST_REQUIRE_EQUAL(matrix.size(), expected.size());
+                for (size_t i = 0; i < matrix.size(); ++i) {
+                    BOOST_REQUIRE_EQUAL(matrix[i].size(), expected[i].size());
+                    for (size_t j = 0; j < matrix[i].size(); ++j) {
+                        BOOST_CHECK(matrix[i][j].routing_status == expected[i][j].routing_status);
+                        BOOST_CHECK_EQUAL(matrix[i][j].time_duration, expected[i][j].time_duration);
+                    }
+                }
+            }
+        }
+        BOOST_CHECK(expected[0][5].routing_status == RoutingStatus_e::unknown);
+        BOOST_CHECK(expected[0][2].routing_status == RoutingStatus_e::unreached);
+        BOOST_CHECK(expected[0][1].routing_status == RoutingStatus_e::reached);
+    }
+}
+
+// the dijkstra on the compressed sparse row copy of the graph gives the same
+// distances and predecessors as on the adjacency list
+BOOST_AUTO_TEST_CASE(csr_graph_dijkstra) {
+    GraphBuilder b;
+    build_grid(b);
+    BOOST_CHECK(! b.geo_ref.has_csr_graph());
+
+    GeoRef csr_geo_ref(b.geo_ref);
+    csr_geo_ref.build_csr_graph();
+    BOOST_REQUIRE(csr_geo_ref.has_csr_graph());
+    BOOST_CHECK_EQUAL(boost::num_edges(csr_geo_ref.csr_graph), boost::num_edges(b.geo_ref.graph));
+
+    PathFinder adjacency_list_path_finder(b.geo_ref);
+    PathFinder csr_path_finder(csr_geo_ref);
+    for (const auto mode: {type::Mode_e::Walking, type::Mode_e::Bike, type::Mode_e::Car}) {
+        for (const auto& xy: std::vector<std::pair<double, double>>{{10, 20}, {830, 470}, {120, 890}}) {
+            const type::GeographicalCoord coord(xy.first, xy.second, false);
+            adjacency_list_path_finder.init(coord, mode, 1.5);
+            csr_path_finder.init(coord, mode, 1.5);
+            adjacency_list_path_finder.start_distance_dijkstra(600_s);
+            csr_path_finder.start_distance_dijkstra(600_s);
+            BOOST_CHECK(adjacency_list_path_finder.distances == csr_path_finder.distances);
+            BOOST_CHECK(adjacency_list_path_finder.predecessors == csr_path_finder.predecessors);
+        }
+    }
+
+    // the GeoRef drops the copy when it modifies the graph
+    csr_geo_ref.init();
+    BOOST_CHECK(! csr_geo_ref.has_csr_graph());
+}
+
+// the state of a path finder only holds the graphs used by its mode
+BOOST_AUTO_TEST_CASE(path_finder_mode_layers) {
+    GraphBuilder b;
+    b("a", 0, 0)("b", 0, 100)("c", 100, 100);
+    b("a", "b", 100_s)("b", "c", 100_s);
+    b.geo_ref.init();
+    b.geo_ref.build_proximity_list();
+    const size_t n = b.geo_ref.nb_vertex_by_mode;
+    BOOST_REQUIRE_EQUAL(boost::num_vertices(b.geo_ref.graph), 3 * n);
+
+    PathFinder path_finder(b.geo_ref);
+    path_finder.init({0, 10, true}, type::Mode_e::Walking, 1);
+    BOOST_CHECK_EQUAL(path_finder.distances.size(), n);
+    BOOST_CHECK_EQUAL(path_finder.layers[2], size_t(2));
+    path_finder.start_distance_dijkstra(600_s);
+    BOOST_CHECK_NE(path_finder.distances[path_finder.layers[b.get("c")]], bt::pos_infin);
+
+    path_finder.init({0, 10, true}, type::Mode_e::Bike, 1);
+    BOOST_CHECK_EQUAL(path_finder.distances.size(), n);
+    BOOST_CHECK_EQUAL(path_finder.layers[b.geo_ref.offsets[type::Mode_e::Bike] + 2], size_t(2));
+
+    // car and bss use the walking graph and their own one
+    path_finder.init({0, 10, true}, type::Mode_e::Car, 1);
+    BOOST_CHECK_EQUAL(path_finder.distances.size(), 2 * n);
+    BOOST_CHECK_EQUAL(path_finder.layers[2], size_t(2));
+    BOOST_CHECK_EQUAL(path_finder.layers[b.geo_ref.offsets[type::Mode_e::Car] + 2], n + 2);
+
+    path_finder.init({0, 10, true}, type::Mode_e::Bss, 1);
+    BOOST_CHECK_EQUAL(path_finder.distances.size(), 2 * n);
+    BOOST_CHECK_EQUAL(path_finder.layers[b.geo_ref.offsets[type::Mode_e::Bike] + 2], n + 2);
+}
+
+// a path finder reused for several searches only resets what the previous
+// one has touched, and gives the same results as a new one
+BOOST_AUTO_TEST_CASE(path_finder_reuse) {
+    GraphBuilder b;
+    build_grid(b);
+
+    PathFinder reused_path_finder(b.geo_ref);
+    const std::vector<std::pair<double, double>> coords = {{10, 20}, {830, 470}, {450, 130}, {120, 890}, {700, 700}};
+    for (const auto radius: {300_s, 3600_s, 120_s}) {
+        for (const auto& xy: coords) {
+            const type::GeographicalCoord coord(xy.first, xy.second, false);
+            PathFinder new_path_finder(b.geo_ref);
+            new_path_finder.init(coord, type::Mode_e::Walking, 1);
+            new_path_finder.start_distance_dijkstra(radius);
+            reused_path_finder.init(coord, type::Mode_e::Walking, 1);
+            reused_path_finder.start_distance_dijkstra(radius);
+            BOOST_CHECK(new_path_finder.distances == reused_path_finder.distances);
+            BOOST_CHECK_LE(reused_path_finder.touched.size(), reused_path_finder.distances.size() + 4);
+        }
+    }
+}
@@ -834,6 +834,10 @@ instance_status = {
     "is_realtime_loaded": fields.Boolean(),
     "realtime_proxies": fields.Raw(),
     "dataset_created_at": fields.String(),
+    "raptor_cache_nb_calls": fields.Integer(),
+    "raptor_cache_nb_cache_miss": fields.Integer(),
+    "raptor_cache_nb_builds": fields.Integer(),
+    "raptor_cache_build_time_ms": fields.Integer(),
 }
 
 instance_parameters = {
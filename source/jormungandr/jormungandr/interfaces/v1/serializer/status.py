@@ -96,6 +96,10 @@ class StatusSerializer(serpy.DictSerializer):
     nb_threads = Field(schema_type=int)
     parameters = ParametersSerializer()
     publication_date = Field(schema_type=str)
+    raptor_cache_build_time_ms = Field(schema_type=int)
+    raptor_cache_nb_builds = Field(schema_type=int)
+    raptor_cache_nb_cache_miss = Field(schema_type=int)
+    raptor_cache_nb_calls = Field(schema_type=int)
     realtime_contributors = MethodField(schema_type=str, many=True, display_none=True)
     realtime_proxies = StringListField(display_none=True)
     start_production_date = Field(schema_type=str)
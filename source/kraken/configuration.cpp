@@ -56,6 +56,13 @@ po::options_description get_options_description(const boost::optional<std::strin
          "name of the instance")
 
         ("GENERAL.nb_threads", po::value<int>()->default_value(1), "number of workers threads")
+        ("GENERAL.dispatch_mode", po::value<std::string>()->default_value("zmq"),
+                                  "dispatch of the requests to the workers: 'zmq' for the load balancer, "
+                                  "'queue' for a lock-free queue consumed by the workers")
+        ("GENERAL.dispatch_queue_size", po::value<int>()->default_value(1024),
+                                  "maximum number of requests waiting for a worker with the queue dispatch")
+        ("GENERAL.dispatch_metrics_period", po::value<int>()->default_value(60),
+                                  "period in seconds of the report of the queue dispatch metrics")
         ("GENERAL.is_realtime_enabled", po::value<bool>()->default_value(false),
                                         "enable loading of realtime data")
         ("GENERAL.kirin_timeout", po::value<int>()->default_value(60000),
@@ -69,6 +76,20 @@ po::options_description get_options_description(const boost::optional<std::strin
              po::value<bool>()->default_value(*display_contributors) : po::value<bool>()->default_value(false),
          "display all contributors in feed publishers")
         ("GENERAL.raptor_cache_size", po::value<int>()->default_value(10), "maximum number of stored raptor caches")
+        ("GENERAL.raptor_cache_prewarm_days", po::value<int>()->default_value(0),
+                                  "number of days, from today, whose raptor caches are built before "
+                                  "using a new data, 0 to build them on the first request")
+        ("GENERAL.raptor_cache_prewarm_threads", po::value<int>()->default_value(1),
+                                  "number of threads building the raptor caches before using a new data")
+        ("GENERAL.autocomplete_cache_size", po::value<int>()->default_value(1000000),
+                                  "maximum number of ids kept by the cache of the autocomplete searches")
+        ("GENERAL.nb_journey_threads", po::value<int>()->default_value(1),
+                                  "number of threads computing the datetimes of a multi-datetimes journeys request")
+        ("GENERAL.nb_raptor_round_threads", po::value<int>()->default_value(1),
+                                  "number of threads scanning the journey patterns of a raptor round, "
+                                  "useful for large isochrones and heat maps")
+        ("GENERAL.nb_matrix_threads", po::value<int>()->default_value(1),
+                                  "number of threads computing the rows of a street network routing matrix")
         ("GENERAL.log_level", po::value<std::string>(), "log level of kraken")
         ("GENERAL.log_format", po::value<std::string>()->default_value("[%D{%y-%m-%d %H:%M:%S,%q}] [%p] [%x] - %m %b:%L  %n"), "log format")
 
@@ -145,6 +166,39 @@ int Configuration::nb_threads() const{
     return size_t(nb_threads);
 }
 
+std::string Configuration::dispatch_mode() const{
+    if (! vm.count("GENERAL.dispatch_mode")) {
+        return "zmq";
+    }
+    const auto dispatch_mode = vm["GENERAL.dispatch_mode"].as<std::string>();
+    if (dispatch_mode != "zmq" && dispatch_mode != "queue") {
+        throw std::invalid_argument("dispatch_mode must be 'zmq' or 'queue'");
+    }
+    return dispatch_mode;
+}
+
+size_t Configuration::dispatch_queue_size() const{
+    if (! vm.count("GENERAL.dispatch_queue_size")) {
+        return 1024;
+    }
+    int dispatch_queue_size = vm["GENERAL.dispatch_queue_size"].as<int>();
+    if (dispatch_queue_size < 1) {
+        throw std::invalid_argument("dispatch_queue_size must be strictly positive");
+    }
+    return size_t(dispatch_queue_size);
+}
+
+int Configuration::dispatch_metrics_period() const{
+    if (! vm.count("GENERAL.dispatch_metrics_period")) {
+        return 60;
+    }
+    int dispatch_metrics_period = vm["GENERAL.dispatch_metrics_period"].as<int>();
+    if (dispatch_metrics_period < 1) {
+        throw std::invalid_argument("dispatch_metrics_period must be strictly positive");
+    }
+    return dispatch_metrics_period;
+}
+
 bool Configuration::is_realtime_enabled() const{
     return this->vm["GENERAL.is_realtime_enabled"].as<bool>();
 }
@@ -213,6 +267,72 @@ size_t Configuration::raptor_cache_size() const{
     return size_t(raptor_cache_size);
 }
 
+size_t Configuration::autocomplete_cache_size() const{
+    if (! vm.count("GENERAL.autocomplete_cache_size")) {
+        return 1000000;
+    }
+    int autocomplete_cache_size = vm["GENERAL.autocomplete_cache_size"].as<int>();
+    if (autocomplete_cache_size < 0) {
+        throw std::invalid_argument("autocomplete_cache_size must be positive");
+    }
+    return size_t(autocomplete_cache_size);
+}
+
+size_t Configuration::raptor_cache_prewarm_days() const{
+    if (! vm.count("GENERAL.raptor_cache_prewarm_days")) {
+        return 0;
+    }
+    int raptor_cache_prewarm_days = vm["GENERAL.raptor_cache_prewarm_days"].as<int>();
+    if (raptor_cache_prewarm_days < 0) {
+        throw std::invalid_argument("raptor_cache_prewarm_days must be positive");
+    }
+    return size_t(raptor_cache_prewarm_days);
+}
+
+size_t Configuration::raptor_cache_prewarm_threads() const{
+    if (! vm.count("GENERAL.raptor_cache_prewarm_threads")) {
+        return 1;
+    }
+    int raptor_cache_prewarm_threads = vm["GENERAL.raptor_cache_prewarm_threads"].as<int>();
+    if (raptor_cache_prewarm_threads < 1) {
+        throw std::invalid_argument("raptor_cache_prewarm_threads must be strictly positive");
+    }
+    return size_t(raptor_cache_prewarm_threads);
+}
+
+size_t Configuration::nb_journey_threads() const{
+    if (! vm.count("GENERAL.nb_journey_threads")) {
+        return 1;
+    }
+    int nb_journey_threads = vm["GENERAL.nb_journey_threads"].as<int>();
+    if (nb_journey_threads < 1) {
+        throw std::invalid_argument("nb_journey_threads must be strictly positive");
+    }
+    return size_t(nb_journey_threads);
+}
+
+size_t Configuration::nb_matrix_threads() const{
+    if (! vm.count("GENERAL.nb_matrix_threads")) {
+        return 1;
+    }
+    int nb_matrix_threads = vm["GENERAL.nb_matrix_threads"].as<int>();
+    if (nb_matrix_threads < 1) {
+        throw std::invalid_argument("nb_matrix_threads must be strictly positive");
+    }
+    return size_t(nb_matrix_threads);
+}
+
+size_t Configuration::nb_raptor_round_threads() const{
+    if (! vm.count("GENERAL.nb_raptor_round_threads")) {
+        return 1;
+    }
+    int nb_raptor_round_threads = vm["GENERAL.nb_raptor_round_threads"].as<int>();
+    if (nb_raptor_round_threads < 1) {
+        throw std::invalid_argument("nb_raptor_round_threads must be strictly positive");
+    }
+    return size_t(nb_raptor_round_threads);
+}
+
 boost::optional<std::string> Configuration::log_level() const{
     boost::optional<std::string> result;
     if (this->vm.count("GENERAL.log_level") > 0) {
@@ -46,6 +46,9 @@ namespace navitia { namespace kraken{
             std::string instance_name() const;
             boost::optional<std::string> chaos_database() const;
             int nb_threads() const;
+            std::string dispatch_mode() const;
+            size_t dispatch_queue_size() const;
+            int dispatch_metrics_period() const;
 
             std::string broker_host() const;
             int broker_port() const;
@@ -60,6 +63,12 @@ namespace navitia { namespace kraken{
             int kirin_retry_timeout() const;
             bool display_contributors() const;
             size_t raptor_cache_size() const;
+            size_t raptor_cache_prewarm_days() const;
+            size_t raptor_cache_prewarm_threads() const;
+            size_t autocomplete_cache_size() const;
+            size_t nb_journey_threads() const;
+            size_t nb_raptor_round_threads() const;
+            size_t nb_matrix_threads() const;
             int slow_request_duration() const;
             boost::optional<std::string> log_level() const;
             boost::optional<std::string> log_format() const;
@@ -40,6 +40,7 @@ www.navitia.io
 #include <memory>
 #include <iostream>
 #include <atomic>
+#include <functional>
 #include <boost/make_shared.hpp>
 #include <boost/optional.hpp>
 
@@ -88,15 +89,19 @@ public:
         return std::move(data);
     }
 
+    // before_switch is called on the loaded data before it replaces
+    // the current one, e.g. to warm it up
     bool load(const std::string& database,
               const boost::optional<std::string>& chaos_database = boost::none,
               const std::vector<std::string>& contributors = {},
-              const size_t raptor_cache_size = 10){
+              const size_t raptor_cache_size = 10,
+              const std::function<void(Data&)>& before_switch = {}){
         bool success;
         ++ data_identifier;
         auto data = create_data(data_identifier.load());
         success = data->load(database, chaos_database, contributors, raptor_cache_size);
         if (success) {
+            if (before_switch) { before_switch(*data); }
             set_data(std::move(data));
         }
         return success;
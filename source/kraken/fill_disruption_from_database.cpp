@@ -174,6 +174,7 @@ void DisruptionDatabaseReader::finalize() {
         make_and_apply_disruption(*disruption, pt_data, meta);
     }
     pt_data.clean_weak_impacts();
+    pt_data.clean_unused_validity_patterns();
 }
 
 }
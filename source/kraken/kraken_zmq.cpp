@@ -94,6 +94,34 @@ int main(int argn, char** argv){
     zmq::context_t context(1);
     // Catch startup exceptions; without this, startup errors are on stdout
     std::string zmq_socket = conf.zmq_socket_path();
+    int nb_threads = conf.nb_threads();
+
+    if (conf.dispatch_mode() == "queue") {
+        RequestQueue queue(conf.dispatch_queue_size(), nb_threads);
+        zmq::socket_t frontend(context, ZMQ_ROUTER);
+        try{
+            frontend.bind(zmq_socket.c_str());
+        }catch(zmq::error_t& e){
+            LOG4CPLUS_ERROR(logger, "zmq::socket_t::bind() failure: " << e.what());
+            return 1;
+        }
+
+        threads.create_thread(navitia::MaintenanceWorker(data_manager, conf));
+
+        LOG4CPLUS_INFO(logger, "starting workers threads consuming the request queue");
+        for(int thread_nbr = 0; thread_nbr < nb_threads; ++thread_nbr) {
+            threads.create_thread(std::bind(&doWorkFromQueue, std::ref(queue), size_t(thread_nbr),
+                                            std::ref(data_manager), conf));
+        }
+
+        const auto metrics_period = boost::posix_time::seconds(conf.dispatch_metrics_period());
+        do{
+            try{
+                run_queue_frontend(frontend, queue, metrics_period);
+            }catch(const zmq::error_t&){}//on SIGHUP, we restart the frontend
+        }while(true);
+    }
+
     //TODO: try/catch
     LoadBalancer lb(context);
     try{
@@ -105,7 +133,6 @@ int main(int argn, char** argv){
 
     threads.create_thread(navitia::MaintenanceWorker(data_manager, conf));
 
-    int nb_threads = conf.nb_threads();
     // Launch pool of worker threads
     LOG4CPLUS_INFO(logger, "starting workers threads");
     for(int thread_nbr = 0; thread_nbr < nb_threads; ++thread_nbr) {
@@ -119,4 +146,3 @@ int main(int argn, char** argv){
         }catch(const zmq::error_t&){}//lors d'un SIGHUP on restore la queue
     }while(true);
 }
-
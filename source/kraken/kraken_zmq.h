@@ -32,18 +32,23 @@ www.navitia.io
 #include "worker.h"
 #include "maintenance_worker.h"
 #include "kraken/data_manager.h"
+#include "kraken/mpmc_queue.h"
 #include "utils/logger.h"
 #include <utils/zmq.h>
 #include <boost/date_time/posix_time/posix_time.hpp>
 #include "kraken/configuration.h"
 #include "type/meta_data.h"
 #include <log4cplus/ndc.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
 
 
-static void respond(zmq::socket_t& socket,
-             const std::string& address,
-             const pbnavitia::Response& response){
-    zmq::message_t reply(response.ByteSize());
+static void serialize_response(const pbnavitia::Response& response, zmq::message_t& reply){
+    reply.rebuild(response.ByteSize());
     try{
         response.SerializeToArray(reply.data(), response.ByteSize());
     }catch(const google::protobuf::FatalException& e){
@@ -55,17 +60,73 @@ static void respond(zmq::socket_t& socket,
         reply.rebuild(error_response.ByteSize());
         error_response.SerializeToArray(reply.data(), error_response.ByteSize());
     }
+}
+
+static void send_reply(zmq::socket_t& socket,
+                       const std::string& address,
+                       zmq::message_t& reply){
     z_send(socket, address, ZMQ_SNDMORE);
     z_send(socket, "", ZMQ_SNDMORE);
     socket.send(reply);
 }
 
 namespace pt = boost::posix_time;
+
+// Computes the response of a serialized request in reply
+inline void process_request(navitia::Worker& w,
+                            DataManager<navitia::type::Data>& data_manager,
+                            const zmq::message_t& request,
+                            const pt::time_duration& slow_request_duration,
+                            zmq::message_t& reply) {
+    auto logger = log4cplus::Logger::getInstance("worker");
+    pbnavitia::Request pb_req;
+    pt::ptime start = pt::microsec_clock::universal_time();
+    pbnavitia::API api = pbnavitia::UNKNOWN_API;
+    if(!pb_req.ParseFromArray(request.data(), request.size())){
+        LOG4CPLUS_WARN(logger, "receive invalid protobuf");
+        pbnavitia::Response response;
+        auto* error = response.mutable_error();
+        error->set_id(pbnavitia::Error::invalid_protobuf_request);
+        error->set_message("receive invalid protobuf");
+        serialize_response(response, reply);
+        return;
+    }
+    api = pb_req.requested_api();
+    log4cplus::NDCContextCreator ndc(pb_req.request_id());
+    if(api != pbnavitia::METADATAS){
+        LOG4CPLUS_DEBUG(logger, "receive request: " << pb_req.DebugString());
+    }
+    const auto data = data_manager.get_data();
+    try {
+        w.dispatch(pb_req, *data);
+        if(api != pbnavitia::METADATAS){
+            LOG4CPLUS_TRACE(logger, "response: " << w.pb_creator.get_response().DebugString());
+        }
+    } catch (const navitia::recoverable_exception& e) {
+        //on a recoverable an internal server error is returned
+        LOG4CPLUS_ERROR(logger, "internal server error: " << e.what());
+        LOG4CPLUS_ERROR(logger, "on query: " << pb_req.DebugString());
+        LOG4CPLUS_ERROR(logger, "backtrace: " << e.backtrace());
+        w.pb_creator.fill_pb_error(pbnavitia::Error::internal_error, e.what());
+    }
+    if (! data->loaded){
+        w.pb_creator.set_publication_date(boost::gregorian::not_a_date_time);
+    } else {
+        w.pb_creator.set_publication_date(data->meta->publication_date);
+    }
+    serialize_response(w.pb_creator.get_response(), reply);
+    auto duration = pt::microsec_clock::universal_time() - start;
+    if(duration >= slow_request_duration){
+        LOG4CPLUS_WARN(logger, "slow request! duration: " << duration.total_milliseconds()
+                            << "ms request: " << pb_req.DebugString());
+    }else if(api != pbnavitia::METADATAS){
+        LOG4CPLUS_DEBUG(logger, "processing time : " << duration.total_milliseconds());
+    }
+}
+
 inline void doWork(zmq::context_t& context,
                    DataManager<navitia::type::Data>& data_manager,
                    navitia::kraken::Configuration conf) {
-    auto logger = log4cplus::Logger::getInstance("worker");
-
     zmq::socket_t socket (context, ZMQ_REQ);
     socket.connect("inproc://workers");
     bool run = true;
@@ -87,49 +148,212 @@ inline void doWork(zmq::context_t& context,
             //on gére le cas du sighup durant un recv
             continue;
         }
+        zmq::message_t reply;
+        process_request(w, data_manager, request, slow_request_duration, reply);
+        send_reply(socket, address, reply);
+    }
+}
 
-        pbnavitia::Request pb_req;
-        pt::ptime start = pt::microsec_clock::universal_time();
-        pbnavitia::API api = pbnavitia::UNKNOWN_API;
-        if(!pb_req.ParseFromArray(request.data(), request.size())){
-            LOG4CPLUS_WARN(logger, "receive invalid protobuf");
-            pbnavitia::Response response;
-            auto* error = response.mutable_error();
-            error->set_id(pbnavitia::Error::invalid_protobuf_request);
-            error->set_message("receive invalid protobuf");
-            respond(socket, address, response);
-            continue;
+/*
+ * Dispatch of the requests without the LoadBalancer (dispatch_mode=queue)
+ *
+ * The frontend thread owns the ROUTER socket: it only reads the zmq
+ * envelope of the requests and pushes them in a lock-free queue
+ * consumed by the workers. The workers push their replies in another
+ * queue and wake up the frontend with an eventfd, polled along with
+ * the socket, the frontend then sending the replies.
+ */
+struct QueuedMessage {
+    std::string address;
+    zmq::message_t message;
+    pt::ptime queued_at;
+};
+
+struct WorkerMetrics {
+    std::atomic<size_t> nb_requests{0};
+    // time spent by the requests in the queue
+    std::atomic<uint64_t> waiting_time_us{0};
+    std::atomic<uint64_t> processing_time_us{0};
+    std::atomic<uint64_t> max_processing_time_us{0};
+};
+
+class RequestQueue {
+    navitia::MpmcQueue<QueuedMessage> requests;
+    navitia::MpmcQueue<QueuedMessage> replies;
+    std::vector<std::unique_ptr<WorkerMetrics>> metrics;
+    std::atomic<size_t> max_depth{0};
+
+    // the idle workers sleep on the condition variable
+    std::mutex mutex;
+    std::condition_variable condition;
+    std::atomic<size_t> nb_sleeping_workers{0};
+
+    // written by the workers when a reply is ready
+    const int reply_fd;
+
+public:
+    // there can't be more replies than requests queued or processed
+    RequestQueue(size_t capacity, size_t nb_workers):
+        requests(capacity), replies(capacity + nb_workers), reply_fd(eventfd(0, EFD_NONBLOCK)) {
+        if (reply_fd < 0) {
+            throw navitia::exception("impossible to create the eventfd of the request queue");
         }
-        api = pb_req.requested_api();
-        log4cplus::NDCContextCreator ndc(pb_req.request_id());
-        if(api != pbnavitia::METADATAS){
-            LOG4CPLUS_DEBUG(logger, "receive request: " << pb_req.DebugString());
+        for (size_t i = 0; i < nb_workers; ++i) {
+            metrics.push_back(std::make_unique<WorkerMetrics>());
+        }
+    }
+    ~RequestQueue() { close(reply_fd); }
+
+    int get_reply_fd() const { return reply_fd; }
+
+    // Called by the frontend, returns false if the queue is full
+    bool push_request(QueuedMessage&& request) {
+        if (! requests.try_push(std::move(request))) { return false; }
+        const size_t depth = requests.size();
+        size_t current_max = max_depth.load();
+        while (depth > current_max && ! max_depth.compare_exchange_weak(current_max, depth)) {}
+
+        // pairs with the fence of pop_request: either the worker sees
+        // the request, or we see it sleeping
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (nb_sleeping_workers.load() > 0) {
+            std::lock_guard<std::mutex> lock(mutex);
+            condition.notify_one();
         }
-        const auto data = data_manager.get_data();
-        try {
-            w.dispatch(pb_req, *data);
-            if(api != pbnavitia::METADATAS){
-                LOG4CPLUS_TRACE(logger, "response: " << w.pb_creator.get_response().DebugString());
+        return true;
+    }
+
+    // Called by the workers, blocks until a request is available
+    QueuedMessage pop_request() {
+        QueuedMessage request;
+        for (size_t nb_tries = 0; ; ++nb_tries) {
+            if (requests.try_pop(request)) { return request; }
+            if (nb_tries < 100) {
+                std::this_thread::yield();
+                continue;
             }
-        } catch (const navitia::recoverable_exception& e) {
-            //on a recoverable an internal server error is returned
-            LOG4CPLUS_ERROR(logger, "internal server error: " << e.what());
-            LOG4CPLUS_ERROR(logger, "on query: " << pb_req.DebugString());
-            LOG4CPLUS_ERROR(logger, "backtrace: " << e.backtrace());
-            w.pb_creator.fill_pb_error(pbnavitia::Error::internal_error, e.what());
+            std::unique_lock<std::mutex> lock(mutex);
+            ++nb_sleeping_workers;
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            condition.wait(lock, [&]() { return requests.size() > 0; });
+            --nb_sleeping_workers;
+            nb_tries = 0;
+        }
+    }
+
+    // Called by the workers
+    void push_reply(QueuedMessage&& reply) {
+        while (! replies.try_push(std::move(reply))) {
+            std::this_thread::yield();
         }
-        if (! data->loaded){
-            w.pb_creator.set_publication_date(boost::gregorian::not_a_date_time);
-        } else {
-            w.pb_creator.set_publication_date(data->meta->publication_date);
+        const uint64_t one = 1;
+        // the write can only fail if the counter overflows, the
+        // frontend being already woken up
+        if (write(reply_fd, &one, sizeof(one)) < 0) {}
+    }
+
+    // Called by the frontend when reply_fd is readable
+    template<typename F>
+    void consume_replies(F f) {
+        uint64_t nb;
+        if (read(reply_fd, &nb, sizeof(nb)) < 0) {}
+        QueuedMessage reply;
+        while (replies.try_pop(reply)) { f(reply); }
+    }
+
+    WorkerMetrics& get_metrics(size_t worker_idx) { return *metrics.at(worker_idx); }
+
+    void log_metrics(log4cplus::Logger& logger) {
+        LOG4CPLUS_INFO(logger, "request queue depth: " << requests.size()
+                       << ", max since last report: " << max_depth.exchange(requests.size()));
+        for (size_t i = 0; i < metrics.size(); ++i) {
+            auto& m = *metrics[i];
+            const size_t nb_requests = m.nb_requests.exchange(0);
+            if (nb_requests == 0) { continue; }
+            LOG4CPLUS_INFO(logger, "worker " << i << ": " << nb_requests << " requests"
+                           << ", mean waiting time: " << m.waiting_time_us.exchange(0) / nb_requests << "us"
+                           << ", mean processing time: " << m.processing_time_us.exchange(0) / nb_requests << "us"
+                           << ", max processing time: " << m.max_processing_time_us.exchange(0) << "us");
         }
-        respond(socket, address, w.pb_creator.get_response());
-        auto duration = pt::microsec_clock::universal_time() - start;
-        if(duration >= slow_request_duration){
-            LOG4CPLUS_WARN(logger, "slow request! duration: " << duration.total_milliseconds()
-                                << "ms request: " << pb_req.DebugString());
-        }else if(api != pbnavitia::METADATAS){
-            LOG4CPLUS_DEBUG(logger, "processing time : " << duration.total_milliseconds());
+    }
+};
+
+inline void doWorkFromQueue(RequestQueue& queue,
+                            size_t worker_idx,
+                            DataManager<navitia::type::Data>& data_manager,
+                            navitia::kraken::Configuration conf) {
+    navitia::Worker w(conf);
+    auto& metrics = queue.get_metrics(worker_idx);
+    const auto slow_request_duration = pt::milliseconds(conf.slow_request_duration());
+    for (;;) {
+        QueuedMessage request = queue.pop_request();
+        const auto start = pt::microsec_clock::universal_time();
+
+        QueuedMessage reply;
+        reply.address = std::move(request.address);
+        process_request(w, data_manager, request.message, slow_request_duration, reply.message);
+        queue.push_reply(std::move(reply));
+
+        const uint64_t processing_us = (pt::microsec_clock::universal_time() - start).total_microseconds();
+        ++metrics.nb_requests;
+        metrics.waiting_time_us += (start - request.queued_at).total_microseconds();
+        metrics.processing_time_us += processing_us;
+        uint64_t current_max = metrics.max_processing_time_us.load();
+        while (processing_us > current_max
+               && ! metrics.max_processing_time_us.compare_exchange_weak(current_max, processing_us)) {}
+    }
+}
+
+// Runs the frontend of the queue dispatch on socket, a bound ROUTER socket
+inline void run_queue_frontend(zmq::socket_t& socket,
+                               RequestQueue& queue,
+                               const pt::time_duration& metrics_period) {
+    auto logger = log4cplus::Logger::getInstance("frontend");
+    auto next_metrics = pt::microsec_clock::universal_time() + metrics_period;
+    // a request that did not fit in the full queue
+    std::unique_ptr<QueuedMessage> pending;
+    for (;;) {
+        zmq::pollitem_t items[] = {
+            {static_cast<void*>(socket), 0, ZMQ_POLLIN, 0},
+            {nullptr, queue.get_reply_fd(), ZMQ_POLLIN, 0}
+        };
+        // while a request is pending, we stop reading the socket and
+        // retry regularly, the replies being still sent
+        const size_t nb_items = pending ? 1 : 2;
+        zmq::poll(pending ? items + 1 : items, nb_items, pending ? 1 : 1000);
+
+        if (items[1].revents & ZMQ_POLLIN) {
+            queue.consume_replies([&](QueuedMessage& reply) {
+                send_reply(socket, reply.address, reply.message);
+            });
+        }
+        if (pending && queue.push_request(std::move(*pending))) {
+            pending.reset();
+        }
+        while (! pending && (items[0].revents & ZMQ_POLLIN)) {
+            // only the envelope is read, the request is parsed by the worker
+            QueuedMessage request;
+            request.address = z_recv(socket);
+            {
+                std::string empty = z_recv(socket);
+                assert(empty.size() == 0);
+            }
+            socket.recv(&request.message);
+            request.queued_at = pt::microsec_clock::universal_time();
+            if (! queue.push_request(std::move(request))) {
+                pending = std::make_unique<QueuedMessage>(std::move(request));
+            }
+            // drain the socket without polling again
+            int events = 0;
+            size_t events_size = sizeof(events);
+            socket.getsockopt(ZMQ_EVENTS, &events, &events_size);
+            items[0].revents = events & ZMQ_POLLIN ? ZMQ_POLLIN : 0;
+        }
+
+        const auto now = pt::microsec_clock::universal_time();
+        if (now >= next_metrics) {
+            queue.log_metrics(logger);
+            next_metrics = now + metrics_period;
         }
     }
 }
@@ -35,6 +35,8 @@ www.navitia.io
 #include "realtime.h"
 #include "type/task.pb.h"
 #include "type/pt_data.h"
+#include "type/meta_data.h"
+#include "routing/dataraptor.h"
 #include <boost/algorithm/string/join.hpp>
 #include <boost/optional.hpp>
 #include <sys/stat.h>
@@ -57,7 +59,11 @@ void MaintenanceWorker::load(){
     auto chaos_database = conf.chaos_database();
     auto contributors = conf.rt_topics();
     LOG4CPLUS_INFO(logger, "Loading database from file: " + database);
-    if(this->data_manager.load(database, chaos_database, contributors, conf.raptor_cache_size())){
+    auto before_switch = [&](nt::Data& data) {
+        data.build_autocomplete_cache(conf.autocomplete_cache_size());
+        prewarm_raptor_cache(data);
+    };
+    if(this->data_manager.load(database, chaos_database, contributors, conf.raptor_cache_size(), before_switch)){
         auto data = data_manager.get_data();
         data->is_realtime_loaded = false;
         data->meta->instance_name = conf.instance_name();
@@ -66,6 +72,33 @@ void MaintenanceWorker::load(){
 }
 
 
+void MaintenanceWorker::prewarm_raptor_cache(const nt::Data& data) const {
+    const size_t nb_days = conf.raptor_cache_prewarm_days();
+    if (nb_days == 0 || ! data.dataRaptor || ! data.dataRaptor->cached_next_st_manager) {
+        return;
+    }
+    const auto today = bg::day_clock::universal_day();
+    if (! data.meta->production_date.contains(today)) {
+        LOG4CPLUS_INFO(logger, "today is not in the production period, no raptor cache prewarmed");
+        return;
+    }
+    const auto from = DateTimeUtils::set((today - data.meta->production_date.begin()).days(), 0);
+
+    // the journeys are requested with or without wheelchair, on base schedule or realtime
+    nt::AccessibiliteParams wheelchair;
+    wheelchair.properties.set(nt::hasProperties::WHEELCHAIR_BOARDING, true);
+    wheelchair.vehicle_properties.set(nt::hasVehicleProperties::WHEELCHAIR_ACCESSIBLE, true);
+    const std::vector<nt::AccessibiliteParams> accessibilite_params = {nt::AccessibiliteParams(), wheelchair};
+    const std::vector<nt::RTLevel> rt_levels = {nt::RTLevel::Base, nt::RTLevel::RealTime};
+
+    const auto begin = pt::microsec_clock::universal_time();
+    data.dataRaptor->cached_next_st_manager->prewarm(from, nb_days, rt_levels, accessibilite_params,
+                                                     conf.raptor_cache_prewarm_threads());
+    const auto stats = data.dataRaptor->cached_next_st_manager->get_stats();
+    LOG4CPLUS_INFO(logger, "raptor caches prewarmed in " << pt::microsec_clock::universal_time() - begin
+                   << ", " << stats.nb_builds << " caches built in " << stats.build_time_ms << "ms");
+}
+
 void MaintenanceWorker::load_realtime(){
     if(!conf.is_realtime_enabled()){
         return;
@@ -158,6 +191,7 @@ void MaintenanceWorker::handle_task_in_batch(const std::vector<AmqpClient::Envel
 
 void MaintenanceWorker::handle_rt_in_batch(const std::vector<AmqpClient::Envelope::ptr_t>& envelopes){
     boost::shared_ptr<nt::Data> data{};
+    boost::shared_ptr<const nt::Data> previous_data{};
     pt::ptime begin = pt::microsec_clock::universal_time();
     for (auto& envelope: envelopes) {
         LOG4CPLUS_DEBUG(logger, "realtime info received!");
@@ -170,6 +204,7 @@ void MaintenanceWorker::handle_rt_in_batch(const std::vector<AmqpClient::Envelop
         LOG4CPLUS_TRACE(logger, "received entity: " << feed_message.DebugString());
         for(const auto& entity: feed_message.entity()){
             if (!data) {
+                previous_data = data_manager.get_data();
                 data = data_manager.get_data_clone();
                 data->last_rt_data_loaded = pt::microsec_clock::universal_time();
                 LOG4CPLUS_INFO(logger, "data copied in " << (data->last_rt_data_loaded - begin));
@@ -193,8 +228,12 @@ void MaintenanceWorker::handle_rt_in_batch(const std::vector<AmqpClient::Envelop
     }
     if (data) {
         data->pt_data->clean_weak_impacts();
-        LOG4CPLUS_INFO(logger, "rebuilding data raptor");
-        data->build_raptor(conf.raptor_cache_size());
+        const auto nb_cleaned_vps = data->pt_data->clean_unused_validity_patterns();
+        LOG4CPLUS_DEBUG(logger, nb_cleaned_vps << " unused validity patterns deleted");
+        LOG4CPLUS_INFO(logger, "updating data raptor");
+        data->update_raptor(*previous_data, conf.raptor_cache_size());
+        data->build_autocomplete_cache(conf.autocomplete_cache_size());
+        prewarm_raptor_cache(*data);
         data_manager.set_data(std::move(data));
         LOG4CPLUS_INFO(logger, "data updated " << envelopes.size() << " disrutpion applied in "
                                                << pt::microsec_clock::universal_time() - begin);
@@ -61,6 +61,9 @@ class MaintenanceWorker{
 
         void load_realtime();
 
+        // build the raptor caches of the next days on data, before it is used
+        void prewarm_raptor_cache(const type::Data& data) const;
+
         /*!
          * This function will consume message in batch. It calls
          * AmqpClient::Channel::BasicConsumeMessage(const std::string&, Envelope::ptr_t&, int) to try
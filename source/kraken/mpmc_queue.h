@@ -0,0 +1,134 @@
+/* Copyright © 2001-2014, Canal TP and/or its affiliates. All rights reserved.
+
+This file is part of Navitia,
+    the software to build cool stuff with public transport.
+
+Hope you'll enjoy and contribute to this project,
+    powered by Canal TP (www.canaltp.fr).
+Help us simplify mobility and open public transport:
+    a non ending quest to the responsive locomotion way of traveling!
+
+LICENCE: This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU Affero General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU Affero General Public License for more details.
+
+You should have received a copy of the GNU Affero General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+Stay tuned using
+twitter @navitia
+IRC #navitia on freenode
+https://groups.google.com/d/forum/navitia
+www.navitia.io
+*/
+
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <cstddef>
+
+namespace navitia {
+
+/**
+ * Bounded lock-free multi-producer multi-consumer queue.
+ *
+ * Each cell carries a sequence number telling whether it is ready to
+ * be written (sequence == position) or read (sequence == position + 1)
+ * for a given position of the ring. Producers and consumers reserve a
+ * position with a compare and swap on their own counter, and never
+ * block each other.
+ */
+template<typename T>
+class MpmcQueue {
+public:
+    // the capacity is rounded up to the next power of 2
+    explicit MpmcQueue(size_t min_capacity): mask(round_capacity(min_capacity) - 1),
+                                             cells(new Cell[mask + 1]) {
+        for (size_t i = 0; i <= mask; ++i) {
+            cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+    MpmcQueue(const MpmcQueue&) = delete;
+    MpmcQueue& operator=(const MpmcQueue&) = delete;
+
+    // Moves value in the queue, returns false (and leaves value
+    // untouched) if the queue is full.
+    bool try_push(T&& value) {
+        size_t pos = enqueue_pos.load(std::memory_order_relaxed);
+        Cell* cell;
+        for (;;) {
+            cell = &cells[pos & mask];
+            const size_t seq = cell->sequence.load(std::memory_order_acquire);
+            const auto diff = static_cast<std::ptrdiff_t>(seq) - static_cast<std::ptrdiff_t>(pos);
+            if (diff == 0) {
+                if (enqueue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) { break; }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = enqueue_pos.load(std::memory_order_relaxed);
+            }
+        }
+        cell->value = std::move(value);
+        cell->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Moves the oldest value of the queue in value, returns false if
+    // the queue is empty.
+    bool try_pop(T& value) {
+        size_t pos = dequeue_pos.load(std::memory_order_relaxed);
+        Cell* cell;
+        for (;;) {
+            cell = &cells[pos & mask];
+            const size_t seq = cell->sequence.load(std::memory_order_acquire);
+            const auto diff = static_cast<std::ptrdiff_t>(seq) - static_cast<std::ptrdiff_t>(pos + 1);
+            if (diff == 0) {
+                if (dequeue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) { break; }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = dequeue_pos.load(std::memory_order_relaxed);
+            }
+        }
+        value = std::move(cell->value);
+        cell->sequence.store(pos + mask + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Number of values in the queue, only a hint when the queue is
+    // concurrently used
+    size_t size() const {
+        const size_t enqueued = enqueue_pos.load(std::memory_order_relaxed);
+        const size_t dequeued = dequeue_pos.load(std::memory_order_relaxed);
+        return enqueued > dequeued ? enqueued - dequeued : 0;
+    }
+    size_t capacity() const { return mask + 1; }
+
+private:
+    struct Cell {
+        std::atomic<size_t> sequence;
+        T value;
+    };
+
+    static size_t round_capacity(const size_t min_capacity) {
+        size_t capacity = 2;
+        while (capacity < min_capacity) { capacity *= 2; }
+        return capacity;
+    }
+
+    const size_t mask;
+    std::unique_ptr<Cell[]> cells;
+    // on separate cache lines to avoid false sharing between
+    // producers and consumers
+    alignas(64) std::atomic<size_t> enqueue_pos{0};
+    alignas(64) std::atomic<size_t> dequeue_pos{0};
+};
+
+} // namespace navitia
@@ -0,0 +1,101 @@
+/* Copyright © 2001-2014, Canal TP and/or its affiliates. All rights reserved.
+  
+This file is part of Navitia,
+    the software to build cool stuff with public transport.
+ 
+Hope you'll enjoy and contribute to this project,
+    powered by Canal TP (www.canaltp.fr).
+Help us simplify mobility and open public transport:
+    a non ending quest to the responsive locomotion way of traveling!
+  
+LICENCE: This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU Affero General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+   
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU Affero General Public License for more details.
+   
+You should have received a copy of the GNU Affero General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+  
+Stay tuned using
+twitter @navitia 
+IRC #navitia on freenode
+https://groups.google.com/d/forum/navitia
+www.navitia.io
+*/
+
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE mpmc_queue_test
+#include <boost/test/unit_test.hpp>
+
+#include "kraken/mpmc_queue.h"
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+BOOST_AUTO_TEST_CASE(fifo_and_capacity) {
+    navitia::MpmcQueue<std::unique_ptr<int>> queue(3);
+    BOOST_CHECK_EQUAL(queue.capacity(), 4);
+
+    for (int i = 0; i < 4; ++i) {
+        BOOST_CHECK(queue.try_push(std::unique_ptr<int>(new int(i))));
+    }
+    // the queue is full, the value is not moved
+    std::unique_ptr<int> value(new int(42));
+    BOOST_CHECK(! queue.try_push(std::move(value)));
+    BOOST_REQUIRE(value);
+    BOOST_CHECK_EQUAL(queue.size(), 4);
+
+    std::unique_ptr<int> res;
+    for (int i = 0; i < 4; ++i) {
+        BOOST_REQUIRE(queue.try_pop(res));
+        BOOST_CHECK_EQUAL(*res, i);
+    }
+    BOOST_CHECK(! queue.try_pop(res));
+    BOOST_CHECK_EQUAL(queue.size(), 0);
+
+    // the ring is reused
+    BOOST_CHECK(queue.try_push(std::move(value)));
+    BOOST_REQUIRE(queue.try_pop(res));
+    BOOST_CHECK_EQUAL(*res, 42);
+}
+
+BOOST_AUTO_TEST_CASE(concurrent_producers_and_consumers) {
+    navitia::MpmcQueue<int> queue(64);
+    const int nb_values = 100000;
+    const int nb_producers = 4;
+    const int nb_consumers = 4;
+    std::atomic<int> nb_popped{0};
+    std::atomic<long> sum{0};
+
+    std::vector<std::thread> threads;
+    for (int p = 0; p < nb_producers; ++p) {
+        threads.emplace_back([&]() {
+            for (int i = 0; i < nb_values; ++i) {
+                while (! queue.try_push(int(i))) { std::this_thread::yield(); }
+            }
+        });
+    }
+    for (int c = 0; c < nb_consumers; ++c) {
+        threads.emplace_back([&]() {
+            int value;
+            while (nb_popped < nb_values * nb_producers) {
+                if (queue.try_pop(value)) {
+                    sum += value;
+                    ++nb_popped;
+                } else {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+    for (auto& thread: threads) { thread.join(); }
+
+    BOOST_CHECK_EQUAL(nb_popped, nb_values * nb_producers);
+    BOOST_CHECK_EQUAL(sum, long(nb_producers) * nb_values * (nb_values - 1) / 2);
+}
@@ -42,6 +42,7 @@ www.navitia.io
 #include "kraken/apply_disruption.h"
 #include "disruption/traffic_reports_api.h"
 #include "type/pb_converter.h"
+#include "kraken/data_manager.h"
 
 struct logger_initialized {
     logger_initialized()   { init_logger(); }
@@ -2049,3 +2050,73 @@ BOOST_AUTO_TEST_CASE(train_delayed_and_on_time) {
     BOOST_CHECK_EQUAL(res.journeys_size(), 1);
     BOOST_CHECK_EQUAL(res.impacts_size(), 1);
 }
+
+/*
+ * The raptor data of a realtime snapshot are updated from the ones of the
+ * previous snapshot, only the modified route is recomputed.
+ * The result must be the same as a full build.
+ */
+BOOST_AUTO_TEST_CASE(incremental_raptor_update) {
+    ed::builder b("20150928");
+    b.vj("A", "000001", "", true, "vj:1")("stop1", "08:01"_t)("stop2", "09:01"_t);
+    b.vj("A", "000001", "", true, "vj:2")("stop1", "09:01"_t)("stop2", "10:01"_t);
+    b.vj("B", "000001", "", true, "vj:3")("stop3", "08:01"_t)("stop4", "09:01"_t);
+    b.data->pt_data->index();
+    b.finish();
+    b.data->build_raptor();
+    b.data->build_uri();
+
+    DataManager<nt::Data> data_manager;
+    data_manager.set_data(b.data.release());
+    const auto previous = data_manager.get_data();
+    auto data = data_manager.get_data_clone();
+
+    navitia::handle_realtime("bob", timestamp,
+                             ntest::make_delay_message("vj:1", "20150928", {
+                                 DelayedTimeStop("stop1", "20150928T0810"_pts).delay(9_min),
+                                 DelayedTimeStop("stop2", "20150928T0910"_pts).delay(9_min)
+                             }),
+                             *data);
+    navitia::handle_realtime(feed_id, timestamp, make_cancellation_message("vj:3", "20150928"), *data);
+
+    const auto& pt_data = *data->pt_data;
+    BOOST_REQUIRE_EQUAL(pt_data.vehicle_journeys.size(), 4);
+    BOOST_CHECK_EQUAL(pt_data.modified_routes.size(), 2);
+
+    data->update_raptor(*previous);
+    BOOST_CHECK(pt_data.modified_routes.empty());
+
+    navitia::routing::dataRAPTOR full;
+    full.load(pt_data);
+    const auto& updated = *data->dataRaptor;
+    BOOST_REQUIRE_EQUAL(updated.jp_container.nb_jps(), full.jp_container.nb_jps());
+    BOOST_REQUIRE_EQUAL(updated.jp_container.nb_jpps(), full.jp_container.nb_jpps());
+    BOOST_CHECK(updated.jp_container.get_jps_values() == full.jp_container.get_jps_values());
+    BOOST_CHECK(updated.jp_container.get_jpps_values() == full.jp_container.get_jpps_values());
+    for (const auto level: {nt::RTLevel::Base, nt::RTLevel::Adapted, nt::RTLevel::RealTime}) {
+        BOOST_CHECK(updated.jp_validity_patterns[level] == full.jp_validity_patterns[level]);
+    }
+    for (const auto* vj: pt_data.vehicle_journeys) {
+        BOOST_CHECK(updated.jp_container.get_jp_from_vj()[navitia::routing::VjIdx(*vj)]
+                    == full.jp_container.get_jp_from_vj()[navitia::routing::VjIdx(*vj)]);
+    }
+
+    // we also update the raptor data of a snapshot without any modification
+    data_manager.set_data(std::move(data));
+    const auto last = data_manager.get_data();
+    auto unmodified = data_manager.get_data_clone();
+    unmodified->update_raptor(*last);
+    BOOST_CHECK_EQUAL(unmodified->dataRaptor->jp_container.nb_jps(), full.jp_container.nb_jps());
+    BOOST_CHECK_EQUAL(unmodified->dataRaptor->jp_container.nb_jpps(), full.jp_container.nb_jpps());
+
+    navitia::routing::RAPTOR raptor(*unmodified);
+    auto res = raptor.compute(unmodified->pt_data->stop_areas_map.at("stop1"),
+                              unmodified->pt_data->stop_areas_map.at("stop2"),
+                              "08:00"_t, 0, navitia::DateTimeUtils::inf, nt::RTLevel::RealTime, 2_min, true);
+    BOOST_REQUIRE_EQUAL(res.size(), 1);
+    BOOST_CHECK_EQUAL(res[0].items[0].arrival, "20150928T0910"_dt);
+    res = raptor.compute(unmodified->pt_data->stop_areas_map.at("stop3"),
+                         unmodified->pt_data->stop_areas_map.at("stop4"),
+                         "08:00"_t, 0, navitia::DateTimeUtils::inf, nt::RTLevel::RealTime, 2_min, true);
+    BOOST_CHECK_EQUAL(res.size(), 0);
+}
@@ -249,6 +249,13 @@ void Worker::status() {
     status->set_is_connected_to_rabbitmq(d->is_connected_to_rabbitmq);
     status->set_status(get_string_status(d));
     status->set_is_realtime_loaded(d->is_realtime_loaded);
+    if (d->dataRaptor && d->dataRaptor->cached_next_st_manager) {
+        const auto raptor_cache = d->dataRaptor->cached_next_st_manager->get_stats();
+        status->set_raptor_cache_nb_calls(raptor_cache.nb_calls);
+        status->set_raptor_cache_nb_cache_miss(raptor_cache.nb_cache_miss);
+        status->set_raptor_cache_nb_builds(raptor_cache.nb_builds);
+        status->set_raptor_cache_build_time_ms(raptor_cache.build_time_ms);
+    }
     for(const auto& contrib: this->conf.rt_topics()){
         status->add_rt_contributors(contrib);
     }
@@ -334,7 +341,16 @@ void Worker::init_worker_data(const navitia::type::Data* data,
     //@TODO should be done in data_manager
     if(data->data_identifier != this->last_data_identifier || !planner){
         planner = std::make_unique<routing::RAPTOR>(*data);
+        planner->nb_round_threads = conf.nb_raptor_round_threads();
+        datetime_planners.clear();
+        for (size_t i = 1; i < conf.nb_journey_threads(); ++i) {
+            datetime_planners.push_back(std::make_unique<routing::RAPTOR>(*data));
+        }
         street_network_worker = std::make_unique<georef::StreetNetwork>(*data->geo_ref);
+        matrix_path_finders.clear();
+        for (size_t i = 1; i < conf.nb_matrix_threads(); ++i) {
+            matrix_path_finders.push_back(std::make_unique<georef::PathFinder>(*data->geo_ref));
+        }
         this->last_data_identifier = data->data_identifier;
         LOG4CPLUS_INFO(logger, "Instanciate planner");        
     }
@@ -342,6 +358,14 @@ void Worker::init_worker_data(const navitia::type::Data* data,
 }
 
 
+std::vector<routing::RAPTOR*> Worker::get_datetime_planners() const {
+    std::vector<routing::RAPTOR*> res;
+    for (const auto& p: datetime_planners) {
+        res.push_back(p.get());
+    }
+    return res;
+}
+
 void Worker::autocomplete(const pbnavitia::PlacesRequest & request) {
     const auto* data = this->pb_creator.data;
     navitia::autocomplete::autocomplete(this->pb_creator, request.q(),
@@ -744,7 +768,7 @@ void Worker::journeys(const pbnavitia::JourneysRequest &request, pbnavitia::API
                 request.clockwise(), arg.accessibilite_params,
                 arg.forbidden, arg.allowed, *street_network_worker,
                 arg.rt_level, seconds{request.walking_transfer_penalty()}, request.max_duration(),
-                request.max_transfers(), request.max_extra_second_pass());
+                request.max_transfers(), request.max_extra_second_pass(), get_datetime_planners());
         }
     }catch(const navitia::coord_conversion_exception& e) {
         this->pb_creator.fill_pb_error(pbnavitia::Error::bad_format, e.what());
@@ -937,6 +961,10 @@ void Worker::street_network_routing_matrix(const pbnavitia::StreetNetworkRouting
         }
     }
 
+    // all the origins have the mode and speed of the request
+    std::vector<type::GeographicalCoord> origin_coords;
+    type::Mode_e mode = type::Mode_e::Walking;
+    float speed_factor = 1;
     for (const auto& origin: request.origins()) {
         type::EntryPoint entry_point;
         try{
@@ -945,23 +973,25 @@ void Worker::street_network_routing_matrix(const pbnavitia::StreetNetworkRouting
             this->pb_creator.fill_pb_error(pbnavitia::Error::bad_format, e.what());
             return;
         }
+        origin_coords.push_back(entry_point.coordinates);
+        mode = entry_point.streetnetwork_params.mode;
+        speed_factor = entry_point.streetnetwork_params.speed_factor;
+    }
 
-        street_network_worker->departure_path_finder.init(entry_point.coordinates,
-                entry_point.streetnetwork_params.mode,
-                entry_point.streetnetwork_params.speed_factor);
-        auto nearest = street_network_worker->departure_path_finder.get_duration_with_dijkstra(
-                navitia::time_duration::from_boost_duration(boost::posix_time::seconds(request.max_duration())),
-                dest_coords);
+    // the whole matrix is computed at once, the rows being shared between the path finders
+    std::vector<georef::PathFinder*> path_finders{&street_network_worker->departure_path_finder};
+    for (const auto& path_finder: matrix_path_finders) {
+        path_finders.push_back(path_finder.get());
+    }
+    const auto matrix = georef::compute_routing_matrix(path_finders, origin_coords, dest_coords, mode, speed_factor,
+            navitia::time_duration::from_boost_duration(boost::posix_time::seconds(request.max_duration())));
 
+    for (const auto& routing_elements: matrix) {
         auto* row = this->pb_creator.mutable_sn_routing_matrix()->add_rows();
-        for(auto coord : dest_coords) {
+        for (const auto& routing_element: routing_elements) {
             auto* k = row->add_routing_response();
-            auto it = nearest.find(coord.uri());
-            if(it == nearest.end()) {
-                throw navitia::recoverable_exception("Cannot find object: " + coord.uri());
-            }
-            k->set_duration(it->second.time_duration.total_seconds());
-            switch(it->second.routing_status){
+            k->set_duration(routing_element.time_duration.total_seconds());
+            switch(routing_element.routing_status){
             case georef::RoutingStatus_e::reached:
                 k->set_routing_status(pbnavitia::RoutingStatus::reached);
                 break;
@@ -72,7 +72,11 @@ struct JourneysArg {
 class Worker {
     private:
         std::unique_ptr<navitia::routing::RAPTOR> planner;
+        // additional planners used to compute the datetimes of a journeys request in parallel
+        std::vector<std::unique_ptr<navitia::routing::RAPTOR>> datetime_planners;
         std::unique_ptr<navitia::georef::StreetNetwork> street_network_worker;
+        // additional path finders used to compute the rows of a street network matrix in parallel
+        std::vector<std::unique_ptr<navitia::georef::PathFinder>> matrix_path_finders;
 
         const kraken::Configuration conf;
         log4cplus::Logger logger;
@@ -96,6 +100,7 @@ class Worker {
                               const bool disable_geojson = false,
                               const bool disable_feedpublisher = false);
 
+        std::vector<navitia::routing::RAPTOR*> get_datetime_planners() const;
         void metadatas();
         void feed_publisher();
         void status();
@@ -0,0 +1,355 @@
+/* Copyright © 2001-2014, Canal TP and/or its affiliates. All rights reserved.
+  
+This file is part of Navitia,
+    the software to build cool stuff with public transport.
+ 
+Hope you'll enjoy and contribute to this project,
+    powered by Canal TP (www.canaltp.fr).
+Help us simplify mobility and open public transport:
+    a non ending quest to the responsive locomotion way of traveling!
+  
+LICENCE: This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU Affero General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+   
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU Affero General Public License for more details.
+   
+You should have received a copy of the GNU Affero General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+  
+Stay tuned using
+twitter @navitia 
+IRC #navitia on freenode
+https://groups.google.com/d/forum/navitia
+www.navitia.io
+*/
+
+#pragma once
+#include "third_party/lz4/lz4.h"
+#include <boost/iostreams/concepts.hpp>
+#include <boost/cstdint.hpp>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <future>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * Container of named sections, each one cut in blocks compressed independently with LZ4
+ *
+ * Layout:
+ *  - header: magic, format version, user version (e.g. the data version)
+ *  - the compressed blocks of all the sections
+ *  - index: for each section its name and the offset, compressed size and raw size of its blocks
+ *  - footer: offset of the index, magic
+ *
+ * As the blocks are independent, they can be decompressed on several threads, and the
+ * sections can be read concurrently.
+ * Sizes are written in the native byte order, like the LZ4Compressor chunks.
+ */
+struct LZ4BlockFormat {
+    static constexpr uint64_t magic = 0x4b434f4c4256414eULL; // "NAVBLOCK" read in little endian
+    static constexpr uint32_t format_version = 1;
+    static constexpr uint32_t default_block_size = 1024 * 1024;
+
+    struct Block {
+        uint64_t offset;
+        uint32_t compressed_size;
+        uint32_t raw_size;
+    };
+    struct Section {
+        std::string name;
+        std::vector<Block> blocks;
+    };
+};
+
+class LZ4BlockException : public std::runtime_error {
+public:
+    explicit LZ4BlockException(const std::string& msg) : std::runtime_error(msg) {}
+};
+
+/**
+ * Writes a block container in a stream
+ *
+ * The sections are written one after the other: begin_section, writes through an
+ * LZ4BlockSink, end_section. finish writes the index.
+ */
+class LZ4BlockWriter {
+    std::ostream& out;
+    uint32_t block_size;
+    uint64_t offset = 0;
+    std::vector<char> raw;
+    std::vector<char> compressed;
+    std::vector<LZ4BlockFormat::Section> sections;
+    bool in_section = false;
+
+    template<typename T> void write_pod(const T value) {
+        write_raw(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+    void write_raw(const char* data, std::streamsize size) {
+        out.write(data, size);
+        offset += size;
+    }
+    void flush_block() {
+        if (raw.empty()) { return; }
+        const int size = LZ4_compress_default(raw.data(), compressed.data(), int(raw.size()), int(compressed.size()));
+        if (size <= 0) { throw LZ4BlockException("lz4 compression failed"); }
+        sections.back().blocks.push_back({offset, uint32_t(size), uint32_t(raw.size())});
+        write_raw(compressed.data(), size);
+        raw.clear();
+    }
+
+public:
+    LZ4BlockWriter(std::ostream& out, uint32_t user_version,
+                   uint32_t block_size = LZ4BlockFormat::default_block_size) :
+            out(out), block_size(block_size), compressed(LZ4_compressBound(int(block_size))) {
+        raw.reserve(block_size);
+        write_pod(LZ4BlockFormat::magic);
+        write_pod(LZ4BlockFormat::format_version);
+        write_pod(user_version);
+    }
+
+    void begin_section(const std::string& name) {
+        if (in_section) { throw LZ4BlockException("section " + sections.back().name + " not ended"); }
+        sections.push_back({name, {}});
+        in_section = true;
+    }
+
+    void write(const char* data, std::streamsize size) {
+        if (! in_section) { throw LZ4BlockException("write outside of a section"); }
+        while (size > 0) {
+            const std::streamsize n = std::min(size, std::streamsize(block_size - raw.size()));
+            raw.insert(raw.end(), data, data + n);
+            data += n;
+            size -= n;
+            if (raw.size() == block_size) { flush_block(); }
+        }
+    }
+
+    void end_section() {
+        flush_block();
+        in_section = false;
+    }
+
+    void finish() {
+        if (in_section) { end_section(); }
+        const uint64_t index_offset = offset;
+        write_pod(uint32_t(sections.size()));
+        for (const auto& section: sections) {
+            write_pod(uint32_t(section.name.size()));
+            write_raw(section.name.data(), section.name.size());
+            write_pod(uint32_t(section.blocks.size()));
+            for (const auto& block: section.blocks) {
+                write_pod(block.offset);
+                write_pod(block.compressed_size);
+                write_pod(block.raw_size);
+            }
+        }
+        write_pod(index_offset);
+        write_pod(LZ4BlockFormat::magic);
+        out.flush();
+    }
+};
+
+/// boost::iostreams sink writing in the current section of a LZ4BlockWriter
+class LZ4BlockSink : public boost::iostreams::sink {
+    LZ4BlockWriter* writer;
+public:
+    explicit LZ4BlockSink(LZ4BlockWriter& writer) : writer(&writer) {}
+    std::streamsize write(const char* data, std::streamsize size) {
+        writer->write(data, size);
+        return size;
+    }
+};
+
+/**
+ * Reads the index of a block container
+ *
+ * The stream must be seekable, it is shared by the sections, each read being done under a mutex.
+ * The blocks requested by the sections are decompressed by a fixed pool of threads, whatever
+ * the number of sections read concurrently.
+ */
+class LZ4BlockReader {
+    std::istream& in;
+    std::mutex mutex;
+    uint32_t user_version = 0;
+    std::vector<LZ4BlockFormat::Section> sections;
+
+    std::mutex tasks_mutex;
+    std::condition_variable tasks_cv;
+    std::deque<std::packaged_task<std::vector<char>()>> tasks;
+    bool stopping = false;
+    std::vector<std::thread> threads;
+
+    void run_tasks() {
+        while (true) {
+            std::packaged_task<std::vector<char>()> task;
+            {
+                std::unique_lock<std::mutex> lock(tasks_mutex);
+                tasks_cv.wait(lock, [&]() { return stopping || ! tasks.empty(); });
+                // the blocks already requested are decompressed before stopping
+                if (tasks.empty()) { return; }
+                task = std::move(tasks.front());
+                tasks.pop_front();
+            }
+            task();
+        }
+    }
+
+    template<typename T> T read_pod() {
+        T value;
+        in.read(reinterpret_cast<char*>(&value), sizeof(T));
+        return value;
+    }
+
+public:
+    /// Is the stream a block container? The stream is rewound to its beginning.
+    static bool is_block_container(std::istream& in) {
+        uint64_t magic = 0;
+        const auto exceptions = in.exceptions();
+        in.exceptions(std::ios::goodbit);
+        in.seekg(0);
+        in.read(reinterpret_cast<char*>(&magic), sizeof(magic));
+        in.clear();
+        in.seekg(0);
+        in.exceptions(exceptions);
+        return magic == LZ4BlockFormat::magic;
+    }
+
+    explicit LZ4BlockReader(std::istream& in,
+                            size_t nb_threads = std::max(2u, std::thread::hardware_concurrency())) : in(in) {
+        if (! is_block_container(in)) { throw LZ4BlockException("not a lz4 block container"); }
+        read_pod<uint64_t>();
+        const auto format_version = read_pod<uint32_t>();
+        if (format_version != LZ4BlockFormat::format_version) {
+            throw LZ4BlockException("unknown lz4 block container version " + std::to_string(format_version));
+        }
+        user_version = read_pod<uint32_t>();
+
+        in.seekg(-std::streamoff(sizeof(uint64_t) * 2), std::ios::end);
+        const auto index_offset = read_pod<uint64_t>();
+        if (read_pod<uint64_t>() != LZ4BlockFormat::magic) {
+            throw LZ4BlockException("truncated lz4 block container");
+        }
+        in.seekg(index_offset);
+        const auto nb_sections = read_pod<uint32_t>();
+        for (uint32_t i = 0; i < nb_sections; ++i) {
+            LZ4BlockFormat::Section section;
+            section.name.resize(read_pod<uint32_t>());
+            in.read(&section.name[0], section.name.size());
+            section.blocks.resize(read_pod<uint32_t>());
+            for (auto& block: section.blocks) {
+                block.offset = read_pod<uint64_t>();
+                block.compressed_size = read_pod<uint32_t>();
+                block.raw_size = read_pod<uint32_t>();
+            }
+            sections.push_back(std::move(section));
+        }
+        for (size_t i = 0; i < std::max(nb_threads, size_t(1)); ++i) {
+            threads.emplace_back([this]() { run_tasks(); });
+        }
+    }
+
+    ~LZ4BlockReader() {
+        {
+            std::lock_guard<std::mutex> lock(tasks_mutex);
+            stopping = true;
+        }
+        tasks_cv.notify_all();
+        for (auto& thread: threads) { thread.join(); }
+    }
+
+    uint32_t get_user_version() const { return user_version; }
+
+    const LZ4BlockFormat::Section& get_section(const std::string& name) const {
+        for (const auto& section: sections) {
+            if (section.name == name) { return section; }
+        }
+        throw LZ4BlockException("no section " + name + " in the lz4 block container");
+    }
+
+    /// Reads and decompresses a block, can be called from any thread
+    std::vector<char> read_block(const LZ4BlockFormat::Block& block) {
+        std::vector<char> compressed(block.compressed_size);
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            in.seekg(block.offset);
+            in.read(compressed.data(), compressed.size());
+        }
+        std::vector<char> raw(block.raw_size);
+        const int size = LZ4_decompress_safe(compressed.data(), raw.data(), int(compressed.size()), int(raw.size()));
+        if (size != int(block.raw_size)) { throw LZ4BlockException("corrupted lz4 block"); }
+        return raw;
+    }
+
+    /// Reads and decompresses a block on the pool of threads
+    std::future<std::vector<char>> async_read_block(const LZ4BlockFormat::Block& block) {
+        std::packaged_task<std::vector<char>()> task([this, &block]() { return read_block(block); });
+        auto res = task.get_future();
+        {
+            std::lock_guard<std::mutex> lock(tasks_mutex);
+            tasks.push_back(std::move(task));
+        }
+        tasks_cv.notify_one();
+        return res;
+    }
+};
+
+/**
+ * boost::iostreams source reading a section of a block container
+ *
+ * Up to nb_ahead blocks are requested in advance to the threads of the reader
+ * while the current one is consumed.
+ */
+class LZ4SectionSource : public boost::iostreams::source {
+    struct State {
+        LZ4BlockReader* reader;
+        const LZ4BlockFormat::Section* section;
+        size_t nb_ahead;
+        size_t next_block = 0;
+        std::deque<std::future<std::vector<char>>> pending;
+        std::vector<char> current;
+        size_t pos = 0;
+
+        void launch() {
+            while (pending.size() < nb_ahead && next_block < section->blocks.size()) {
+                pending.push_back(reader->async_read_block(section->blocks[next_block++]));
+            }
+        }
+    };
+    // iostreams copies its devices, the state is shared between the copies
+    std::shared_ptr<State> state;
+
+public:
+    LZ4SectionSource(LZ4BlockReader& reader, const std::string& name, size_t nb_ahead = 4) :
+            state(std::make_shared<State>()) {
+        state->reader = &reader;
+        state->section = &reader.get_section(name);
+        state->nb_ahead = std::max(nb_ahead, size_t(1));
+    }
+
+    std::streamsize read(char* dest, std::streamsize size) {
+        State& s = *state;
+        while (s.pos == s.current.size()) {
+            s.launch();
+            if (s.pending.empty()) { return -1; }
+            s.current = s.pending.front().get();
+            s.pending.pop_front();
+            s.pos = 0;
+        }
+        const std::streamsize n = std::min(size, std::streamsize(s.current.size() - s.pos));
+        std::memcpy(dest, s.current.data() + s.pos, n);
+        s.pos += n;
+        return n;
+    }
+};
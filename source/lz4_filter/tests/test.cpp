@@ -29,6 +29,7 @@ www.navitia.io
 */
 
 #include "lz4_filter/filter.h"
+#include "lz4_filter/block_container.h"
 #define BOOST_TEST_DYN_LINK
 #define BOOST_TEST_MODULE test_lz4_filter
 #include <boost/test/unit_test.hpp>
@@ -37,6 +38,8 @@ www.navitia.io
 #include <boost/iostreams/filtering_stream.hpp>
 #include <boost/iostreams/device/file.hpp>
 #include <string>
+#include <sstream>
+#include <thread>
 
 
 BOOST_AUTO_TEST_CASE(tiny_string_compression){
@@ -98,3 +101,72 @@ BOOST_AUTO_TEST_CASE(big_string_compression){
     }
     BOOST_CHECK_EQUAL(str, result);
 }
+
+// several sections, cut in many small blocks, read concurrently
+BOOST_AUTO_TEST_CASE(block_container){
+    std::vector<std::string> contents;
+    std::string str = "foobariozafiozehfuiozefuigaezgfuzegfpuzheuerfhzeupgf";
+    for (int i = 0; i < 4; i++) {
+        contents.push_back(str);
+        for (int j = 0; j < 3; j++) {
+            str += str + std::to_string(i * j);
+        }
+    }
+    contents.push_back("");
+
+    std::stringstream ss;
+    {
+        LZ4BlockWriter writer(ss, 42, 100);
+        for (size_t i = 0; i < contents.size(); ++i) {
+            writer.begin_section("section " + std::to_string(i));
+            boost::iostreams::filtering_ostream out;
+            out.push(LZ4BlockSink(writer));
+            out << contents[i];
+            out.reset();
+            writer.end_section();
+        }
+        writer.finish();
+    }
+
+    BOOST_REQUIRE(LZ4BlockReader::is_block_container(ss));
+    // the sections share the decompression threads of the reader
+    for (const size_t nb_threads: {1, 3}) {
+        LZ4BlockReader reader(ss, nb_threads);
+        BOOST_CHECK_EQUAL(reader.get_user_version(), 42);
+        BOOST_CHECK_GT(reader.get_section("section 3").blocks.size(), 100);
+        BOOST_CHECK_THROW(reader.get_section("bob"), LZ4BlockException);
+
+        std::vector<std::string> results(contents.size());
+        std::vector<std::thread> threads;
+        for (size_t i = 0; i < contents.size(); ++i) {
+            threads.emplace_back([&, i]() {
+                boost::iostreams::filtering_istream in;
+                in.push(LZ4SectionSource(reader, "section " + std::to_string(i), 3));
+                std::getline(in, results[i], '\0');
+            });
+        }
+        for (auto& thread: threads) { thread.join(); }
+        for (size_t i = 0; i < contents.size(); ++i) {
+            BOOST_CHECK_EQUAL(results[i], contents[i]);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(former_format_is_not_a_block_container){
+    std::stringstream ss;
+    {
+        boost::iostreams::filtering_ostream out;
+        out.push(LZ4Compressor());
+        out.push(ss);
+        out << "foo";
+    }
+    BOOST_CHECK(! LZ4BlockReader::is_block_container(ss));
+    BOOST_CHECK_THROW(LZ4BlockReader{ss}, LZ4BlockException);
+
+    std::string result;
+    boost::iostreams::filtering_istream in;
+    in.push(LZ4Decompressor());
+    in.push(ss);
+    in >> result;
+    BOOST_CHECK_EQUAL(result, "foo");
+}
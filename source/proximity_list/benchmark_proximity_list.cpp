@@ -0,0 +1,123 @@
+/* Copyright © 2001-2014, Canal TP and/or its affiliates. All rights reserved.
+  
+This file is part of Navitia,
+    the software to build cool stuff with public transport.
+ 
+Hope you'll enjoy and contribute to this project,
+    powered by Canal TP (www.canaltp.fr).
+Help us simplify mobility and open public transport:
+    a non ending quest to the responsive locomotion way of traveling!
+  
+LICENCE: This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU Affero General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+   
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU Affero General Public License for more details.
+   
+You should have received a copy of the GNU Affero General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+  
+Stay tuned using
+twitter @navitia 
+IRC #navitia on freenode
+https://groups.google.com/d/forum/navitia
+www.navitia.io
+*/
+
+#include "proximity_list.h"
+#include "type/data.h"
+#include "type/pt_data.h"
+#include "georef/georef.h"
+#include "utils/timer.h"
+#include "utils/init.h"
+#include <boost/program_options.hpp>
+#include <random>
+#include <iostream>
+
+using namespace navitia;
+using namespace proximitylist;
+namespace po = boost::program_options;
+
+template<typename T>
+static void run(const std::string& name,
+                const ProximityList<T>& pl,
+                const std::vector<type::GeographicalCoord>& coords,
+                double distance) {
+    size_t nb_found = 0, nb_found_by_lon = 0;
+    {
+        Timer t(name + ": find_within");
+        for (const auto& coord: coords) {
+            nb_found += pl.find_within(coord, distance).size();
+        }
+    }
+    {
+        Timer t(name + ": find_within_by_lon");
+        for (const auto& coord: coords) {
+            nb_found_by_lon += pl.find_within_by_lon(coord, distance).size();
+        }
+    }
+    {
+        Timer t(name + ": find_k_nearest");
+        for (const auto& coord: coords) {
+            pl.find_k_nearest(coord, 1, distance);
+        }
+    }
+    std::cout << name << ": " << pl.items.size() << " items, " << pl.band_min_lat.size() << " bands, "
+              << nb_found << " found (" << nb_found_by_lon << " by longitude)" << std::endl;
+}
+
+int main(int argc, char** argv) {
+    navitia::init_app();
+    po::options_description desc("Benchmark of the proximity lists");
+    std::string file;
+    int iterations;
+    double distance;
+
+    desc.add_options()
+            ("help", "Show this message")
+            ("iterations,i", po::value<int>(&iterations)->default_value(10000),
+                     "Number of queries")
+            ("distance,d", po::value<double>(&distance)->default_value(500),
+                     "Radius of the queries in meters")
+            ("file,f", po::value<std::string>(&file)->default_value("data.nav.lz4"),
+                     "Path to data.nav.lz4");
+    po::variables_map vm;
+    po::store(po::parse_command_line(argc, argv, desc), vm);
+    po::notify(vm);
+
+    if (vm.count("help")) {
+        std::cout << "This is used to benchmark the proximity lists on the stop points and the vertices" << std::endl;
+        std::cout << desc << std::endl;
+        return 1;
+    }
+
+    type::Data data;
+    {
+        Timer t("Loading data: " + file);
+        data.load(file);
+    }
+    const auto& stop_points = data.pt_data->stop_points;
+    if (stop_points.empty()) {
+        std::cout << "no stop point in " << file << std::endl;
+        return 1;
+    }
+
+    // queries around the stop points, up to ~1km away
+    std::mt19937 rng(31442);
+    std::uniform_int_distribution<size_t> gen_sp(0, stop_points.size() - 1);
+    std::uniform_real_distribution<double> gen_shift(-0.01, 0.01);
+    std::vector<type::GeographicalCoord> coords;
+    for (int i = 0; i < iterations; ++i) {
+        const auto& coord = stop_points[gen_sp(rng)]->coord;
+        coords.emplace_back(coord.lon() + gen_shift(rng), coord.lat() + gen_shift(rng));
+    }
+
+    run("stop points", data.pt_data->stop_point_proximity_list, coords, distance);
+    run("vertices", data.geo_ref->pl, coords, distance);
+    run("pois", data.geo_ref->poi_proximity_list, coords, distance);
+    return 0;
+}
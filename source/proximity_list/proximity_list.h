@@ -34,6 +34,8 @@ www.navitia.io
 #include "utils/exception.h"
 #include <vector>
 #include <cmath>
+#include <cstdint>
+#include <algorithm>
 
 namespace navitia { namespace proximitylist {
 
@@ -49,8 +51,11 @@ struct NotFound : public recoverable_exception{
  *
  * Le template T est le type que l'on souhaite indexer (typiquement un Idx). L'élément sera copié.
  * On rajoute des élements itérativements et on appelle build pour construire l'indexe.
- * L'implémentation est un bête tableau trié par X.
- * On cherche les bornes inf/sup selon X, puis on itère sur les données et on garde les bonnes
+ * Les éléments sont gardés dans un tableau trié par X.
+ * Par dessus, build découpe les éléments en bandes selon Y, avec le même nombre d'éléments
+ * par bande, et chaque bande garde les indices de ses éléments triés par X.
+ * Une recherche cherche les bornes inf/sup selon X dans chaque bande qui touche le cercle,
+ * ou bien, si c'est moins coûteux, dans tout le tableau, puis garde les bons éléments.
  */
 
 template<class T>
@@ -70,37 +75,104 @@ struct ProximityList
     /// Contient toutes les coordonnées de manière à trouver rapidement
     std::vector<Item> items;
 
+    /// Les indices de la bande i sont band_items[i * band_size..(i + 1) * band_size[, triés par X
+    uint32_t band_size = 0;
+    std::vector<uint32_t> band_items;
+    /// Y min et max de chaque bande, croissants
+    std::vector<double> band_min_lat;
+    std::vector<double> band_max_lat;
+
     /// Rajoute un nouvel élément. Attention, il faut appeler build avant de pouvoir utiliser la structure
     void add(GeographicalCoord coord, T element){
         items.push_back(Item(coord,element));
     }
     void clear(){
         items.clear();
+        build_bands();
     }
 
     /// Construit l'indexe
     void build(){
         std::sort(items.begin(), items.end(), [](const Item & a, const Item & b){return a.coord < b.coord;});
+        build_bands();
     }
 
     /// Retourne tous les éléments dans un rayon de x mètres
     std::vector< std::pair<T, GeographicalCoord> > find_within(GeographicalCoord coord, double distance = 500) const {
         double distance_degree = distance / 111320;
-
         double coslat = ::cos(coord.lat() * type::GeographicalCoord::N_DEG_TO_RAD);
+        double lon_min = coord.lon() - distance_degree / coslat;
+        double lon_max = coord.lon() + distance_degree / coslat;
+
+        auto begin = std::lower_bound(items.begin(), items.end(), lon_min, [](const Item & i, double min){return i.coord.lon() < min;});
+        auto end = std::upper_bound(begin, items.end(), lon_max, [](double max, const Item & i){return max < i.coord.lon();});
+
+        // Un peu plus large que la borne exacte en Y
+        double lat_degree = distance / 111000;
+        auto first_band = std::lower_bound(band_max_lat.begin(), band_max_lat.end(), coord.lat() - lat_degree)
+                - band_max_lat.begin();
+        auto last_band = std::upper_bound(band_min_lat.begin(), band_min_lat.end(), coord.lat() + lat_degree)
+                - band_min_lat.begin();
+        // Deux dichotomies par bande, à accès indirects, contre un parcours de toute la bande de X
+        if (first_band >= last_band || double(last_band - first_band) * 8 * ::log2(band_size) >= double(end - begin)) {
+            return filter_by_distance(begin, end, coord, coslat, distance);
+        }
 
-        auto begin = std::lower_bound(items.begin(), items.end(), coord.lon() - distance_degree / coslat, [](const Item & i, double min){return i.coord.lon() < min;});
-        auto end = std::upper_bound(begin, items.end(), coord.lon() + distance_degree / coslat, [](double max, const Item & i){return max < i.coord.lon();});
+        std::vector<uint32_t> candidates;
+        auto lon_less = [&](uint32_t i, double lon){return items[i].coord.lon() < lon;};
+        auto lon_greater = [&](double lon, uint32_t i){return lon < items[i].coord.lon();};
+        for (auto band = first_band; band < last_band; ++band) {
+            auto band_begin = band_items.begin() + band * band_size;
+            auto band_end = band_items.begin() + std::min(band_items.size(), size_t(band + 1) * band_size);
+            auto it = std::lower_bound(band_begin, band_end, lon_min, lon_less);
+            auto it_end = std::upper_bound(it, band_end, lon_max, lon_greater);
+            candidates.insert(candidates.end(), it, it_end);
+        }
+        // On remet les éléments dans l'ordre de items pour que le tri final donne le même résultat
+        std::sort(candidates.begin(), candidates.end());
         std::vector< std::pair<T, GeographicalCoord> > result;
         double max_dist = distance * distance;
-        for(; begin != end; ++begin){
-            if(begin->coord.approx_sqr_distance(coord, coslat) <= max_dist)
-                result.push_back(std::make_pair(begin->element, begin->coord));
+        for (const auto i: candidates) {
+            if(items[i].coord.approx_sqr_distance(coord, coslat) <= max_dist)
+                result.push_back(std::make_pair(items[i].element, items[i].coord));
         }
-        std::sort(result.begin(), result.end(), [&coord, &coslat](const std::pair<T, GeographicalCoord> & a, const std::pair<T, GeographicalCoord> & b){return a.second.approx_sqr_distance(coord, coslat) < b.second.approx_sqr_distance(coord, coslat);});
+        sort_by_distance(result, coord, coslat);
         return result;
     }
 
+    /// Comme find_within, mais en parcourant toute la bande de X, sans les bandes selon Y
+    std::vector< std::pair<T, GeographicalCoord> > find_within_by_lon(GeographicalCoord coord, double distance = 500) const {
+        double distance_degree = distance / 111320;
+
+        double coslat = ::cos(coord.lat() * type::GeographicalCoord::N_DEG_TO_RAD);
+
+        auto begin = std::lower_bound(items.begin(), items.end(), coord.lon() - distance_degree / coslat, [](const Item & i, double min){return i.coord.lon() < min;});
+        auto end = std::upper_bound(begin, items.end(), coord.lon() + distance_degree / coslat, [](double max, const Item & i){return max < i.coord.lon();});
+        return filter_by_distance(begin, end, coord, coslat, distance);
+    }
+
+    /** Retourne les k éléments les plus proches à moins de max_dist mètres, du plus proche au plus loin
+     *
+     * On cherche dans un rayon qui double tant qu'on n'a pas trouvé k éléments.
+     */
+    std::vector< std::pair<T, GeographicalCoord> > find_k_nearest(GeographicalCoord coord,
+                                                                  size_t k,
+                                                                  double max_dist = 500) const {
+        if (k == 0) { return {}; }
+        double coslat = ::cos(coord.lat() * type::GeographicalCoord::N_DEG_TO_RAD);
+        double radius = std::min(max_dist, 100.);
+        for (;;) {
+            auto result = find_within(coord, radius);
+            // La bande de X est un peu plus étroite que le rayon : on ne conclut que si
+            // le k-ième élément est assez loin du bord
+            if (radius >= max_dist || (result.size() >= k &&
+                    result[k - 1].second.approx_sqr_distance(coord, coslat) <= 0.99 * 0.99 * radius * radius)) {
+                if (result.size() > k) { result.resize(k); }
+                return result;
+            }
+            radius = std::min(max_dist, 2 * radius);
+        }
+    }
 
     /// Fonction de confort pour retrouver l'élément le plus proche dans l'indexe
     T find_nearest(double lon, double lat) const {
@@ -109,7 +181,7 @@ struct ProximityList
 
     /// Retourne l'élément le plus proche dans tout l'indexe
     T find_nearest(GeographicalCoord coord, double max_dist = 500) const {
-        auto temp = find_within(coord, max_dist);
+        auto temp = find_k_nearest(coord, 1, max_dist);
         if(temp.empty())
             throw NotFound();
         else
@@ -122,9 +194,55 @@ struct ProximityList
       * Elle est appelée par boost et pas directement
       */
     template<class Archive> void serialize(Archive & ar, const unsigned int) {
-        ar & items;
+        ar & items & band_size & band_items & band_min_lat & band_max_lat;
+    }
+
+private:
+    typedef typename std::vector<Item>::const_iterator const_iterator;
+
+    /// Les éléments de [begin, end[ à moins de distance mètres, triés par distance
+    static std::vector< std::pair<T, GeographicalCoord> > filter_by_distance(const_iterator begin, const_iterator end,
+                                                                            const GeographicalCoord& coord,
+                                                                            double coslat, double distance) {
+        std::vector< std::pair<T, GeographicalCoord> > result;
+        double max_dist = distance * distance;
+        for(; begin != end; ++begin){
+            if(begin->coord.approx_sqr_distance(coord, coslat) <= max_dist)
+                result.push_back(std::make_pair(begin->element, begin->coord));
+        }
+        sort_by_distance(result, coord, coslat);
+        return result;
     }
 
+    static void sort_by_distance(std::vector< std::pair<T, GeographicalCoord> >& result,
+                                 const GeographicalCoord& coord, double coslat) {
+        std::sort(result.begin(), result.end(), [&coord, &coslat](const std::pair<T, GeographicalCoord> & a, const std::pair<T, GeographicalCoord> & b){return a.second.approx_sqr_distance(coord, coslat) < b.second.approx_sqr_distance(coord, coslat);});
+    }
+
+    /** Construit les bandes selon Y
+     *
+     * Environ racine de n éléments par bande : autant de bandes que d'éléments dans une bande.
+     */
+    void build_bands() {
+        band_items.resize(items.size());
+        band_min_lat.clear();
+        band_max_lat.clear();
+        band_size = std::max(uint32_t(16), uint32_t(::sqrt(items.size())));
+        for (size_t i = 0; i < items.size(); ++i) {
+            band_items[i] = uint32_t(i);
+        }
+        std::stable_sort(band_items.begin(), band_items.end(), [&](uint32_t a, uint32_t b){
+            return items[a].coord.lat() < items[b].coord.lat();
+        });
+        for (size_t first = 0; first < band_items.size(); first += band_size) {
+            auto band_begin = band_items.begin() + first;
+            auto band_end = band_items.begin() + std::min(band_items.size(), first + band_size);
+            band_min_lat.push_back(items[*band_begin].coord.lat());
+            band_max_lat.push_back(items[*(band_end - 1)].coord.lat());
+            // items est trié par X : trier les indices suffit
+            std::sort(band_begin, band_end);
+        }
+    }
 };
 
 }} // namespace navitia::proximitylist
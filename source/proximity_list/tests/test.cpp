@@ -174,6 +174,46 @@ BOOST_AUTO_TEST_CASE(find_nearest){
     BOOST_CHECK_EQUAL_COLLECTIONS(tmp.begin(), tmp.end(), expected.begin(), expected.end());
 }
 
+// the search by latitude bands must give the same result as the scan of the longitude strip,
+// on a narrow north-south coverage and with a lonely point far away
+BOOST_AUTO_TEST_CASE(find_within_bands) {
+    ProximityList<unsigned int> pl;
+    std::vector<GeographicalCoord> coords;
+    for (unsigned int i = 0; i < 2000; ++i) {
+        // a 0.02 x 2 degrees grid, shifted a bit to avoid aligned points
+        GeographicalCoord c(2.3 + 0.001 * (i % 20) + 0.00001 * (i % 7), 48 + 0.001 * (i / 20) * 20 + 0.00003 * (i % 11));
+        pl.add(c, i);
+        coords.push_back(c);
+    }
+    pl.add(GeographicalCoord(0, 0), 2000);
+    coords.push_back(GeographicalCoord(0, 0));
+    pl.build();
+
+    // the items stay sorted by longitude
+    for (size_t i = 1; i < pl.items.size(); ++i) {
+        BOOST_CHECK(pl.items[i - 1].coord.lon() <= pl.items[i].coord.lon());
+    }
+    BOOST_CHECK_GT(pl.band_min_lat.size(), 1);
+
+    for (const double distance: {0., 10., 150., 500., 3000.}) {
+        for (size_t i = 0; i < coords.size(); i += 37) {
+            const auto& c = coords[i];
+            BOOST_CHECK(pl.find_within(c, distance) == pl.find_within_by_lon(c, distance));
+        }
+    }
+
+    const GeographicalCoord c(2.305, 48.5);
+    auto all = pl.find_within_by_lon(c, 2000);
+    auto nearest = pl.find_k_nearest(c, 5, 2000);
+    BOOST_REQUIRE_EQUAL(nearest.size(), 5);
+    for (size_t i = 0; i < nearest.size(); ++i) {
+        BOOST_CHECK_EQUAL(nearest[i].first, all[i].first);
+    }
+    BOOST_CHECK_EQUAL(pl.find_nearest(c, 2000), all.front().first);
+    BOOST_CHECK_EQUAL(pl.find_k_nearest(GeographicalCoord(0.001, 0.001), 3, 500).size(), 1);
+    BOOST_CHECK_THROW(pl.find_nearest(GeographicalCoord(1, 1)), NotFound);
+}
+
 BOOST_AUTO_TEST_CASE(test_api) {
     navitia::type::Data data;
     //Everything in the range
@@ -390,9 +390,14 @@ Indexes get_indexes(Filter filter,  Type_e requested_type, const Data & d) {
     }
     Type_e current = filter.navitia_type;
     std::map<Type_e, Type_e> path = find_path(requested_type);
-    while(path[current] != current){
-        indexes = d.get_target_by_source(current, path[current], indexes);
-        current = path[current];
+    if (path[current] != current) {
+        // the targets stay in a bitmap from one type to the next
+        IndexBitmap targets(indexes);
+        while(path[current] != current){
+            targets = d.get_target_by_source(current, path[current], targets);
+            current = path[current];
+        }
+        indexes = targets.to_indexes();
     }
 
     if (current != requested_type) {
@@ -586,13 +591,14 @@ Indexes make_query(const Type_e requested_type,
         }
     }
 
-    Indexes final_indexes;
+    // the intersections and differences are done on a bitmap
+    IndexBitmap final_bitmap;
     if (! data.get_nb_obj(requested_type)) {
         throw ptref_error("Filters: No requested object in the database");
     }
 
     if (filters.empty()) {
-        final_indexes = data.get_all_index(requested_type);
+        final_bitmap = IndexBitmap(data.get_all_index(requested_type));
     } else {
         Indexes indexes;
         bool first_time = true;
@@ -631,9 +637,9 @@ Indexes make_query(const Type_e requested_type,
                         + nt::static_data::get()->captionByType(filter.navitia_type) + "<<");
             }
             if (first_time) {
-                final_indexes = indexes;
+                final_bitmap = IndexBitmap(indexes);
             } else {
-                final_indexes = get_intersection(final_indexes, indexes);
+                final_bitmap &= IndexBitmap(indexes);
             }
             first_time = false;
         }
@@ -683,8 +689,10 @@ Indexes make_query(const Type_e requested_type,
                                 + nt::static_data::get()->captionByType(filter_forbidden.navitia_type)
                                 + "<<");
         }
-        final_indexes = get_difference(final_indexes, forbidden_idx);
+        final_bitmap -= IndexBitmap(forbidden_idx);
     }
+    Indexes final_indexes = final_bitmap.to_indexes();
+
     // Manage OdtLevel
     if (odt_level != navitia::type::OdtLevel_e::all) {
         final_indexes = manage_odt_level(final_indexes, requested_type, odt_level, data);
@@ -0,0 +1,157 @@
+/* Copyright © 2001-2014, Canal TP and/or its affiliates. All rights reserved.
+  
+This file is part of Navitia,
+    the software to build cool stuff with public transport.
+ 
+Hope you'll enjoy and contribute to this project,
+    powered by Canal TP (www.canaltp.fr).
+Help us simplify mobility and open public transport:
+    a non ending quest to the responsive locomotion way of traveling!
+  
+LICENCE: This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU Affero General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+   
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU Affero General Public License for more details.
+   
+You should have received a copy of the GNU Affero General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+  
+Stay tuned using
+twitter @navitia 
+IRC #navitia on freenode
+https://groups.google.com/d/forum/navitia
+www.navitia.io
+*/
+
+#include "next_stop_time.h"
+#include "dataraptor.h"
+#include "type/data.h"
+#include "type/pt_data.h"
+#include "utils/timer.h"
+#include "utils/init.h"
+#include <boost/program_options.hpp>
+#include <algorithm>
+#include <random>
+#include <iostream>
+
+using namespace navitia;
+using namespace routing;
+namespace po = boost::program_options;
+
+struct Demand {
+    JppIdx jpp_idx;
+    DateTime dt;
+    StopEvent stop_event;
+    type::VehicleProperties vehicle_props;
+};
+
+// The search as it was done before the packed kernels: a binary
+// search on the stop times, then a linear walk dereferencing each
+// candidate to test its accessibility and validity.
+static std::pair<const type::StopTime*, DateTime>
+scalar_earliest_stop_time(const NextStopTimeData& next_stop_time_data, const Demand& demand) {
+    auto date = DateTimeUtils::date(demand.dt);
+    const auto get_hour = [&](const type::StopTime* st) {
+        return DateTimeUtils::hour(demand.stop_event == StopEvent::pick_up ? st->boarding_time
+                                                                          : st->alighting_time);
+    };
+    const auto range = next_stop_time_data.stop_time_range_forward(demand.jpp_idx, demand.stop_event);
+    auto begin = std::partition_point(range.begin(), range.end(), [&](const type::StopTime* st) {
+        return get_hour(st) < DateTimeUtils::hour(demand.dt);
+    });
+    for (int nb_days = 0; nb_days < 2; ++nb_days, ++date, begin = range.begin()) {
+        for (auto it = begin; it != range.end(); ++it) {
+            const auto* st = *it;
+            if (st->is_valid_day(date, false, type::RTLevel::Base)
+                    && st->vehicle_journey->accessible(demand.vehicle_props)) {
+                return {st, DateTimeUtils::set(date, get_hour(st))};
+            }
+        }
+    }
+    return {nullptr, DateTimeUtils::inf};
+}
+
+int main(int argc, char** argv) {
+    navitia::init_app();
+    po::options_description desc("Benchmark of the earliest stop time search");
+    std::string file;
+    int iterations;
+
+    desc.add_options()
+            ("help", "Show this message")
+            ("iterations,i", po::value<int>(&iterations)->default_value(1000000),
+                     "Number of searches")
+            ("file,f", po::value<std::string>(&file)->default_value("data.nav.lz4"),
+                     "Path to data.nav.lz4");
+    po::variables_map vm;
+    po::store(po::parse_command_line(argc, argv, desc), vm);
+    po::notify(vm);
+
+    if (vm.count("help")) {
+        std::cout << "This is used to benchmark the earliest stop time search" << std::endl;
+        std::cout << desc << std::endl;
+        return 1;
+    }
+
+    type::Data data;
+    {
+        Timer t("Loading data: " + file);
+        data.load(file);
+    }
+    data.build_raptor();
+    const auto& next_stop_time_data = data.dataRaptor->next_stop_time_data;
+    const auto nb_jpps = data.dataRaptor->jp_container.nb_jpps();
+    if (nb_jpps == 0) {
+        std::cout << "no journey pattern point in " << file << std::endl;
+        return 1;
+    }
+
+    std::mt19937 rng(31442);
+    std::uniform_int_distribution<size_t> gen_jpp(0, nb_jpps - 1);
+    std::uniform_int_distribution<DateTime> gen_hour(0, DateTimeUtils::SECONDS_PER_DAY - 1);
+    std::uniform_int_distribution<int> gen_day(0, 6);
+    std::vector<Demand> demands;
+    demands.reserve(iterations);
+    for (int i = 0; i < iterations; ++i) {
+        Demand demand;
+        demand.jpp_idx = JppIdx(gen_jpp(rng));
+        demand.dt = DateTimeUtils::set(gen_day(rng), gen_hour(rng));
+        demand.stop_event = i % 2 ? StopEvent::pick_up : StopEvent::drop_off;
+        // one search out of 4 asks for wheelchair accessible vehicles
+        if (i % 4 == 0) {
+            demand.vehicle_props.set(type::hasVehicleProperties::WHEELCHAIR_ACCESSIBLE);
+        }
+        demands.push_back(demand);
+    }
+
+    std::vector<std::pair<const type::StopTime*, DateTime>> scalar_results, packed_results;
+    scalar_results.reserve(demands.size());
+    packed_results.reserve(demands.size());
+    {
+        Timer t("scalar search");
+        for (const auto& demand: demands) {
+            scalar_results.push_back(scalar_earliest_stop_time(next_stop_time_data, demand));
+        }
+    }
+    {
+        Timer t("packed search");
+        for (const auto& demand: demands) {
+            packed_results.push_back(next_stop_time_data.earliest_valid_stop_time(
+                demand.jpp_idx, demand.dt, demand.stop_event, type::RTLevel::Base,
+                demand.vehicle_props, DateTimeUtils::inf));
+        }
+    }
+
+    size_t nb_diff = 0;
+    for (size_t i = 0; i < demands.size(); ++i) {
+        if (scalar_results[i] != packed_results[i]) { ++nb_diff; }
+    }
+    std::cout << "Number of searches: " << demands.size() << std::endl;
+    std::cout << "Number of different results: " << nb_diff << std::endl;
+    return nb_diff == 0 ? 0 : 1;
+}
@@ -0,0 +1,124 @@
+/* Copyright © 2001-2014, Canal TP and/or its affiliates. All rights reserved.
+  
+This file is part of Navitia,
+    the software to build cool stuff with public transport.
+ 
+Hope you'll enjoy and contribute to this project,
+    powered by Canal TP (www.canaltp.fr).
+Help us simplify mobility and open public transport:
+    a non ending quest to the responsive locomotion way of traveling!
+  
+LICENCE: This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU Affero General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+   
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU Affero General Public License for more details.
+   
+You should have received a copy of the GNU Affero General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+  
+Stay tuned using
+twitter @navitia 
+IRC #navitia on freenode
+https://groups.google.com/d/forum/navitia
+www.navitia.io
+*/
+
+#include "raptor.h"
+#include "dataraptor.h"
+#include "type/data.h"
+#include "type/pt_data.h"
+#include "utils/timer.h"
+#include "utils/init.h"
+#include <boost/program_options.hpp>
+#include <random>
+#include <iostream>
+
+using namespace navitia;
+using namespace routing;
+namespace po = boost::program_options;
+
+int main(int argc, char** argv) {
+    navitia::init_app();
+    po::options_description desc("Benchmark of the raptor rounds on short urban queries");
+    std::string file;
+    int iterations, max_duration;
+
+    desc.add_options()
+            ("help", "Show this message")
+            ("iterations,i", po::value<int>(&iterations)->default_value(1000),
+                     "Number of queries")
+            ("max_duration,d", po::value<int>(&max_duration)->default_value(30 * 60),
+                     "Maximal duration of the queries in seconds")
+            ("file,f", po::value<std::string>(&file)->default_value("data.nav.lz4"),
+                     "Path to data.nav.lz4");
+    po::variables_map vm;
+    po::store(po::parse_command_line(argc, argv, desc), vm);
+    po::notify(vm);
+
+    if (vm.count("help")) {
+        std::cout << "This is used to benchmark the raptor rounds on short urban queries" << std::endl;
+        std::cout << desc << std::endl;
+        return 1;
+    }
+
+    type::Data data;
+    {
+        Timer t("Loading data: " + file);
+        data.load(file);
+    }
+    data.build_raptor();
+    const auto& stop_points = data.pt_data->stop_points;
+    if (stop_points.empty()) {
+        std::cout << "no stop point in " << file << std::endl;
+        return 1;
+    }
+
+    std::mt19937 rng(31442);
+    std::uniform_int_distribution<size_t> gen_sp(0, stop_points.size() - 1);
+    std::uniform_int_distribution<DateTime> gen_hour(7 * 3600, 20 * 3600);
+    std::vector<std::pair<SpIdx, DateTime>> demands;
+    for (int i = 0; i < iterations; ++i) {
+        demands.emplace_back(SpIdx(*stop_points[gen_sp(rng)]), DateTimeUtils::set(0, gen_hour(rng)));
+    }
+
+    // the same queries with the previous handling of the rounds, a scan of
+    // the whole queue of journey patterns, and with the marked journey patterns
+    RAPTOR raptor(data);
+    // a first pass, not timed, builds the caches of the next stop times used by both
+    for (const auto& demand: demands) {
+        map_stop_point_duration departures;
+        departures[demand.first] = 0_s;
+        raptor.isochrone(departures, demand.second, demand.second + max_duration);
+    }
+    std::vector<size_t> nb_rounds;
+    for (const bool scan_whole_queue: {true, false}) {
+        raptor.scan_whole_queue = scan_whole_queue;
+        size_t nb = 0;
+        {
+            Timer t(scan_whole_queue ? "raptor scanning the whole journey pattern queue"
+                                     : "raptor scanning the marked journey patterns");
+            for (const auto& demand: demands) {
+                map_stop_point_duration departures;
+                departures[demand.first] = 0_s;
+                raptor.isochrone(departures, demand.second, demand.second + max_duration);
+                nb += raptor.count;
+            }
+        }
+        nb_rounds.push_back(nb);
+    }
+    if (nb_rounds[0] != nb_rounds[1]) {
+        std::cout << "the two handlings do not do the same rounds: "
+                  << nb_rounds[0] << " vs " << nb_rounds[1] << std::endl;
+        return 1;
+    }
+
+    std::cout << "Number of queries: " << demands.size() << std::endl;
+    std::cout << "Number of rounds: " << nb_rounds[0] << std::endl;
+    std::cout << "Number of journey patterns: " << data.dataRaptor->jp_container.nb_jps() << std::endl;
+    return 0;
+}
@@ -33,6 +33,7 @@ www.navitia.io
 #include "routing/raptor_utils.h"
 
 #include <boost/range/algorithm_ext.hpp>
+#include <limits>
 
 namespace navitia { namespace routing {
 
@@ -81,16 +82,52 @@ void dataRAPTOR::JppsFromJp::load(const JourneyPatternContainer& jp_container) {
     for (auto& jpps: jpps_from_jp.values()) { jpps.shrink_to_fit(); }
 }
 
+void dataRAPTOR::StopTimes::load(const JourneyPatternContainer& jp_container) {
+    boarding_times.clear();
+    alighting_times.clear();
+    flags.clear();
+    local_traffic_zones.clear();
+    first_st_by_vj.clear();
+    for (const auto& jp: jp_container.get_jps()) {
+        jp.second.for_each_vehicle_journey([&](const nt::VehicleJourney& vj) {
+            if (vj.idx >= first_st_by_vj.size()) {
+                first_st_by_vj.resize(vj.idx + 1, std::numeric_limits<uint32_t>::max());
+            }
+            first_st_by_vj[vj.idx] = boarding_times.size();
+            for (const auto& st: vj.stop_time_list) {
+                boarding_times.push_back(st.boarding_time);
+                alighting_times.push_back(st.alighting_time);
+                flags.push_back((st.pick_up_allowed() ? PICK_UP : 0) | (st.drop_off_allowed() ? DROP_OFF : 0));
+                local_traffic_zones.push_back(st.local_traffic_zone);
+            }
+            return true;
+        });
+    }
+    boarding_times.shrink_to_fit();
+    alighting_times.shrink_to_fit();
+    flags.shrink_to_fit();
+    local_traffic_zones.shrink_to_fit();
+}
+
+
+static void set_jp_validity_patterns(std::vector<boost::dynamic_bitset<>>& jp_vp,
+                                     const type::RTLevel rt_level,
+                                     const JpIdx& jp_idx,
+                                     const JourneyPattern& jp) {
+    for (int i = 0; i <= 365; ++i) {
+        jp.for_each_vehicle_journey([&](const nt::VehicleJourney& vj) {
+            if (vj.validity_patterns[rt_level]->check2(i)) {
+                jp_vp[i].set(jp_idx.val);
+                return false;
+            }
+            return true;
+        });
+    }
+}
 
 void dataRAPTOR::load(const type::PT_Data& data, size_t cache_size)
 {
     jp_container.load(data);
-    labels_const.init_inf(data.stop_points);
-    labels_const_reverse.init_min(data.stop_points);
-
-    connections.load(data);
-    jpps_from_sp.load(data, jp_container);
-    jpps_from_jp.load(jp_container);
     next_stop_time_data.load(jp_container);
 
     for (auto level_cont: jp_validity_patterns) {
@@ -98,18 +135,52 @@ void dataRAPTOR::load(const type::PT_Data& data, size_t cache_size)
         auto& jp_vp = level_cont.second;
         jp_vp.assign(366, boost::dynamic_bitset<>(jp_container.nb_jps()));
         for (const auto& jp: jp_container.get_jps()) {
+            set_jp_validity_patterns(jp_vp, rt_level, jp.first, jp.second);
+        }
+    }
+
+    load_from_jp_container(data, cache_size);
+}
+
+void dataRAPTOR::update(const type::PT_Data& data,
+                        const dataRAPTOR& previous,
+                        const std::set<type::idx_t>& modified_routes,
+                        size_t cache_size)
+{
+    const auto previous_jps = jp_container.update(data, previous.jp_container, modified_routes);
+    next_stop_time_data.update(jp_container, previous_jps,
+                               previous.jp_container, previous.next_stop_time_data);
+
+    for (auto level_cont: jp_validity_patterns) {
+        const auto rt_level = level_cont.first;
+        auto& jp_vp = level_cont.second;
+        const auto& previous_jp_vp = previous.jp_validity_patterns[rt_level];
+        jp_vp.assign(366, boost::dynamic_bitset<>(jp_container.nb_jps()));
+        for (const auto& jp: jp_container.get_jps()) {
+            const auto& previous_jp_idx = previous_jps[jp.first.val];
+            if (! previous_jp_idx) {
+                set_jp_validity_patterns(jp_vp, rt_level, jp.first, jp.second);
+                continue;
+            }
             for (int i = 0; i <= 365; ++i) {
-                jp.second.for_each_vehicle_journey([&](const nt::VehicleJourney& vj) {
-                    if (vj.validity_patterns[rt_level]->check2(i)) {
-                        jp_vp[i].set(jp.first.val);
-                        return false;
-                    }
-                    return true;
-                });
+                jp_vp[i][jp.first.val] = previous_jp_vp[i][previous_jp_idx->val];
             }
         }
     }
 
+    load_from_jp_container(data, cache_size);
+}
+
+void dataRAPTOR::load_from_jp_container(const type::PT_Data& data, size_t cache_size)
+{
+    labels_const.init_inf(data.stop_points);
+    labels_const_reverse.init_min(data.stop_points);
+
+    connections.load(data);
+    jpps_from_sp.load(data, jp_container);
+    jpps_from_jp.load(jp_container);
+    stop_times.load(jp_container);
+
     min_connection_time = std::numeric_limits<uint32_t>::max();
     for (const auto& conns : connections.forward_connections) {
         for (const auto& conn : conns.second) {
@@ -100,6 +100,43 @@ struct dataRAPTOR {
     };
     JppsFromJp jpps_from_jp;
 
+    // cache friendly access to the stop times of the vehicle journeys,
+    // used by the raptor scan once on board. The stop times of a vj are
+    // contiguous (in their order) and the vjs of a journey pattern are
+    // stored together, so scanning a vj walks sequential memory instead of
+    // dereferencing the StopTime objects.
+    struct StopTimes {
+        enum Flag : uint8_t {
+            PICK_UP = 1 << 0,
+            DROP_OFF = 1 << 1
+        };
+        // index of the first stop time of the vj
+        inline uint32_t first_st(const type::VehicleJourney& vj) const {
+            return first_st_by_vj[vj.idx];
+        }
+        // index of the given stop time
+        inline uint32_t st_idx(const type::StopTime& st) const {
+            return first_st(*st.vehicle_journey) + st.order();
+        }
+        inline DateTime section_end(const uint32_t st, const DateTime base_dt, const bool clockwise) const {
+            return base_dt + (clockwise ? alighting_times[st] : boarding_times[st]);
+        }
+        inline bool valid_end(const uint32_t st, const bool clockwise) const {
+            return flags[st] & (clockwise ? DROP_OFF : PICK_UP);
+        }
+        inline uint16_t local_traffic_zone(const uint32_t st) const {
+            return local_traffic_zones[st];
+        }
+        void load(const JourneyPatternContainer&);
+    private:
+        std::vector<uint32_t> boarding_times;
+        std::vector<uint32_t> alighting_times;
+        std::vector<uint8_t> flags;
+        std::vector<uint16_t> local_traffic_zones;
+        std::vector<uint32_t> first_st_by_vj;
+    };
+    StopTimes stop_times;
+
     NextStopTimeData next_stop_time_data;
     std::unique_ptr<CachedNextStopTimeManager> cached_next_st_manager;
 
@@ -114,6 +151,19 @@ struct dataRAPTOR {
 
     dataRAPTOR() {}
     void load(const navitia::type::PT_Data&, size_t cache_size = 10);
+
+    // Same as load, but only the jps of the modified routes are computed,
+    // the ones of the other routes are reused from previous.
+    // previous must have been loaded from the PT_Data from which the
+    // given one has been cloned (and previous must be alive during the update).
+    void update(const navitia::type::PT_Data&,
+                const dataRAPTOR& previous,
+                const std::set<type::idx_t>& modified_routes,
+                size_t cache_size = 10);
+
+private:
+    // load everything but the jp_container, the next_stop_time_data and the jp_validity_patterns
+    void load_from_jp_container(const navitia::type::PT_Data&, size_t cache_size);
 };
 
 }}
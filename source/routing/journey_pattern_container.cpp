@@ -65,6 +65,36 @@ void JourneyPatternContainer::load(const nt::PT_Data& pt_data) {
     }
 }
 
+// The jps of a route are only made of vjs of this route and the routes
+// are processed in order, thus the jps (and their jpps) of a route form a
+// contiguous block, in the same order as in load.  Copying the block of
+// the unmodified routes gives exactly the same container as load.
+std::vector<boost::optional<JpIdx>>
+JourneyPatternContainer::update(const nt::PT_Data& pt_data,
+                                const JourneyPatternContainer& previous,
+                                const std::set<nt::idx_t>& modified_routes) {
+    map.clear();
+    jps.clear();
+    jpps.clear();
+    jps_from_route.assign(pt_data.routes);
+    jp_from_vj.assign(pt_data.vehicle_journeys);
+    jps_from_phy_mode.assign(pt_data.physical_modes);
+    std::vector<boost::optional<JpIdx>> previous_jps;
+    for (const auto* route: pt_data.routes) {
+        if (modified_routes.count(route->idx)) {
+            for (const auto& vj: route->discrete_vehicle_journey_list) { add_vj(*vj); }
+            for (const auto& vj: route->frequency_vehicle_journey_list) { add_vj(*vj); }
+            previous_jps.resize(jps.size());
+        } else {
+            for (const auto& previous_jp_idx: previous.jps_from_route[RouteIdx(*route)]) {
+                copy_jp(pt_data, previous, previous_jp_idx);
+                previous_jps.push_back(previous_jp_idx);
+            }
+        }
+    }
+    return previous_jps;
+}
+
 const JppIdx& JourneyPatternContainer::get_jpp(const type::StopTime& st) const {
     const auto& jp = get(jp_from_vj[VjIdx(*st.vehicle_journey)]);
     return jp.jpps.at(st.order());
@@ -203,6 +233,39 @@ JpIdx JourneyPatternContainer::make_jp(const JpKey& key) {
     return jp_idx;
 }
 
+// the vjs of previous belong to another PT_Data, we get the ones with the same uri
+template<typename VJ>
+static const VJ* get_same_vj(const nt::PT_Data& pt_data, const VJ& vj) {
+    const auto* res = pt_data.vehicle_journeys_map.at(vj.uri);
+    assert(dynamic_cast<const VJ*>(res));
+    return static_cast<const VJ*>(res);
+}
+
+void JourneyPatternContainer::copy_jp(const nt::PT_Data& pt_data,
+                                      const JourneyPatternContainer& previous,
+                                      const JpIdx& previous_jp_idx) {
+    const auto& previous_jp = previous.get(previous_jp_idx);
+    const auto jp_idx = JpIdx(jps.size());
+    JourneyPattern jp;
+    jp.route_idx = previous_jp.route_idx;
+    jp.phy_mode_idx = previous_jp.phy_mode_idx;
+    for (const auto& previous_jpp_idx: previous_jp.jpps) {
+        const auto& previous_jpp = previous.get(previous_jpp_idx);
+        jp.jpps.push_back(make_jpp(jp_idx, previous_jpp.sp_idx, previous_jpp.order));
+    }
+    for (const auto* vj: previous_jp.discrete_vjs) {
+        jp.discrete_vjs.push_back(get_same_vj(pt_data, *vj));
+        jp_from_vj[VjIdx(*jp.discrete_vjs.back())] = jp_idx;
+    }
+    for (const auto* vj: previous_jp.freq_vjs) {
+        jp.freq_vjs.push_back(get_same_vj(pt_data, *vj));
+        jp_from_vj[VjIdx(*jp.freq_vjs.back())] = jp_idx;
+    }
+    jps_from_route[jp.route_idx].push_back(jp_idx);
+    jps_from_phy_mode[jp.phy_mode_idx].push_back(jp_idx);
+    jps.push_back(std::move(jp));
+}
+
 JppIdx JourneyPatternContainer::make_jpp(const JpIdx& jp_idx, const SpIdx& sp_idx, uint16_t order) {
     const auto idx = JppIdx(jpps.size());
     jpps.push_back({jp_idx, sp_idx, order});
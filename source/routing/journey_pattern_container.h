@@ -32,6 +32,7 @@ www.navitia.io
 
 #include "raptor_utils.h"
 #include <boost/optional.hpp>
+#include <set>
 
 namespace navitia { namespace type {
 
@@ -88,6 +89,17 @@ struct JourneyPatternContainer {
     using JppRange = boost::iterator_range<JppIterator>;
 
     void load(const navitia::type::PT_Data&);
+
+    // Build the container as load(pt_data) would do, but only the jps of
+    // the modified routes are computed from their vjs, the jps of the
+    // other routes are copied from previous.
+    //
+    // Returns, for each jp, the jp of previous it has been copied from.
+    std::vector<boost::optional<JpIdx>>
+    update(const navitia::type::PT_Data&,
+           const JourneyPatternContainer& previous,
+           const std::set<type::idx_t>& modified_routes);
+
     size_t nb_jps() const { return jps.size(); }
     size_t nb_jpps() const { return jpps.size(); }
     const JourneyPattern& get(const JpIdx& idx) const {
@@ -173,6 +185,7 @@ private:
     // We have a vector to manage overtaking vjs
     using Map = std::map<JpKey, std::vector<JpIdx>>;
 
+    // Only contains the jps built by add_vj, i.e. not the ones copied by update.
     Map map;
     std::vector<JourneyPattern> jps;
     std::vector<JourneyPatternPoint> jpps;
@@ -183,6 +196,7 @@ private:
     template<typename VJ> void add_vj(const VJ&);
     template<typename VJ> static JpKey make_key(const VJ&);
     JpIdx make_jp(const JpKey&);
+    void copy_jp(const navitia::type::PT_Data&, const JourneyPatternContainer&, const JpIdx&);
     JppIdx make_jpp(const JpIdx&, const SpIdx&, uint16_t order);
     JourneyPattern& get_mut(const JpIdx&);
 };
@@ -37,7 +37,10 @@ www.navitia.io
 #include "type/type_utils.h"
 
 #include <boost/range/algorithm/sort.hpp>
-#include <boost/range/algorithm_ext/push_back.hpp>
+#include <algorithm>
+#include <chrono>
+#include <exception>
+#include <thread>
 
 namespace navitia { namespace routing {
 
@@ -80,10 +83,95 @@ void NextStopTimeData::TimesStopTimes<Getter>::init(const JourneyPattern& jp,
         return st1_first.vehicle_journey->idx < st2_first.vehicle_journey->idx;
     });
 
-    // collect the corresponding times
+    // collect the corresponding times and vehicle properties
     times.reserve(stop_times.size());
+    vehicle_properties.reserve(stop_times.size());
     for (const auto* st: stop_times) {
         times.push_back(DateTimeUtils::hour(getter.get_time(*st)));
+        vehicle_properties.push_back(st->vehicle_journey->vehicles().to_ulong());
+    }
+}
+
+template<typename Getter>
+void NextStopTimeData::TimesStopTimes<Getter>::translate(const TimesStopTimes& other,
+        const std::unordered_map<const type::VehicleJourney*, const type::VehicleJourney*>& vj_map) {
+    times = other.times;
+    stop_times.reserve(other.stop_times.size());
+    vehicle_properties.reserve(other.stop_times.size());
+    for (const auto* st: other.stop_times) {
+        const auto* vj = vj_map.at(st->vehicle_journey);
+        stop_times.push_back(&vj->stop_time_list[st->order()]);
+        vehicle_properties.push_back(vj->vehicles().to_ulong());
+    }
+}
+
+template<typename Getter>
+std::pair<const type::StopTime*, DateTime>
+NextStopTimeData::TimesStopTimes<Getter>::earliest_valid_stop_time(const DateTime dt,
+        const type::RTLevel rt_level,
+        const type::VehicleProperties& vehicle_props,
+        const DateTime bound) const {
+    const uint8_t required = vehicle_props.to_ulong();
+    auto date = DateTimeUtils::date(dt);
+    size_t idx = packed::lower_bound(times.data(), times.size(), DateTimeUtils::hour(dt));
+
+    // we look at the stop times of the day of dt after hour(dt), and
+    // if none was found, we try again the next day
+    for (int nb_days = 0; nb_days < 2; ++nb_days, ++date, idx = 0) {
+        const DateTime day_begin = DateTimeUtils::set(date, 0);
+        if (bound < day_begin) { break; }
+        const DateTime hour_bound = bound - day_begin;
+
+        // the kernel skips the stop times not accessible with vehicle_props,
+        // only the validity of the remaining candidates is tested here
+        for (idx = packed::next_candidate(times.data(), vehicle_properties.data(),
+                                          idx, times.size(), hour_bound, required);
+             idx < times.size();
+             idx = packed::next_candidate(times.data(), vehicle_properties.data(),
+                                          idx + 1, times.size(), hour_bound, required)) {
+            if (times[idx] > hour_bound) { return {nullptr, DateTimeUtils::inf}; }
+            const auto* st = stop_times[idx];
+            if (st->is_valid_day(date, false, rt_level)) {
+                return {st, day_begin + times[idx]};
+            }
+        }
+    }
+
+    // if nothing found, return max
+    return {nullptr, DateTimeUtils::inf};
+}
+
+void NextStopTimeData::update(const JourneyPatternContainer& jp_container,
+                              const std::vector<boost::optional<JpIdx>>& previous_jps,
+                              const JourneyPatternContainer& previous_container,
+                              const NextStopTimeData& previous) {
+    departure.assign(jp_container.get_jpps_values());
+    arrival.assign(jp_container.get_jpps_values());
+
+    std::unordered_map<const type::VehicleJourney*, const type::VehicleJourney*> vj_map;
+    for (const auto& jp: jp_container.get_jps()) {
+        const auto& previous_jp_idx = previous_jps.at(jp.first.val);
+        if (! previous_jp_idx) {
+            for (const auto& jpp_idx: jp.second.jpps) {
+                const auto& jpp = jp_container.get(jpp_idx);
+                departure[jpp_idx].init(jp.second, jpp);
+                arrival[jpp_idx].init(jp.second, jpp);
+            }
+            continue;
+        }
+
+        // the copied jp has the same vjs in the same order as the previous one
+        const auto& previous_jp = previous_container.get(*previous_jp_idx);
+        vj_map.clear();
+        for (size_t i = 0; i < jp.second.discrete_vjs.size(); ++i) {
+            vj_map[previous_jp.discrete_vjs[i]] = jp.second.discrete_vjs[i];
+        }
+        for (size_t i = 0; i < jp.second.jpps.size(); ++i) {
+            const auto& jpp_idx = jp.second.jpps[i];
+            const auto& previous_jpp_idx = previous_jp.jpps[i];
+            departure[jpp_idx].translate(previous.departure[previous_jpp_idx], vj_map);
+            arrival[jpp_idx].translate(previous.arrival[previous_jpp_idx], vj_map);
+        }
     }
 }
 
@@ -111,44 +199,6 @@ is_valid(const type::StopTime* st,
             st->vehicle_journey->accessible(vehicle_props);
 }
 
-/** Which is the first valid stop_time in this range ?
- *  Returns invalid_idx is none is
- */
-static std::pair<const type::StopTime*, DateTime>
-next_valid_discrete(const StopEvent stop_event,
-        const dataRAPTOR& dataRaptor,
-        const JppIdx jpp_idx,
-        const DateTime dt,
-        const type::RTLevel rt_level,
-        const type::VehicleProperties& vehicle_props,
-        const DateTime bound) {
-    auto date = DateTimeUtils::date(dt);
-    for (const auto* st: dataRaptor.next_stop_time_data.stop_time_range_after(jpp_idx, dt, stop_event)) {
-        assert(dataRaptor.jp_container.get_jpp(*st) == jpp_idx);
-        const uint32_t hour = (stop_event == StopEvent::pick_up) ? st->boarding_time : st->alighting_time;
-        const DateTime cur_dt = DateTimeUtils::set(date, DateTimeUtils::hour(hour));
-        if (bound < cur_dt) { return {nullptr, DateTimeUtils::inf}; }
-        if (is_valid(st, date, true, rt_level, vehicle_props)) {
-            return {st, cur_dt};
-        }
-    }
-
-    //if none was found, we try again the next day
-    date++;
-    for (const auto* st: dataRaptor.next_stop_time_data.stop_time_range_forward(jpp_idx, stop_event)) {
-        assert(dataRaptor.jp_container.get_jpp(*st) == jpp_idx);
-        const uint32_t hour = (stop_event == StopEvent::pick_up) ? st->boarding_time : st->alighting_time;
-        const DateTime cur_dt = DateTimeUtils::set(date, DateTimeUtils::hour(hour));
-        if (bound < cur_dt) { return {nullptr, DateTimeUtils::inf}; }
-        if (is_valid(st, date, true, rt_level, vehicle_props)) {
-            return {st, cur_dt};
-        }
-    }
-
-    // if nothing found, return max
-    return {nullptr, DateTimeUtils::inf};
-}
-
 static std::pair<const type::StopTime*, DateTime>
 next_valid_frequency(const StopEvent stop_event,
         const dataRAPTOR& dataRaptor,
@@ -294,8 +344,8 @@ NextStopTime::earliest_stop_time(const StopEvent stop_event,
         const bool check_freq,
         const DateTime bound) const
 {
-    const auto first_discrete_st_pair =
-            next_valid_discrete(stop_event, *data.dataRaptor, jpp_idx, dt, rt_level, vehicle_props, bound);
+    const auto first_discrete_st_pair = data.dataRaptor->next_stop_time_data.earliest_valid_stop_time(
+            jpp_idx, dt, stop_event, rt_level, vehicle_props, bound);
 
     if (check_freq) {
         const auto first_frequency_st_pair =
@@ -430,6 +480,7 @@ bool CachedNextStopTimeKey::operator<(const CachedNextStopTimeKey& other) const
 }
 
 CachedNextStopTime CachedNextStopTimeManager::CacheCreator::operator()(const CachedNextStopTimeKey& key) const {
+    const auto begin = std::chrono::steady_clock::now();
     CachedNextStopTime::vDtStByJpp departure, arrival;
     const auto& jp_container = dataRaptor.jp_container;
 
@@ -453,23 +504,31 @@ CachedNextStopTime CachedNextStopTimeManager::CacheCreator::operator()(const Cac
     for (const auto& jpp_dtst : departure) {
         boost::sort(jpp_dtst.second, compare);
     }
-    return {departure, arrival};
+    CachedNextStopTime res{departure, arrival};
+
+    const auto duration = std::chrono::steady_clock::now() - begin;
+    ++build_stats->nb_builds;
+    build_stats->build_time_ms += std::chrono::duration_cast<std::chrono::milliseconds>(duration).count();
+    return res;
 }
 
 CachedNextStopTime::DtStFromJpp::DtStFromJpp(const vDtStByJpp& map) {
     until.assign(map, 0);
     for (const auto& elt: map) {
-        boost::push_back(dtsts, elt.second);
-        until[elt.first] = dtsts.size();
+        for (const auto& dtst: elt.second) {
+            times.push_back(dtst.first);
+            stop_times.push_back(dtst.second);
+        }
+        until[elt.first] = times.size();
     }
-    dtsts.shrink_to_fit();
+    times.shrink_to_fit();
+    stop_times.shrink_to_fit();
 }
 
-boost::iterator_range<CachedNextStopTime::vDtSt::const_iterator>
-CachedNextStopTime::DtStFromJpp::operator[](const JppIdx& jpp_idx) const {
+std::pair<uint32_t, uint32_t>
+CachedNextStopTime::DtStFromJpp::bounds(const JppIdx& jpp_idx) const {
     const auto from = jpp_idx.val == 0 ? 0 : until[JppIdx(jpp_idx.val - 1)];
-    const auto begin = dtsts.begin();
-    return boost::make_iterator_range(begin + from, begin + until[jpp_idx]);
+    return {from, until[jpp_idx]};
 }
 
 std::pair<const type::StopTime*, DateTime>
@@ -477,25 +536,23 @@ CachedNextStopTime::next_stop_time(const StopEvent stop_event,
         const JppIdx jpp_idx,
         const DateTime dt,
         const bool clockwise) const {
-    const auto& v = (stop_event == StopEvent::pick_up ? departure[jpp_idx]
-                                                      : arrival[jpp_idx]);
-    const type::StopTime* null_st = nullptr;
-    decltype(v.begin()) search;
-    auto cmp = [](const CachedNextStopTime::DtSt& a, const CachedNextStopTime::DtSt& b) noexcept {
-        return a.first < b.first;
-    };
+    const auto& v = (stop_event == StopEvent::pick_up ? departure : arrival);
+    const auto bounds = v.bounds(jpp_idx);
+    const DateTime* times = v.times.data() + bounds.first;
+    const size_t size = bounds.second - bounds.first;
+    size_t search;
     if (clockwise) {
-        search = boost::lower_bound(v, std::make_pair(dt, null_st), cmp);
+        search = packed::lower_bound(times, size, dt);
     } else {
-        search = boost::upper_bound(v, std::make_pair(dt, null_st), cmp);
-        if (search == v.begin()) {
-            search = v.end();
-        } else if (!v.empty()) {
+        search = packed::upper_bound(times, size, dt);
+        if (search == 0) {
+            search = size;
+        } else {
             --search;
         }
     }
-    if (search != v.end()) {
-        return {search->second, search->first};
+    if (search != size) {
+        return {v.stop_times[bounds.first + search], times[search]};
     }
     return {nullptr, 0};
 }
@@ -513,6 +570,59 @@ CachedNextStopTimeManager::load(const DateTime from,
     return lru(key);
 }
 
+void CachedNextStopTimeManager::prewarm(const DateTime from,
+                                        const size_t nb_days,
+                                        const std::vector<type::RTLevel>& rt_levels,
+                                        const std::vector<type::AccessibiliteParams>& accessibilite_params,
+                                        const size_t nb_threads) {
+    std::vector<CachedNextStopTimeKey> keys;
+    for (size_t day = DateTimeUtils::date(from); day < DateTimeUtils::date(from) + nb_days; ++day) {
+        for (const auto rt_level: rt_levels) {
+            for (const auto& params: accessibilite_params) {
+                keys.emplace_back(day, rt_level, params);
+            }
+        }
+    }
+    if (keys.size() > max_cache) {
+        auto logger = log4cplus::Logger::getInstance("log");
+        LOG4CPLUS_WARN(logger, "only " << max_cache << " raptor caches on " << keys.size()
+                       << " can be prewarmed, the cache is too small");
+        keys.resize(max_cache);
+    }
+
+    // each thread builds the next key not yet taken
+    std::atomic<size_t> next_key{0};
+    std::vector<std::exception_ptr> exceptions(std::max(nb_threads, size_t(1)));
+    auto build = [&](const size_t thread_idx) {
+        try {
+            for (size_t i = next_key++; i < keys.size(); i = next_key++) {
+                lru(keys[i]);
+            }
+        } catch (...) {
+            exceptions[thread_idx] = std::current_exception();
+        }
+    };
+    std::vector<std::thread> threads;
+    for (size_t i = 1; i < nb_threads; ++i) {
+        threads.emplace_back(build, i);
+    }
+    build(0);
+    for (auto& thread: threads) { thread.join(); }
+
+    for (const auto& exception: exceptions) {
+        if (exception) { std::rethrow_exception(exception); }
+    }
+}
+
+CachedNextStopTimeManager::Stats CachedNextStopTimeManager::get_stats() {
+    Stats stats;
+    stats.nb_calls = lru.get_nb_calls();
+    stats.nb_cache_miss = lru.get_nb_cache_miss();
+    stats.nb_builds = build_stats->nb_builds;
+    stats.build_time_ms = build_stats->build_time_ms;
+    return stats;
+}
+
 inline static bool within(u_int32_t val, std::pair<u_int32_t, u_int32_t> bound) {
     return val >= bound.first && val <= bound.second;
 }
@@ -32,15 +32,17 @@ www.navitia.io
 
 #include "routing/stop_event.h"
 #include "routing/raptor_utils.h"
+#include "routing/packed_search.h"
 #include "utils/idx_map.h"
 #include "utils/lru.h"
 #include "type/rt_level.h"
 #include "type/type.h"
 
-#include <boost/range/algorithm/lower_bound.hpp>
-#include <boost/range/algorithm/upper_bound.hpp>
 #include <boost/optional.hpp>
 #include <boost/dynamic_bitset.hpp>
+#include <unordered_map>
+#include <atomic>
+#include <memory>
 
 namespace navitia {
 
@@ -63,6 +65,14 @@ struct NextStopTimeData {
 
     void load(const JourneyPatternContainer&);
 
+    // As load, but the stop times of the jps copied from the previous
+    // container (see JourneyPatternContainer::update) are not sorted
+    // again, they are translated from the previous data.
+    void update(const JourneyPatternContainer&,
+                const std::vector<boost::optional<JpIdx>>& previous_jps,
+                const JourneyPatternContainer& previous_container,
+                const NextStopTimeData& previous);
+
     // Returns the range of the stop times in increasing time order
     inline StopTimeIter stop_time_range_forward(const JppIdx jpp_idx,
                                                 const StopEvent stop_event) const {
@@ -99,6 +109,22 @@ struct NextStopTimeData {
             return arrival[jpp_idx].prev_stop_time_range(dt);
         }
     }
+    // Returns the first stop time after dt and not after bound that
+    // is valid on its day and accessible with vehicle_props, looking
+    // at the day of dt and the next one
+    inline std::pair<const type::StopTime*, DateTime>
+    earliest_valid_stop_time(const JppIdx jpp_idx,
+                             const DateTime dt,
+                             const StopEvent stop_event,
+                             const type::RTLevel rt_level,
+                             const type::VehicleProperties& vehicle_props,
+                             const DateTime bound) const {
+        if (stop_event == StopEvent::pick_up) {
+            return departure[jpp_idx].earliest_valid_stop_time(dt, rt_level, vehicle_props, bound);
+        } else {
+            return arrival[jpp_idx].earliest_valid_stop_time(dt, rt_level, vehicle_props, bound);
+        }
+    }
 
 private:
     struct Departure {
@@ -115,6 +141,9 @@ private:
         // for all i, cmp.get_time(stop_times[i]) == times[i]
         std::vector<DateTime> times;
         std::vector<const type::StopTime*> stop_times;
+        // vehicle_properties[i] are the properties of the vj of
+        // stop_times[i], packed to be tested by blocks
+        std::vector<uint8_t> vehicle_properties;
         Getter getter;
 
         // Returns the range of stop times
@@ -127,17 +156,23 @@ private:
         }
         // Returns the range of stop times next to hour(dt)
         inline StopTimeIter next_stop_time_range(const DateTime dt) const {
-            const auto it = boost::lower_bound(times, DateTimeUtils::hour(dt));
-            const auto idx = it - times.begin();
+            const auto idx = packed::lower_bound(times.data(), times.size(), DateTimeUtils::hour(dt));
             return boost::make_iterator_range(stop_times.begin() + idx, stop_times.end());
         }
         // Returns the range of stop times previous to hour(dt)
         inline StopTimeReverseIter prev_stop_time_range(const DateTime dt) const {
-            const auto it = boost::upper_bound(times, DateTimeUtils::hour(dt));
-            const auto idx = it - times.begin();
+            const auto idx = packed::upper_bound(times.data(), times.size(), DateTimeUtils::hour(dt));
             return boost::make_iterator_range(stop_times.rend() - idx, stop_times.rend());
         }
+        std::pair<const type::StopTime*, DateTime>
+        earliest_valid_stop_time(const DateTime dt,
+                                 const type::RTLevel rt_level,
+                                 const type::VehicleProperties& vehicle_props,
+                                 const DateTime bound) const;
         void init(const JourneyPattern& jp, const JourneyPatternPoint& jpp);
+        // copy other, with its stop times translated to the vjs given by vj_map
+        void translate(const TimesStopTimes& other,
+                       const std::unordered_map<const type::VehicleJourney*, const type::VehicleJourney*>& vj_map);
     };
     IdxMap<JourneyPatternPoint, TimesStopTimes<Departure>> departure;
     IdxMap<JourneyPatternPoint, TimesStopTimes<Arrival>> arrival;
@@ -229,17 +264,16 @@ struct CachedNextStopTime {
                    const bool clockwise) const;
 
 private:
-    // This structure provide the same interface as a vDtStByJpp, but
+    // This structure provide the same data as a vDtStByJpp, but
     // in a condensed and read only view.
     struct DtStFromJpp {
         DtStFromJpp(const vDtStByJpp& map);
 
-        // Returns the range corresponding to map[jpp_idx], i.e. from
-        // dtsts[until[prev(jpp_idx)]] to dtsts[until[jpp_idx]]
-        // (excluded).
-        boost::iterator_range<vDtSt::const_iterator> operator[](const JppIdx& jpp_idx) const;
+        // Returns the indexes corresponding to map[jpp_idx] in times
+        // and stop_times, i.e. from until[prev(jpp_idx)] to
+        // until[jpp_idx] (excluded).
+        std::pair<uint32_t, uint32_t> bounds(const JppIdx& jpp_idx) const;
 
-    private:
         // let map[JppIdx(40)] == []
         //     map[JppIdx(41)] == [a, l]
         //     map[JppIdx(42)] == [x, y, z]
@@ -248,17 +282,20 @@ private:
         //                  |           |            |        |
         //                  ------------+------,     |        |
         //                                     V     V        V
-        // dtsts: [...................... , o, a, l, x, y, z, p, q, ...]
+        // times: [...................... , o, a, l, x, y, z, p, q, ...]
         //                                           ^^^^^^^
         //                                      range of values
         //                                      corresponding to
         //                                      map[JppIdx(42)]
         //
         // Every vectors of map concatenated in order
-        // (flatten(map.values())).
-        vDtSt dtsts;
+        // (flatten(map.values())), the datetimes and the stop times
+        // in separate vectors to have packed times to search in.
+        std::vector<DateTime> times;
+        std::vector<const type::StopTime*> stop_times;
 
-        // dtsts[until[jpp_idx]] correspond to the end of
+    private:
+        // times[until[jpp_idx]] correspond to the end of
         // map[jpp_idx], and to the begin of map[next(jpp_idx)]
         IdxMap<JourneyPatternPoint, uint32_t> until;
     };
@@ -267,8 +304,19 @@ private:
 };
 
 struct CachedNextStopTimeManager {
+    // Counters of the cache, for monitoring
+    struct Stats {
+        size_t nb_calls = 0;
+        size_t nb_cache_miss = 0;
+        size_t nb_builds = 0;
+        // total time spent building caches, in milliseconds
+        uint64_t build_time_ms = 0;
+    };
+
     explicit CachedNextStopTimeManager(const dataRAPTOR& dataRaptor, size_t max_cache) :
-            lru({dataRaptor}, max_cache) {}
+            build_stats(std::make_shared<BuildStats>()),
+            lru({dataRaptor, build_stats}, max_cache),
+            max_cache(max_cache) {}
     CachedNextStopTimeManager& operator=(CachedNextStopTimeManager&&) = default;
     ~CachedNextStopTimeManager();
 
@@ -277,16 +325,36 @@ struct CachedNextStopTimeManager {
          const type::RTLevel rt_level,
          const type::AccessibiliteParams& accessibilite_params);
 
+    // Builds the caches of the nb_days days beginning at the day of
+    // from, for each given rt level and accessibility, with nb_threads
+    // threads. There is no use building more caches than the lru can
+    // keep, thus only the max_cache first ones are built.
+    void prewarm(const DateTime from,
+                 const size_t nb_days,
+                 const std::vector<type::RTLevel>& rt_levels,
+                 const std::vector<type::AccessibiliteParams>& accessibilite_params,
+                 const size_t nb_threads);
+
+    Stats get_stats();
+
 private:
+    // shared by the manager and its cache creator
+    struct BuildStats {
+        std::atomic<size_t> nb_builds{0};
+        std::atomic<uint64_t> build_time_ms{0};
+    };
     struct CacheCreator {
         typedef CachedNextStopTimeKey const& argument_type;
         typedef CachedNextStopTime result_type;
         const dataRAPTOR& dataRaptor;
-        CacheCreator(const dataRAPTOR& d): dataRaptor(d) {}
+        std::shared_ptr<BuildStats> build_stats;
+        CacheCreator(const dataRAPTOR& d, std::shared_ptr<BuildStats> s): dataRaptor(d), build_stats(s) {}
         CachedNextStopTime operator()(const CachedNextStopTimeKey& key) const;
     };
 
+    std::shared_ptr<BuildStats> build_stats;
     ConcurrentLru<CacheCreator> lru;
+    size_t max_cache;
 };
 
 DateTime get_next_stop_time(const StopEvent stop_event,
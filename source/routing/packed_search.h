@@ -0,0 +1,149 @@
+/* Copyright © 2001-2014, Canal TP and/or its affiliates. All rights reserved.
+
+This file is part of Navitia,
+    the software to build cool stuff with public transport.
+
+Hope you'll enjoy and contribute to this project,
+    powered by Canal TP (www.canaltp.fr).
+Help us simplify mobility and open public transport:
+    a non ending quest to the responsive locomotion way of traveling!
+
+LICENCE: This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU Affero General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU Affero General Public License for more details.
+
+You should have received a copy of the GNU Affero General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+Stay tuned using
+twitter @navitia
+IRC #navitia on freenode
+https://groups.google.com/d/forum/navitia
+www.navitia.io
+*/
+
+#pragma once
+
+#include "type/datetime.h"
+
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace navitia { namespace routing { namespace packed {
+
+/*
+ * Search kernels on the packed arrays of NextStopTimeData and
+ * CachedNextStopTime.
+ *
+ * The candidates are tested by blocks of `width`, using the widest
+ * instruction set enabled at compile time (AVX2, then SSE2), with a
+ * scalar fallback.
+ */
+constexpr size_t width = 8;
+
+// Returns a mask whose bit i is set iff times[i] > value, for the
+// `width` first times.
+inline uint32_t greater_mask(const DateTime* times, const DateTime value) {
+#if defined(__AVX2__)
+    // there is only signed comparisons: flipping the sign bit maps
+    // the unsigned order on the signed one
+    const __m256i sign = _mm256_set1_epi32(INT32_MIN);
+    const __m256i v = _mm256_xor_si256(_mm256_set1_epi32(static_cast<int32_t>(value)), sign);
+    const __m256i t = _mm256_xor_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(times)), sign);
+    return static_cast<uint32_t>(_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(t, v))));
+#elif defined(__SSE2__)
+    const __m128i sign = _mm_set1_epi32(INT32_MIN);
+    const __m128i v = _mm_xor_si128(_mm_set1_epi32(static_cast<int32_t>(value)), sign);
+    const __m128i lo = _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(times)), sign);
+    const __m128i hi = _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(times + 4)), sign);
+    return static_cast<uint32_t>(_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpgt_epi32(lo, v))))
+        | static_cast<uint32_t>(_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpgt_epi32(hi, v)))) << 4;
+#else
+    uint32_t mask = 0;
+    for (size_t i = 0; i < width; ++i) {
+        if (times[i] > value) { mask |= 1u << i; }
+    }
+    return mask;
+#endif
+}
+
+// Returns a mask whose bit i is set iff props[i] has all the required
+// properties, for the `width` first properties.
+inline uint32_t accessible_mask(const uint8_t* props, const uint8_t required) {
+#if defined(__SSE2__)
+    const __m128i r = _mm_set1_epi8(static_cast<char>(required));
+    const __m128i p = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(props));
+    return static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_and_si128(p, r), r))) & 0xff;
+#else
+    uint32_t mask = 0;
+    for (size_t i = 0; i < width; ++i) {
+        if ((props[i] & required) == required) { mask |= 1u << i; }
+    }
+    return mask;
+#endif
+}
+
+// Returns the index of the first time greater than value in the
+// sorted array times, as boost::upper_bound.
+inline size_t upper_bound(const DateTime* times, size_t size, const DateTime value) {
+    // bisect until the remaining range is worth a linear packed scan
+    size_t first = 0;
+    while (size > 4 * width) {
+        const size_t half = size / 2;
+        if (times[first + half] > value) {
+            size = half;
+        } else {
+            first += half + 1;
+            size -= half + 1;
+        }
+    }
+    const size_t last = first + size;
+    for (; first + width <= last; first += width) {
+        if (const auto mask = greater_mask(times + first, value)) {
+            return first + static_cast<size_t>(__builtin_ctz(mask));
+        }
+    }
+    for (; first < last && times[first] <= value; ++first) {}
+    return first;
+}
+
+// Returns the index of the first time not less than value in the
+// sorted array times, as boost::lower_bound.
+inline size_t lower_bound(const DateTime* times, const size_t size, const DateTime value) {
+    if (value == 0) { return 0; }
+    return upper_bound(times, size, value - 1);
+}
+
+// Returns the first index in [begin, end) whose time is greater than
+// bound or whose properties contain the required ones, end if none.
+inline size_t next_candidate(const DateTime* times,
+                             const uint8_t* props,
+                             size_t begin,
+                             const size_t end,
+                             const DateTime bound,
+                             const uint8_t required) {
+    for (; begin + width <= end; begin += width) {
+        const auto mask = greater_mask(times + begin, bound) | accessible_mask(props + begin, required);
+        if (mask) {
+            return begin + static_cast<size_t>(__builtin_ctz(mask));
+        }
+    }
+    for (; begin < end; ++begin) {
+        if (times[begin] > bound || (props[begin] & required) == required) { break; }
+    }
+    return begin;
+}
+
+}}} // namespace navitia::routing::packed
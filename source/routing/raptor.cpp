@@ -35,7 +35,12 @@ www.navitia.io
 #include <boost/range/adaptor/filtered.hpp>
 #include <boost/range/algorithm/find_if.hpp>
 #include <boost/range/algorithm/fill.hpp>
+#include <boost/range/algorithm/sort.hpp>
+#include <algorithm>
 #include <chrono>
+#include <exception>
+#include <functional>
+#include <thread>
 
 namespace bt = boost::posix_time;
 
@@ -50,6 +55,40 @@ DateTime limit_bound(const bool clockwise, const DateTime departure_datetime, co
         std::max(depart_anticlockwise, bound);
 }
 
+namespace {
+// Improve directly the labels of the round
+struct UpdateLabels {
+    Labels& working_labels;
+    IdxMap<type::StopPoint, DateTime>& best_labels_pts;
+
+    template<typename Visitor>
+    bool operator()(const Visitor& v, const SpIdx sp_idx, const DateTime dt) {
+        if (! v.comp(dt, best_labels_pts[sp_idx])) { return false; }
+        // during a profile query, the label may come from a later departure
+        if (! v.comp(dt, working_labels.dt_pt(sp_idx))) { return false; }
+        working_labels.mut_dt_pt(sp_idx) = dt;
+        best_labels_pts[sp_idx] = dt;
+        return true;
+    }
+};
+
+// Store the improvements of a thread, the labels are read only while
+// the journey patterns of a round are scanned in parallel
+struct StoreImprovements {
+    const Labels& working_labels;
+    const IdxMap<type::StopPoint, DateTime>& best_labels_pts;
+    std::vector<std::pair<SpIdx, DateTime>> improvements;
+
+    template<typename Visitor>
+    bool operator()(const Visitor& v, const SpIdx sp_idx, const DateTime dt) {
+        if (! v.comp(dt, best_labels_pts[sp_idx])) { return false; }
+        if (! v.comp(dt, working_labels.dt_pt(sp_idx))) { return false; }
+        improvements.emplace_back(sp_idx, dt);
+        return true;
+    }
+};
+}
+
 /*
  * Check if the given vj is valid for the given datetime,
  * If it is for every stoptime of the vj,
@@ -57,13 +96,13 @@ DateTime limit_bound(const bool clockwise, const DateTime departure_datetime, co
  * we mark it.
  * If the given vj also has an extension we apply it.
  */
-template<typename Visitor>
+template<typename Visitor, typename Updater>
 bool RAPTOR::apply_vj_extension(const Visitor& v,
                                 const nt::RTLevel rt_level,
                                 const type::VehicleJourney* vj,
                                 const uint16_t l_zone,
-                                DateTime base_dt) {
-    auto& working_labels = labels[count];
+                                DateTime base_dt,
+                                Updater& update) const {
     bool result = false;
     while(vj) {
         base_dt = v.get_base_dt_extension(base_dt, vj);
@@ -84,14 +123,9 @@ bool RAPTOR::apply_vj_extension(const Visitor& v,
                l_zone == st.local_traffic_zone) {
                 continue;
             }
-            auto sp = st.stop_point;
-            const auto sp_idx = SpIdx(*sp);
-
-            if (! v.comp(workingDt, best_labels_pts[sp_idx])) { continue; }
-
-            working_labels.mut_dt_pt(sp_idx) = workingDt;
-            best_labels_pts[sp_idx] = workingDt;
-            result = true;
+            if (update(v, SpIdx(*st.stop_point), workingDt)) {
+                result = true;
+            }
         }
         vj = v.get_extension_vj(vj);
     }
@@ -120,6 +154,7 @@ bool RAPTOR::foot_path(const Visitor& v) {
             const DateTime next = v.combine(previous, conn.duration);
 
             if (! v.comp(next, best_labels_transfers[destination_sp_idx])) { continue; }
+            if (! v.comp(next, working_labels.dt_transfer(destination_sp_idx))) { continue; }
 
             //if we can improve the best label, we mark it
             working_labels.mut_dt_transfer(destination_sp_idx) = next;
@@ -133,9 +168,7 @@ bool RAPTOR::foot_path(const Visitor& v) {
 
         // we mark the jpp order
         for (const auto& jpp: sp_jpps.second) {
-            if (v.comp(jpp.order, Q[jpp.jp_idx])) {
-                Q[jpp.jp_idx] = jpp.order;
-            }
+            mark_jp(jpp.jp_idx, jpp.order, v.clockwise());
         }
     }
 
@@ -143,9 +176,19 @@ bool RAPTOR::foot_path(const Visitor& v) {
 }
 
 
+void RAPTOR::clear_marked_jps() {
+    for (const auto jp_idx: marked_jps) {
+        is_marked_jp[jp_idx.val] = false;
+    }
+    marked_jps.clear();
+}
+
 void RAPTOR::clear(const bool clockwise, const DateTime bound) {
-    const int queue_value = clockwise ?  std::numeric_limits<int>::max() : -1;
-    Q.assign(data.dataRaptor->jp_container.get_jps_values(), queue_value);
+    clear_marked_jps();
+    if (scan_whole_queue) {
+        const int queue_value = clockwise ?  std::numeric_limits<int>::max() : -1;
+        Q.assign(data.dataRaptor->jp_container.get_jps_values(), queue_value);
+    }
     if (labels.empty()) {
         labels.resize(5);
     }
@@ -170,11 +213,7 @@ void RAPTOR::init(const map_stop_point_duration& dep,
         labels[0].mut_dt_transfer(sp_dt.first) = begin_dt;
         best_labels_transfers[sp_dt.first] = begin_dt;
         for (const auto jpp: jpps_from_sp[sp_dt.first]) {
-            if (clockwise && Q[jpp.jp_idx] > jpp.order) {
-                Q[jpp.jp_idx] = jpp.order;
-            } else if (! clockwise && Q[jpp.jp_idx] < jpp.order) {
-                Q[jpp.jp_idx] = jpp.order;
-            }
+            mark_jp(jpp.jp_idx, jpp.order, clockwise);
         }
     }
 }
@@ -203,6 +242,18 @@ void RAPTOR::first_raptor_loop(const map_stop_point_duration& dep,
         rt_level,
         accessibilite_params);
 
+    // compute_all swaps labels and first_pass_labels, thus they are
+    // alternatively cleaned in both directions. As first_pass_labels
+    // are outdated here, we can take them if they are already clean
+    // in our direction, keeping the clear proportional to the
+    // touched stop points.
+    const Labels& clean_labels =
+        clockwise ? data.dataRaptor->labels_const : data.dataRaptor->labels_const_reverse;
+    if (! labels.empty() && ! first_pass_labels.empty()
+            && ! labels.front().is_cleaned_with(clean_labels)
+            && first_pass_labels.front().is_cleaned_with(clean_labels)) {
+        swap(labels, first_pass_labels);
+    }
     clear(clockwise, bound);
     init(dep, departure_datetime, clockwise, accessibilite_params.properties);
 
@@ -498,6 +549,98 @@ RAPTOR::compute_all(const map_stop_point_duration& departures,
     return result;
 }
 
+namespace {
+struct ProfileDominates {
+    bool operator()(const ProfileJourney& lhs, const ProfileJourney& rhs) const {
+        return lhs.departure_dt >= rhs.departure_dt
+            && lhs.arrival_dt <= rhs.arrival_dt
+            && lhs.nb_transfers <= rhs.nb_transfers;
+    }
+};
+}
+
+// all the datetimes in [begin_dt, end_dt] at which we can leave to catch a vehicle at a departure
+static std::vector<DateTime>
+get_profile_departures(const RAPTOR& raptor,
+                       const map_stop_point_duration& departures,
+                       const DateTime begin_dt,
+                       const DateTime end_dt,
+                       const type::Properties& properties) {
+    std::vector<DateTime> res;
+    for (const auto& sp_dt: departures) {
+        if (! raptor.get_sp(sp_dt.first)->accessible(properties)) { continue; }
+        const DateTime sn_dur = sp_dt.second.total_seconds();
+        for (const auto& jpp: raptor.jpps_from_sp[sp_dt.first]) {
+            DateTime dt = begin_dt + sn_dur;
+            while (dt <= end_dt + sn_dur) {
+                const auto st_dt = raptor.next_st->next_stop_time(StopEvent::pick_up, jpp.idx, dt, true);
+                if (st_dt.first == nullptr || st_dt.second > end_dt + sn_dur) { break; }
+                res.push_back(st_dt.second - sn_dur);
+                dt = st_dt.second + 1;
+            }
+        }
+    }
+    boost::sort(res, std::greater<DateTime>());
+    res.erase(std::unique(res.begin(), res.end()), res.end());
+    return res;
+}
+
+std::vector<ProfileJourney>
+RAPTOR::profile(const map_stop_point_duration& departures,
+                const map_stop_point_duration& destinations,
+                const DateTime& begin_dt,
+                const DateTime& end_dt,
+                const nt::RTLevel rt_level,
+                const uint32_t max_transfers,
+                const type::AccessibiliteParams& accessibilite_params,
+                const std::vector<std::string>& forbidden,
+                const std::vector<std::string>& allowed) {
+    const DateTime bound = limit_bound(true, end_dt, DateTimeUtils::inf);
+    set_valid_jp_and_jpp(DateTimeUtils::date(begin_dt),
+                         accessibilite_params,
+                         forbidden,
+                         allowed,
+                         rt_level);
+    assert(data.dataRaptor->cached_next_st_manager);
+    next_st = data.dataRaptor->cached_next_st_manager->load(begin_dt, rt_level, accessibilite_params);
+
+    // the labels are only cleared once, every run improves the labels of the later departures
+    clear(true, bound);
+
+    auto solutions = ParetoFront<ProfileJourney, ProfileDominates>(ProfileDominates());
+    std::vector<DateTime> best_arrival_by_round;
+    for (const DateTime departure_dt: get_profile_departures(*this, departures, begin_dt, end_dt,
+                                                             accessibilite_params.properties)) {
+        // the best labels are only valid for a given departure, a label of a
+        // later departure with more transfers must not prune this run
+        boost::fill(best_labels_pts.values(), bound);
+        boost::fill(best_labels_transfers.values(), bound);
+        clear_marked_jps();
+        init(departures, departure_dt, true, accessibilite_params.properties);
+        boucleRAPTOR(true, rt_level, max_transfers);
+
+        best_arrival_by_round.resize(labels.size(), DateTimeUtils::inf);
+        for (unsigned round = 1; round <= count && round < labels.size(); ++round) {
+            DateTime arrival_dt = DateTimeUtils::inf;
+            for (const auto& sp_dt: destinations) {
+                if (! labels[round].pt_is_initialized(sp_dt.first)) { continue; }
+                if (! get_sp(sp_dt.first)->accessible(accessibilite_params.properties)) { continue; }
+                arrival_dt = std::min(arrival_dt,
+                                      DateTime(labels[round].dt_pt(sp_dt.first) + sp_dt.second.total_seconds()));
+            }
+            if (arrival_dt >= best_arrival_by_round[round]) { continue; }
+            best_arrival_by_round[round] = arrival_dt;
+            solutions.add({departure_dt, arrival_dt, round - 1});
+        }
+    }
+
+    std::vector<ProfileJourney> result(solutions.begin(), solutions.end());
+    boost::sort(result, [](const ProfileJourney& lhs, const ProfileJourney& rhs) {
+        return lhs.departure_dt < rhs.departure_dt;
+    });
+    return result;
+}
+
 void
 RAPTOR::isochrone(const map_stop_point_duration& departures,
                   const DateTime& departure_datetime,
@@ -670,6 +813,135 @@ void RAPTOR::set_valid_jp_and_jpp(
     jpps_from_sp.filter_jpps(valid_journey_pattern_points);
 }
 
+template<typename Visitor, typename Updater>
+bool RAPTOR::scan_jp(const Visitor& visitor,
+                     const nt::RTLevel rt_level,
+                     const JpIdx jp_idx,
+                     const int order,
+                     const Labels& prec_labels,
+                     Updater& update) const {
+    bool result = false;
+    bool is_onboard = false;
+    DateTime workingDt = visitor.worst_datetime();
+    DateTime base_dt = workingDt;
+    // once on board, we walk the stop times of the vj in dataRAPTOR::stop_times
+    const auto& stop_times = data.dataRaptor->stop_times;
+    const bool clockwise = visitor.clockwise();
+    uint32_t st_idx = 0;
+    const type::VehicleJourney* onboard_vj = nullptr;
+    uint16_t l_zone = std::numeric_limits<uint16_t>::max();
+    const auto& jpps_to_explore = visitor.jpps_from_order(data.dataRaptor->jpps_from_jp,
+                                                          jp_idx,
+                                                          order);
+    for (const auto& jpp: jpps_to_explore) {
+        if (is_onboard) {
+            if (clockwise) { ++st_idx; } else { --st_idx; }
+            // We update workingDt with the new arrival time
+            // We need at each journey pattern point when we have a st
+            // If we don't it might cause problem with overmidnight vj
+            workingDt = stop_times.section_end(st_idx, base_dt, clockwise);
+            // We check if there are no drop_off_only and if the local_zone is okay
+            if (stop_times.valid_end(st_idx, clockwise)
+                && (l_zone == std::numeric_limits<uint16_t>::max() ||
+                    l_zone != stop_times.local_traffic_zone(st_idx))
+                && valid_stop_points[jpp.sp_idx.val] // we need to check the accessibility
+                && update(visitor, jpp.sp_idx, workingDt))
+            {
+                result = true;
+            }
+        }
+
+        // We try to get on a vehicle, if we were already on a vehicle, but we arrived
+        // before on the previous via a connection, we try to catch a vehicle leaving this
+        // journey pattern point before
+        const DateTime previous_dt = prec_labels.dt_transfer(jpp.sp_idx);
+        if (prec_labels.transfer_is_initialized(jpp.sp_idx) && valid_stop_points[jpp.sp_idx.val] &&
+            (!is_onboard || visitor.be(previous_dt, stop_times.section_end(st_idx, base_dt, clockwise)))) {
+            const auto tmp_st_dt = next_st->next_stop_time(
+                visitor.stop_event(), jpp.idx, previous_dt, clockwise);
+            if (tmp_st_dt.first != nullptr) {
+                const auto tmp_st_idx = stop_times.st_idx(*tmp_st_dt.first);
+                if (! is_onboard || st_idx != tmp_st_idx) {
+                    st_idx = tmp_st_idx;
+                    onboard_vj = tmp_st_dt.first->vehicle_journey;
+                    is_onboard = true;
+                    l_zone = stop_times.local_traffic_zone(st_idx);
+                    // note that if we have found a better
+                    // pickup, and that this pickup does
+                    // not have the same local traffic
+                    // zone, we may miss some interesting
+                    // solutions.
+                } else if (l_zone != stop_times.local_traffic_zone(st_idx)) {
+                    // if we can pick up in this vj with 2
+                    // different zones, we can drop off
+                    // anywhere (we'll chose later at
+                    // which stop we pickup)
+                    l_zone = std::numeric_limits<uint16_t>::max();
+                }
+                workingDt = tmp_st_dt.second;
+                base_dt = tmp_st_dt.first->base_dt(workingDt, clockwise);
+                BOOST_ASSERT(! visitor.comp(workingDt, previous_dt));
+            }
+        }
+    }
+    if (is_onboard) {
+        const type::VehicleJourney* vj_stay_in = visitor.get_extension_vj(onboard_vj);
+        if (vj_stay_in) {
+            bool applied = apply_vj_extension(visitor, rt_level, vj_stay_in, l_zone, base_dt, update);
+            result = result || applied;
+        }
+    }
+    return result;
+}
+
+template<typename Visitor>
+bool RAPTOR::scan_jps_in_parallel(const Visitor& visitor,
+                                  const nt::RTLevel rt_level,
+                                  const std::vector<std::pair<JpIdx, int>>& marked_jps,
+                                  const size_t nb_threads) {
+    const auto& prec_labels = labels[count - 1];
+    auto& working_labels = labels[count];
+
+    // the jps are split in contiguous chunks, the jps of a route being contiguous
+    std::vector<StoreImprovements> stores(nb_threads, StoreImprovements{working_labels, best_labels_pts, {}});
+    std::vector<std::exception_ptr> errors(nb_threads);
+    auto scan_chunk = [&](const size_t thread_idx) {
+        try {
+            const size_t begin = marked_jps.size() * thread_idx / nb_threads;
+            const size_t end = marked_jps.size() * (thread_idx + 1) / nb_threads;
+            for (size_t i = begin; i < end; ++i) {
+                scan_jp(visitor, rt_level, marked_jps[i].first, marked_jps[i].second,
+                        prec_labels, stores[thread_idx]);
+            }
+        } catch (...) {
+            errors[thread_idx] = std::current_exception();
+        }
+    };
+    std::vector<std::thread> threads;
+    for (size_t thread_idx = 1; thread_idx < nb_threads; ++thread_idx) {
+        threads.emplace_back(scan_chunk, thread_idx);
+    }
+    scan_chunk(0);
+    for (auto& thread: threads) {
+        thread.join();
+    }
+    for (const auto& error: errors) {
+        if (error) { std::rethrow_exception(error); }
+    }
+
+    // merge of the improvements found by each thread, we keep the best one of each stop point
+    bool result = false;
+    UpdateLabels update{working_labels, best_labels_pts};
+    for (const auto& store: stores) {
+        for (const auto& improvement: store.improvements) {
+            if (update(visitor, improvement.first, improvement.second)) {
+                result = true;
+            }
+        }
+    }
+    return result;
+}
+
 template<typename Visitor>
 void RAPTOR::raptor_loop(Visitor visitor,
                          const nt::RTLevel rt_level,
@@ -689,85 +961,39 @@ void RAPTOR::raptor_loop(Visitor visitor,
         }
         const auto& prec_labels = labels[count -1];
         auto& working_labels = labels[this->count];
-        /*
-         * We need to store it so we can apply stay_in after applying normal vjs
-         * We want to do it, to favoritize normal vj against stay_in vjs
-         */
-        for (auto q_elt: Q) {
-            const JpIdx jp_idx = q_elt.first;
-            if(q_elt.second != visitor.init_queue_item()) {
-                bool is_onboard = false;
-                DateTime workingDt = visitor.worst_datetime();
-                DateTime base_dt = workingDt;
-                typename Visitor::stop_time_iterator it_st;
-                uint16_t l_zone = std::numeric_limits<uint16_t>::max();
-                const auto& jpps_to_explore = visitor.jpps_from_order(data.dataRaptor->jpps_from_jp,
-                                                                      jp_idx,
-                                                                      q_elt.second);
-                for (const auto& jpp: jpps_to_explore) {
-                    if (is_onboard) {
-                        ++it_st;
-                        // We update workingDt with the new arrival time
-                        // We need at each journey pattern point when we have a st
-                        // If we don't it might cause problem with overmidnight vj
-                        const type::StopTime& st = *it_st;
-                        workingDt = st.section_end(base_dt, visitor.clockwise());
-                        // We check if there are no drop_off_only and if the local_zone is okay
-                        if (st.valid_end(visitor.clockwise())
-                            && (l_zone == std::numeric_limits<uint16_t>::max() ||
-                                l_zone != st.local_traffic_zone)
-                            && visitor.comp(workingDt, best_labels_pts[jpp.sp_idx])
-                            && valid_stop_points[jpp.sp_idx.val]) // we need to check the accessibility
-                        {
-                            working_labels.mut_dt_pt(jpp.sp_idx) = workingDt;
-                            best_labels_pts[jpp.sp_idx] = working_labels.dt_pt(jpp.sp_idx);
-                            continue_algorithm = true;
-                        }
-                    }
 
-                    // We try to get on a vehicle, if we were already on a vehicle, but we arrived
-                    // before on the previous via a connection, we try to catch a vehicle leaving this
-                    // journey pattern point before
-                    const DateTime previous_dt = prec_labels.dt_transfer(jpp.sp_idx);
-                    if (prec_labels.transfer_is_initialized(jpp.sp_idx) && valid_stop_points[jpp.sp_idx.val] &&
-                        (!is_onboard || visitor.better_or_equal(previous_dt, base_dt, *it_st))) {
-                        const auto tmp_st_dt = next_st->next_stop_time(
-                            visitor.stop_event(), jpp.idx, previous_dt, visitor.clockwise());
-                        if (tmp_st_dt.first != nullptr) {
-                            if (! is_onboard || &*it_st != tmp_st_dt.first) {
-                                // st_range is quite cache
-                                // unfriendly, so avoid using it if
-                                // not really needed.
-                                it_st = visitor.st_range(*tmp_st_dt.first).begin();
-                                is_onboard = true;
-                                l_zone = it_st->local_traffic_zone;
-                                // note that if we have found a better
-                                // pickup, and that this pickup does
-                                // not have the same local traffic
-                                // zone, we may miss some interesting
-                                // solutions.
-                            } else if (l_zone != it_st->local_traffic_zone) {
-                                // if we can pick up in this vj with 2
-                                // different zones, we can drop off
-                                // anywhere (we'll chose later at
-                                // which stop we pickup)
-                                l_zone = std::numeric_limits<uint16_t>::max();
-                            }
-                            workingDt = tmp_st_dt.second;
-                            base_dt = tmp_st_dt.first->base_dt(workingDt, visitor.clockwise());
-                            BOOST_ASSERT(! visitor.comp(workingDt, previous_dt));
-                        }
-                    }
-                }
-                if (is_onboard) {
-                    const type::VehicleJourney* vj_stay_in = visitor.get_extension_vj(it_st->vehicle_journey);
-                    if (vj_stay_in) {
-                        bool applied = apply_vj_extension(visitor, rt_level, vj_stay_in, l_zone, base_dt);
-                        continue_algorithm = continue_algorithm || applied;
-                    }
+        // we only scan the journey patterns marked since the last
+        // round, sorted for the locality of the accesses
+        std::vector<std::pair<JpIdx, int>> round_jps;
+        round_jps.reserve(marked_jps.size());
+        if (scan_whole_queue) {
+            const int init_queue_item = visitor.clockwise() ? std::numeric_limits<int>::max() : -1;
+            for (auto q_elt: Q) {
+                if (is_marked_jp[q_elt.first.val]) {
+                    round_jps.emplace_back(q_elt.first, q_elt.second);
                 }
+                q_elt.second = init_queue_item;
+            }
+        } else {
+            boost::sort(marked_jps);
+            for (const auto jp_idx: marked_jps) {
+                round_jps.emplace_back(jp_idx, Q[jp_idx]);
+            }
+        }
+        clear_marked_jps();
+
+        // a thread is only worth it if it has enough journey patterns to scan
+        const size_t nb_threads = std::min(nb_round_threads,
+                                           std::max<size_t>(1, round_jps.size() / min_jps_by_round_thread));
+        if (nb_threads > 1) {
+            continue_algorithm = scan_jps_in_parallel(visitor, rt_level, round_jps, nb_threads);
+        } else {
+            UpdateLabels update{working_labels, best_labels_pts};
+            for (const auto& jp_order: round_jps) {
+                const bool improved = scan_jp(visitor, rt_level, jp_order.first, jp_order.second,
+                                              prec_labels, update);
+                continue_algorithm = continue_algorithm || improved;
             }
-            q_elt.second = visitor.init_queue_item();
         }
         continue_algorithm = continue_algorithm && this->foot_path(visitor);
     }
@@ -55,6 +55,13 @@ struct StartingPointSndPhase {
     bool has_priority;
 };
 
+/// A journey found by a profile query, only described by its criteria
+struct ProfileJourney {
+    DateTime departure_dt;
+    DateTime arrival_dt;
+    unsigned nb_transfers;
+};
+
 /** Worker Raptor : une instance par thread, les données sont modifiées par le calcul */
 struct RAPTOR
 {
@@ -75,12 +82,24 @@ struct RAPTOR
     /// Are the journey pattern valid
     boost::dynamic_bitset<> valid_journey_patterns;
     dataRAPTOR::JppsFromSp jpps_from_sp;
-    /// Order of the first journey_pattern point of each journey_pattern
+    /// Order of the first journey_pattern point of each marked journey_pattern
     IdxMap<JourneyPattern, int> Q;
+    /// The journey patterns marked since the last round, only them are scanned
+    boost::dynamic_bitset<> is_marked_jp;
+    std::vector<JpIdx> marked_jps;
 
     // set to store if the stop_point is valid
     boost::dynamic_bitset<> valid_stop_points;
 
+    /// Number of threads scanning the journey patterns of a round.
+    /// Worth it only for big computations (isochrones, heat maps) on big coverages
+    size_t nb_round_threads = 1;
+    /// Minimal number of marked journey patterns for a thread to be used
+    size_t min_jps_by_round_thread = 256;
+    /// Scan the whole queue of journey patterns at each round, as done before the
+    /// list of the marked journey patterns. Only to compare them, see benchmark_raptor_loop
+    bool scan_whole_queue = false;
+
     explicit RAPTOR(const navitia::type::Data& data) :
         data(data),
         best_labels_pts(data.pt_data->stop_points),
@@ -88,6 +107,7 @@ struct RAPTOR
         count(0),
         valid_journey_patterns(data.dataRaptor->jp_container.nb_jps()),
         Q(data.dataRaptor->jp_container.get_jps_values()),
+        is_marked_jp(data.dataRaptor->jp_container.nb_jps()),
         valid_stop_points(data.pt_data->stop_points.size())
     {
         labels.assign(10, data.dataRaptor->labels_const);
@@ -96,6 +116,19 @@ struct RAPTOR
 
     void clear(bool clockwise, DateTime bound);
 
+    /// Mark the journey pattern to be scanned from order at the next round
+    inline void mark_jp(const JpIdx jp_idx, const int order, const bool clockwise) {
+        if (! is_marked_jp[jp_idx.val]) {
+            is_marked_jp[jp_idx.val] = true;
+            marked_jps.push_back(jp_idx);
+            Q[jp_idx] = order;
+        } else if (clockwise ? order < Q[jp_idx] : order > Q[jp_idx]) {
+            Q[jp_idx] = order;
+        }
+    }
+    /// Unmark all the journey patterns
+    void clear_marked_jps();
+
     ///Initialize starting points
     void init(const map_stop_point_duration& dep,
               const DateTime bound,
@@ -143,6 +176,26 @@ struct RAPTOR
                 const size_t max_extra_second_pass = 0);
 
 
+    /** Profile query: all the journeys leaving the departures between begin_dt and end_dt
+     *
+     * The departures of the vehicles at the departure stop points during the window are
+     * scanned from the latest to the earliest, each run reusing the labels of the
+     * previous one (rRAPTOR): a run only improves what the later departures have found.
+     * Returns the Pareto set on (departure, arrival, number of transfers), sorted by
+     * departure. The durations of departures and destinations are the fallback durations.
+     * Only clockwise profiles are supported.
+     */
+    std::vector<ProfileJourney>
+    profile(const map_stop_point_duration& departures,
+            const map_stop_point_duration& destinations,
+            const DateTime& begin_dt,
+            const DateTime& end_dt,
+            const nt::RTLevel rt_level,
+            const uint32_t max_transfers = 10,
+            const type::AccessibiliteParams& accessibilite_params = type::AccessibiliteParams(),
+            const std::vector<std::string>& forbidden = std::vector<std::string>(),
+            const std::vector<std::string>& allowed = std::vector<std::string>());
+
     /** Calcul l'isochrone à partir de tous les points contenus dans departs,
      *  vers tous les autres points.
      *  Renvoie toutes les arrivées vers tous les stop points.
@@ -177,12 +230,31 @@ struct RAPTOR
     template<typename Visitor> bool foot_path(const Visitor& v);
 
     /// Returns true if we improve at least one label, false otherwise
-    template<typename Visitor>
+    template<typename Visitor, typename Updater>
     bool apply_vj_extension(const Visitor& v,
                             const nt::RTLevel rt_level,
                             const type::VehicleJourney* vj,
                             const uint16_t l_zone,
-                            DateTime workingDate);
+                            DateTime workingDate,
+                            Updater& update) const;
+
+    /// Scan a journey pattern from the given order, the arrivals are given to update
+    /// Returns true if we improve at least one label, false otherwise
+    template<typename Visitor, typename Updater>
+    bool scan_jp(const Visitor& visitor,
+                 const nt::RTLevel rt_level,
+                 const JpIdx jp_idx,
+                 const int order,
+                 const Labels& prec_labels,
+                 Updater& update) const;
+
+    /// Scan the marked journey patterns of the round with nb_threads threads
+    /// Returns true if we improve at least one label, false otherwise
+    template<typename Visitor>
+    bool scan_jps_in_parallel(const Visitor& visitor,
+                              const nt::RTLevel rt_level,
+                              const std::vector<std::pair<JpIdx, int>>& marked_jps,
+                              const size_t nb_threads);
 
     ///Main loop
     template<typename Visitor>
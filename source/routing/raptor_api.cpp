@@ -40,9 +40,12 @@ www.navitia.io
 
 #include <boost/date_time/posix_time/posix_time.hpp>
 #include <boost/range/algorithm/count.hpp>
+#include <boost/range/algorithm_ext/push_back.hpp>
 #include <unordered_set>
 #include <chrono>
+#include <exception>
 #include <string>
+#include <thread>
 
 
 namespace navitia { namespace routing {
@@ -826,8 +829,8 @@ get_stop_points( const type::EntryPoint &ep, const type::Data& data,
         //we need to check if the admin has zone odt
         const auto& admins = find_admins(ep, data);
         for (const auto* admin: admins) {
-            for (const auto* odt_admin_stop_point: admin->odt_stop_points) {
-                const SpIdx sp_idx{*odt_admin_stop_point};
+            for (const auto odt_admin_stop_point_idx: admin->odt_stop_points) {
+                const SpIdx sp_idx{odt_admin_stop_point_idx};
                 if (result.find(sp_idx) == result.end()) {
                     concerned_path_finder.distance_to_entry_point[sp_idx] = {};
                     result[sp_idx] = {};
@@ -876,8 +879,8 @@ get_stop_points( const type::EntryPoint &ep, const type::Data& data,
         }
 
         if (! admin->main_stop_areas.empty()) {
-            for (auto stop_area: admin->main_stop_areas) {
-                for(auto sp : stop_area->stop_point_list) {
+            for (auto stop_area_idx: admin->main_stop_areas) {
+                for(auto sp : data.pt_data->stop_areas[stop_area_idx]->stop_point_list) {
                     const SpIdx sp_idx{*sp};
                     if (result.find(sp_idx) == result.end()) {
                         result[sp_idx] = {};
@@ -1003,6 +1006,51 @@ void make_pt_response(navitia::PbCreator& pb_creator,
     make_pt_pathes(pb_creator, pathes);
 }
 
+/*
+ * Compute each datetime on one of the planners, each planner being used by only one thread.
+ *
+ * The datetimes are distributed round robin on the planners, the first one
+ * being used by the calling thread.
+ */
+template<typename F>
+static std::vector<std::vector<Path>>
+compute_in_parallel(const std::vector<RAPTOR*>& planners,
+                    const std::vector<bt::ptime>& datetimes,
+                    const F& compute) {
+    std::vector<std::vector<Path>> results(datetimes.size());
+    std::vector<std::exception_ptr> errors(planners.size());
+    auto run = [&](size_t planner_idx) {
+        try {
+            for (size_t i = planner_idx; i < datetimes.size(); i += planners.size()) {
+                results[i] = compute(*planners[planner_idx], datetimes[i]);
+            }
+        } catch (...) {
+            errors[planner_idx] = std::current_exception();
+        }
+    };
+    std::vector<std::thread> threads;
+    for (size_t planner_idx = 1; planner_idx < planners.size() && planner_idx < datetimes.size(); ++planner_idx) {
+        threads.emplace_back(run, planner_idx);
+    }
+    run(0);
+    for (auto& thread: threads) {
+        thread.join();
+    }
+    for (const auto& error: errors) {
+        if (error) { std::rethrow_exception(error); }
+    }
+    return results;
+}
+
+// same strict comparison as the raptor labels with the bound
+static bool is_within_bound(const Path& path, const DateTime bound, const bool clockwise, const type::Data& data) {
+    if (path.items.empty()) { return false; }
+    if (clockwise) {
+        return to_datetime(path.items.back().arrival, data) < bound;
+    }
+    return to_datetime(path.items.front().departure, data) > bound;
+}
+
 void make_response(navitia::PbCreator& pb_creator,
                    RAPTOR &raptor,
                    const type::EntryPoint& origin,
@@ -1017,7 +1065,8 @@ void make_response(navitia::PbCreator& pb_creator,
                    const navitia::time_duration& transfer_penalty,
                    uint32_t max_duration,
                    uint32_t max_transfers,
-                   uint32_t max_extra_second_pass) {
+                   uint32_t max_extra_second_pass,
+                   const std::vector<RAPTOR*>& datetime_planners) {
 
     log4cplus::Logger logger = log4cplus::Logger::getInstance(LOG4CPLUS_TEXT("logger"));
     std::vector<Path> pathes;
@@ -1075,44 +1124,76 @@ void make_response(navitia::PbCreator& pb_creator,
 
 
 
-    DateTime bound = clockwise ? DateTimeUtils::inf : DateTimeUtils::min;
     typedef boost::optional<navitia::time_duration> OptTimeDur;
     const OptTimeDur direct_path_dur = direct_path.path_items.empty() ?
         OptTimeDur() :
         OptTimeDur(direct_path.duration / origin.streetnetwork_params.speed_factor);
+    const bool has_max_duration = max_duration != std::numeric_limits<uint32_t>::max();
 
-    for(bt::ptime datetime : datetimes) {
-        int day = (datetime.date() - raptor.data.meta->production_date.begin()).days();
+    auto compute = [&](RAPTOR& planner, const bt::ptime& datetime, DateTime bound) {
+        int day = (datetime.date() - planner.data.meta->production_date.begin()).days();
         int time = datetime.time_of_day().total_seconds();
         DateTime init_dt = DateTimeUtils::set(day, time);
 
-        if(max_duration != std::numeric_limits<uint32_t>::max()) {
+        if (has_max_duration) {
             if (clockwise) {
                 bound = init_dt + max_duration;
             } else {
                 bound = init_dt > max_duration ? init_dt - max_duration : 0;
             }
         }
-        std::vector<Path> tmp = raptor.compute_all(
+        std::vector<Path> res = planner.compute_all(
             *departures, *destinations, init_dt, rt_level, transfer_penalty, bound, max_transfers,
             accessibilite_params, forbidden, allowed, clockwise, direct_path_dur,
             max_extra_second_pass);
-        LOG4CPLUS_DEBUG(logger, "raptor found " << tmp.size() << " solutions");
-
+        LOG4CPLUS_DEBUG(logger, "raptor found " << res.size() << " solutions");
+        return res;
+    };
 
-        // Lorsqu'on demande qu'un seul horaire, on garde tous les résultas
-        if(datetimes.size() == 1) {
-            pathes = tmp;
-            for(auto & path : pathes) {
-                path.request_time = datetime;
+    DateTime bound = clockwise ? DateTimeUtils::inf : DateTimeUtils::min;
+    if (datetimes.size() > 1 && ! datetime_planners.empty()) {
+        // the datetimes are computed independently, without the bound given by the
+        // previous datetime, and the bound is applied afterward on the results
+        std::vector<RAPTOR*> planners = {&raptor};
+        boost::push_back(planners, datetime_planners);
+        const auto results = compute_in_parallel(planners, datetimes,
+                                                 [&](RAPTOR& planner, const bt::ptime& datetime) {
+            return compute(planner, datetime, bound);
+        });
+        for (size_t i = 0; i < datetimes.size(); ++i) {
+            // we keep the earliest arrival / latest departure still better than the bound
+            auto it = results[i].rbegin();
+            if (! has_max_duration) {
+                it = std::find_if(results[i].rbegin(), results[i].rend(), [&](const Path& path) {
+                    return is_within_bound(path, bound, clockwise, raptor.data);
+                });
             }
-        } else if(!tmp.empty()) {
-            // Lorsqu'on demande plusieurs horaires, on garde que l'arrivée au plus tôt / départ au plus tard
-            tmp.back().request_time = datetime;
-            pathes.push_back(tmp.back());
-            bound = to_datetime(tmp.back().items.back().arrival, raptor.data);
-        } else // Lorsqu'on demande plusieurs horaires, et qu'il n'y a pas de résultat, on retourne un itinéraire vide
-            pathes.push_back(Path());
+            if (it == results[i].rend()) {
+                pathes.push_back(Path());
+                continue;
+            }
+            pathes.push_back(*it);
+            pathes.back().request_time = datetimes[i];
+            bound = to_datetime(it->items.back().arrival, raptor.data);
+        }
+    } else {
+        for(bt::ptime datetime : datetimes) {
+            std::vector<Path> tmp = compute(raptor, datetime, bound);
+
+            // Lorsqu'on demande qu'un seul horaire, on garde tous les résultas
+            if(datetimes.size() == 1) {
+                pathes = tmp;
+                for(auto & path : pathes) {
+                    path.request_time = datetime;
+                }
+            } else if(!tmp.empty()) {
+                // Lorsqu'on demande plusieurs horaires, on garde que l'arrivée au plus tôt / départ au plus tard
+                tmp.back().request_time = datetime;
+                pathes.push_back(tmp.back());
+                bound = to_datetime(tmp.back().items.back().arrival, raptor.data);
+            } else // Lorsqu'on demande plusieurs horaires, et qu'il n'y a pas de résultat, on retourne un itinéraire vide
+                pathes.push_back(Path());
+        }
     }
     if(clockwise)
         std::reverse(pathes.begin(), pathes.end());
@@ -61,6 +61,14 @@ void add_direct_path(PbCreator& pb_creator,
                      const std::vector<bt::ptime>& datetimes,
                      const bool clockwise);
 
+/**
+ * Compute the journeys between origin and destination for each datetime
+ *
+ * If datetime_planners is not empty and there are several datetimes, the datetimes
+ * are computed in parallel, one thread per planner (raptor included). The bound of a
+ * datetime does not depend anymore on the result of the previous one during the
+ * computation, it is applied on the results afterward.
+ */
 void make_response(navitia::PbCreator& pb_creator,
                    RAPTOR &raptor,
                    const type::EntryPoint &origin,
@@ -75,7 +83,8 @@ void make_response(navitia::PbCreator& pb_creator,
                    const navitia::time_duration& transfer_penalty,
                    uint32_t max_duration=std::numeric_limits<uint32_t>::max(),
                    uint32_t max_transfers=std::numeric_limits<uint32_t>::max(),
-                   uint32_t max_extra_second_pass = 0);
+                   uint32_t max_extra_second_pass = 0,
+                   const std::vector<RAPTOR*>& datetime_planners = {});
 
 void make_isochrone(navitia::PbCreator& pb_creator,
                     RAPTOR &raptor,
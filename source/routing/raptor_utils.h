@@ -31,6 +31,7 @@ www.navitia.io
 #pragma once
 
 #include <boost/container/flat_map.hpp>
+#include <boost/dynamic_bitset.hpp>
 #include "type/datetime.h"
 #include "utils/idx_map.h"
 
@@ -67,6 +68,9 @@ struct Labels {
     inline friend void swap(Labels& lhs, Labels& rhs) {
         swap(lhs.dt_pts, rhs.dt_pts);
         swap(lhs.dt_transfers, rhs.dt_transfers);
+        swap(lhs.touched, rhs.touched);
+        swap(lhs.is_touched, rhs.is_touched);
+        std::swap(lhs.cleaned_with, rhs.cleaned_with);
     }
     // initialize the structure according to the number of jpp
     inline void init_inf(const std::vector<type::StopPoint*>& stops) {
@@ -77,10 +81,28 @@ struct Labels {
         init(stops, DateTimeUtils::min);
     }
     // clear the structure according to a given structure. Same as a
-    // copy without touching the boarding_jpp fields
+    // copy without touching the boarding_jpp fields. If the structure
+    // was already cleaned with clean, only the stop points written
+    // since are reset, making the cost proportional to the explored
+    // area rather than to the number of stop points.
     inline void clear(const Labels& clean) {
-        dt_pts = clean.dt_pts;
-        dt_transfers = clean.dt_transfers;
+        if (cleaned_with == &clean && is_touched.size() == clean.is_touched.size()) {
+            for (const auto sp_idx: touched) {
+                dt_pts[sp_idx] = clean.dt_pts[sp_idx];
+                dt_transfers[sp_idx] = clean.dt_transfers[sp_idx];
+                is_touched[sp_idx.val] = false;
+            }
+        } else {
+            dt_pts = clean.dt_pts;
+            dt_transfers = clean.dt_transfers;
+            is_touched = clean.is_touched;
+        }
+        touched.clear();
+        cleaned_with = &clean;
+    }
+    // true if the structure was last cleaned with clean
+    inline bool is_cleaned_with(const Labels& clean) const {
+        return cleaned_with == &clean;
     }
     inline const DateTime& dt_transfer(SpIdx sp_idx) const {
         return dt_transfers[sp_idx];
@@ -89,9 +111,11 @@ struct Labels {
         return dt_pts[sp_idx];
     }
     inline DateTime& mut_dt_transfer(SpIdx sp_idx) {
+        touch(sp_idx);
         return dt_transfers[sp_idx];
     }
     inline DateTime& mut_dt_pt(SpIdx sp_idx) {
+        touch(sp_idx);
         return dt_pts[sp_idx];
     }
 
@@ -105,6 +129,15 @@ private:
     inline void init(const std::vector<type::StopPoint*>& stops, DateTime val) {
         dt_pts.assign(stops, val);
         dt_transfers.assign(stops, val);
+        touched.clear();
+        is_touched.clear();
+        is_touched.resize(stops.size());
+        cleaned_with = nullptr;
+    }
+    inline void touch(SpIdx sp_idx) {
+        if (is_touched[sp_idx.val]) { return; }
+        is_touched[sp_idx.val] = true;
+        touched.push_back(sp_idx);
     }
 
     // All these vectors are indexed by sp_idx
@@ -113,6 +146,13 @@ private:
     IdxMap<type::StopPoint, DateTime> dt_pts;
     // At what time wan we reach this label with a transfer
     IdxMap<type::StopPoint, DateTime> dt_transfers;
+
+    // The stop points written since the last clear
+    std::vector<SpIdx> touched;
+    boost::dynamic_bitset<> is_touched;
+    // The labels used by the last clear, the untouched stop points
+    // having their values
+    const Labels* cleaned_with = nullptr;
 };
 
 } // namespace routing
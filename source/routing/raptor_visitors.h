@@ -56,7 +56,6 @@ struct raptor_visitor {
 
     bool clockwise() const{return true;}
     StopEvent stop_event() const{return StopEvent::pick_up;}
-    int init_queue_item() const{return std::numeric_limits<int>::max();}
     DateTime worst_datetime() const{return DateTimeUtils::inf;}
 };
 
@@ -116,7 +115,6 @@ struct raptor_reverse_visitor {
 
     bool clockwise() const{return false;}
     StopEvent stop_event() const{return StopEvent::drop_off;}
-    int init_queue_item() const{return -1;}
     DateTime worst_datetime() const{return DateTimeUtils::min;}
 };
 
@@ -82,6 +82,15 @@ BOOST_AUTO_TEST_CASE(ok_before_and_after_disruption) {
 
     // a clone and set
     auto data_cloned = data_manager.get_data_clone();
+    // the street network and the fares are shared, the pt_data is not
+    BOOST_CHECK_EQUAL(data_cloned->geo_ref, data_manager.get_data()->geo_ref);
+    BOOST_CHECK_EQUAL(data_cloned->fare, data_manager.get_data()->fare);
+    BOOST_CHECK_NE(data_cloned->pt_data.get(), data_manager.get_data()->pt_data.get());
+    for (const auto* sp: data_cloned->pt_data->stop_points) {
+        for (const auto* admin: sp->admin_list) {
+            BOOST_CHECK_EQUAL(admin, data_cloned->geo_ref->admins[admin->idx]);
+        }
+    }
     data_cloned->build_raptor();
     data_manager.set_data(data_cloned);
 
@@ -391,6 +391,102 @@ BOOST_AUTO_TEST_CASE(base) {
     }
 }
 
+/*
+ * 20 vjs leaving stop1 every minute from 8000, only the 11th and the
+ * 17th are wheelchair accessible: the packed search has to skip the
+ * inaccessible candidates, across several blocks.
+ */
+BOOST_AUTO_TEST_CASE(accessible_earliest_stop_time) {
+    ed::builder b("20120614");
+    const auto dep = [](int i) { return DateTime(8000 + i * 60); };
+    for (int i = 0; i < 20; ++i) {
+        b.vj("A", "11111111", "", i == 11 || i == 17)("stop1", dep(i))("stop2", dep(i) + 100);
+    }
+    b.finish();
+    b.data->pt_data->index();
+    b.data->build_uri();
+    b.data->build_raptor();
+    NextStopTime next_st(*b.data);
+    const auto jpp1 = get_first_jpp_idx(b, "stop1");
+    nt::VehicleProperties wheelchair;
+    wheelchair.set(type::hasVehicleProperties::WHEELCHAIR_ACCESSIBLE);
+    const type::StopTime* st;
+    DateTime dt;
+
+    std::tie(st, dt) = next_st.earliest_stop_time(StopEvent::pick_up, jpp1, DateTimeUtils::set(1, dep(5) + 1),
+                                                  nt::RTLevel::Base, nt::VehicleProperties());
+    BOOST_REQUIRE(st != nullptr);
+    BOOST_CHECK_EQUAL(dt, DateTimeUtils::set(1, dep(6)));
+
+    std::tie(st, dt) = next_st.earliest_stop_time(StopEvent::pick_up, jpp1, DateTimeUtils::set(1, dep(0)),
+                                                  nt::RTLevel::Base, wheelchair);
+    BOOST_REQUIRE(st != nullptr);
+    BOOST_CHECK(st->vehicle_journey->wheelchair_accessible());
+    BOOST_CHECK_EQUAL(dt, DateTimeUtils::set(1, dep(11)));
+
+    std::tie(st, dt) = next_st.earliest_stop_time(StopEvent::pick_up, jpp1, DateTimeUtils::set(1, dep(12)),
+                                                  nt::RTLevel::Base, wheelchair);
+    BOOST_REQUIRE(st != nullptr);
+    BOOST_CHECK_EQUAL(dt, DateTimeUtils::set(1, dep(17)));
+
+    // nothing accessible anymore this day, we take the one of the next day
+    std::tie(st, dt) = next_st.earliest_stop_time(StopEvent::pick_up, jpp1, DateTimeUtils::set(1, dep(18)),
+                                                  nt::RTLevel::Base, wheelchair);
+    BOOST_REQUIRE(st != nullptr);
+    BOOST_CHECK_EQUAL(dt, DateTimeUtils::set(2, dep(11)));
+
+    // the accessible one is after the bound
+    std::tie(st, dt) = next_st.earliest_stop_time(StopEvent::pick_up, jpp1, DateTimeUtils::set(1, dep(12)),
+                                                  nt::RTLevel::Base, wheelchair, true,
+                                                  DateTimeUtils::set(1, dep(16)));
+    BOOST_CHECK(st == nullptr);
+    BOOST_CHECK_EQUAL(dt, DateTimeUtils::inf);
+
+    // the cache only contains the accessible stop times
+    type::AccessibiliteParams accessibilite_params;
+    accessibilite_params.vehicle_properties = wheelchair;
+    CachedNextStopTimeManager manager(*b.data->dataRaptor, 10);
+    const auto cache = manager.load(DateTimeUtils::set(1, 0), nt::RTLevel::Base, accessibilite_params);
+    std::tie(st, dt) = cache->next_stop_time(StopEvent::pick_up, jpp1, DateTimeUtils::set(1, dep(12)), true);
+    BOOST_REQUIRE(st != nullptr);
+    BOOST_CHECK_EQUAL(dt, DateTimeUtils::set(1, dep(17)));
+    std::tie(st, dt) = cache->next_stop_time(StopEvent::pick_up, jpp1, DateTimeUtils::set(1, dep(16)), false);
+    BOOST_REQUIRE(st != nullptr);
+    BOOST_CHECK_EQUAL(dt, DateTimeUtils::set(1, dep(11)));
+}
+
+BOOST_AUTO_TEST_CASE(prewarm_cache) {
+    ed::builder b("20120614");
+    b.vj("A")("stop1", 8000)("stop2", 8100);
+    b.finish();
+    b.data->pt_data->index();
+    b.data->build_uri();
+    b.data->build_raptor();
+    const auto jpp1 = get_first_jpp_idx(b, "stop1");
+
+    CachedNextStopTimeManager manager(*b.data->dataRaptor, 10);
+    manager.prewarm(DateTimeUtils::set(1, 0), 3, {nt::RTLevel::Base}, {type::AccessibiliteParams()}, 2);
+    auto stats = manager.get_stats();
+    BOOST_CHECK_EQUAL(stats.nb_builds, 3);
+    BOOST_CHECK_EQUAL(stats.nb_cache_miss, 3);
+
+    // already built by the prewarm
+    const auto cache = manager.load(DateTimeUtils::set(2, 8000), nt::RTLevel::Base, type::AccessibiliteParams());
+    const auto st_dt = cache->next_stop_time(StopEvent::pick_up, jpp1, DateTimeUtils::set(2, 7000), true);
+    BOOST_REQUIRE(st_dt.first != nullptr);
+    BOOST_CHECK_EQUAL(st_dt.second, DateTimeUtils::set(2, 8000));
+    stats = manager.get_stats();
+    BOOST_CHECK_EQUAL(stats.nb_calls, 4);
+    BOOST_CHECK_EQUAL(stats.nb_cache_miss, 3);
+    BOOST_CHECK_EQUAL(stats.nb_builds, 3);
+
+    // no more caches than the lru can keep are built
+    CachedNextStopTimeManager small_manager(*b.data->dataRaptor, 2);
+    small_manager.prewarm(DateTimeUtils::set(1, 0), 3,
+                          {nt::RTLevel::Base, nt::RTLevel::RealTime}, {type::AccessibiliteParams()}, 1);
+    BOOST_CHECK_EQUAL(small_manager.get_stats().nb_builds, 2);
+}
+
 /**
  * Cas de passe minuit avec changement d'heure entre les deux arrêts
  *
@@ -3674,3 +3674,204 @@ BOOST_AUTO_TEST_CASE(allowed_id_line) {
     BOOST_CHECK_EQUAL(res.at(0).items.front().departure, time_from_string("2015-01-03 09:00:00"));
     BOOST_CHECK_EQUAL(res.at(0).items.back().arrival, time_from_string("2015-01-03 13:00:00"));
 }
+
+// the profile query returns every Pareto optimal journey of the departure window
+BOOST_AUTO_TEST_CASE(profile_query) {
+    ed::builder b("20120614");
+    b.vj("A")("stop1", "08:10"_t)("stop2", "08:20"_t);
+    b.vj("A")("stop1", "09:10"_t)("stop2", "09:20"_t);
+    b.vj("A")("stop1", "10:10"_t)("stop2", "10:20"_t);
+    b.vj("B")("stop1", "09:05"_t)("stop3", "09:07"_t);
+    b.vj("C")("stop3", "09:10"_t)("stop2", "09:14"_t);
+    b.connection("stop3", "stop3", 120);
+    b.finish();
+    b.data->pt_data->index();
+    b.data->build_raptor();
+    RAPTOR raptor(*b.data);
+    const auto& d = *b.data->pt_data;
+
+    map_stop_point_duration departures, destinations;
+    departures[SpIdx(*d.stop_points_map.at("stop1"))] = 0_s;
+    destinations[SpIdx(*d.stop_points_map.at("stop2"))] = 0_s;
+
+    const auto res = raptor.profile(departures, destinations,
+                                    DateTimeUtils::set(0, "08:00"_t), DateTimeUtils::set(0, "09:30"_t),
+                                    type::RTLevel::Base);
+
+    BOOST_REQUIRE_EQUAL(res.size(), 3);
+    BOOST_CHECK_EQUAL(res[0].departure_dt, DateTimeUtils::set(0, "08:10"_t));
+    BOOST_CHECK_EQUAL(res[0].arrival_dt, DateTimeUtils::set(0, "08:20"_t));
+    BOOST_CHECK_EQUAL(res[0].nb_transfers, 0);
+    BOOST_CHECK_EQUAL(res[1].departure_dt, DateTimeUtils::set(0, "09:05"_t));
+    BOOST_CHECK_EQUAL(res[1].arrival_dt, DateTimeUtils::set(0, "09:14"_t));
+    BOOST_CHECK_EQUAL(res[1].nb_transfers, 1);
+    BOOST_CHECK_EQUAL(res[2].departure_dt, DateTimeUtils::set(0, "09:10"_t));
+    BOOST_CHECK_EQUAL(res[2].arrival_dt, DateTimeUtils::set(0, "09:20"_t));
+    BOOST_CHECK_EQUAL(res[2].nb_transfers, 0);
+
+    // each journey is the one found by a classic raptor at its departure
+    for (const auto& j: res) {
+        const auto paths = raptor.compute_all(departures, destinations, j.departure_dt, type::RTLevel::Base, 2_min);
+        BOOST_REQUIRE(! paths.empty());
+        BOOST_CHECK(std::any_of(paths.begin(), paths.end(), [&](const Path& p) {
+            return to_datetime(p.items.back().arrival, *b.data) == j.arrival_dt;
+        }));
+    }
+}
+
+// scanning the journey patterns of a round with several threads gives the same labels
+BOOST_AUTO_TEST_CASE(parallel_rounds) {
+    ed::builder b("20120614");
+    for (int i = 0; i < 20; ++i) {
+        const auto line = "L" + std::to_string(i);
+        const auto stop = "stop_" + std::to_string(i);
+        b.vj(line)("stop1", 8*3600 + i*60)(stop, 8*3600 + i*60 + 300)("hub", 8*3600 + i*60 + 900 - i*30);
+        b.vj("back" + line)("hub", 9*3600 + i*60)(stop + "_back", 9*3600 + i*60 + 600);
+    }
+    b.connection("hub", "hub", 120);
+    b.finish();
+    b.data->pt_data->index();
+    b.data->build_raptor();
+    const auto& d = *b.data->pt_data;
+
+    map_stop_point_duration departures;
+    departures[SpIdx(*d.stop_points_map.at("stop1"))] = 0_s;
+
+    RAPTOR sequential(*b.data);
+    sequential.isochrone(departures, DateTimeUtils::set(0, 7*3600), DateTimeUtils::set(0, 12*3600));
+
+    RAPTOR parallel(*b.data);
+    parallel.nb_round_threads = 4;
+    parallel.min_jps_by_round_thread = 1;
+    parallel.isochrone(departures, DateTimeUtils::set(0, 7*3600), DateTimeUtils::set(0, 12*3600));
+
+    BOOST_REQUIRE_EQUAL(parallel.count, sequential.count);
+    for (const auto* sp: d.stop_points) {
+        const SpIdx sp_idx(*sp);
+        BOOST_CHECK_EQUAL(parallel.best_labels_pts[sp_idx], sequential.best_labels_pts[sp_idx]);
+        BOOST_CHECK_EQUAL(parallel.best_labels_transfers[sp_idx], sequential.best_labels_transfers[sp_idx]);
+        for (unsigned round = 0; round <= sequential.count; ++round) {
+            BOOST_CHECK_EQUAL(parallel.labels[round].dt_pt(sp_idx), sequential.labels[round].dt_pt(sp_idx));
+        }
+    }
+    // the hub is reached by the fastest line
+    BOOST_CHECK_EQUAL(sequential.best_labels_pts[SpIdx(*d.stop_points_map.at("hub"))],
+                      DateTimeUtils::set(0, 8*3600 + 900));
+    BOOST_CHECK(sequential.labels[2].pt_is_initialized(SpIdx(*d.stop_points_map.at("stop_0_back"))));
+}
+
+// a raptor reused for several queries, only resetting the touched labels,
+// gives the same results as a fresh one
+BOOST_AUTO_TEST_CASE(reused_raptor_labels) {
+    ed::builder b("20120614");
+    for (int i = 0; i < 10; ++i) {
+        const auto line = "L" + std::to_string(i);
+        const auto stop = "stop_" + std::to_string(i);
+        b.vj(line)("stop1", 8*3600 + i*60)(stop, 8*3600 + i*60 + 300)("hub", 8*3600 + i*60 + 900 - i*30);
+        b.vj("back" + line)("hub", 9*3600 + i*60)(stop + "_back", 9*3600 + i*60 + 600);
+    }
+    b.connection("hub", "hub", 120);
+    b.finish();
+    b.data->pt_data->index();
+    b.data->build_raptor();
+    const auto& d = *b.data->pt_data;
+
+    RAPTOR reused(*b.data);
+    for (int i = 0; i < 10; ++i) {
+        const bool clockwise = i % 3 != 0;
+        const auto* from = d.stop_areas_map.at(i % 2 ? "stop1" : "stop_" + std::to_string(i));
+        const auto* to = d.stop_areas_map.at("stop_" + std::to_string(9 - i) + "_back");
+        const DateTime dt = DateTimeUtils::set(0, clockwise ? 7*3600 + i*60 : 11*3600 - i*60);
+
+        RAPTOR fresh(*b.data);
+        const auto expected = fresh.compute(from, to, dt, 0, DateTimeUtils::inf, type::RTLevel::Base, 2_min,
+                                            clockwise);
+        const auto res = reused.compute(from, to, dt, 0, DateTimeUtils::inf, type::RTLevel::Base, 2_min,
+                                        clockwise);
+        BOOST_REQUIRE_EQUAL(res.size(), expected.size());
+        for (size_t j = 0; j < res.size(); ++j) {
+            BOOST_CHECK_EQUAL(res[j].items.front().departure, expected[j].items.front().departure);
+            BOOST_CHECK_EQUAL(res[j].items.back().arrival, expected[j].items.back().arrival);
+        }
+    }
+
+    map_stop_point_duration departures;
+    departures[SpIdx(*d.stop_points_map.at("stop_3"))] = 0_s;
+    RAPTOR fresh(*b.data);
+    fresh.isochrone(departures, DateTimeUtils::set(0, 7*3600), DateTimeUtils::set(0, 12*3600));
+    reused.isochrone(departures, DateTimeUtils::set(0, 7*3600), DateTimeUtils::set(0, 12*3600));
+    BOOST_REQUIRE_EQUAL(reused.count, fresh.count);
+    for (const auto* sp: d.stop_points) {
+        const SpIdx sp_idx(*sp);
+        for (unsigned round = 0; round < std::min(reused.labels.size(), fresh.labels.size()); ++round) {
+            BOOST_CHECK_EQUAL(reused.labels[round].dt_pt(sp_idx), fresh.labels[round].dt_pt(sp_idx));
+            BOOST_CHECK_EQUAL(reused.labels[round].dt_transfer(sp_idx), fresh.labels[round].dt_transfer(sp_idx));
+        }
+    }
+}
+
+// only the journey patterns marked since the last round are in the worklist
+BOOST_AUTO_TEST_CASE(marked_jps_worklist) {
+    ed::builder b("20120614");
+    b.vj("A")("stop1", 8000)("stop2", 8100)("stop3", 8200);
+    b.vj("B")("stop3", 9000)("stop2", 9100);
+    b.finish();
+    b.data->pt_data->index();
+    b.data->build_raptor();
+    const auto& d = *b.data->pt_data;
+
+    RAPTOR raptor(*b.data);
+    raptor.clear(true, DateTimeUtils::inf);
+    BOOST_CHECK(raptor.marked_jps.empty());
+
+    const JpIdx jp(0);
+    raptor.mark_jp(jp, 2, true);
+    raptor.mark_jp(jp, 1, true);
+    raptor.mark_jp(jp, 3, true);
+    BOOST_REQUIRE_EQUAL(raptor.marked_jps.size(), 1);
+    BOOST_CHECK_EQUAL(raptor.Q[jp], 1);
+    raptor.mark_jp(jp, 2, false);
+    BOOST_CHECK_EQUAL(raptor.Q[jp], 2);
+
+    raptor.clear(true, DateTimeUtils::inf);
+    BOOST_CHECK(raptor.marked_jps.empty());
+    BOOST_CHECK(raptor.is_marked_jp.none());
+
+    // the worklist is consumed by the rounds
+    map_stop_point_duration departures;
+    departures[SpIdx(*d.stop_points_map.at("stop1"))] = 0_s;
+    raptor.isochrone(departures, DateTimeUtils::set(0, 7000), DateTimeUtils::set(0, 12000));
+    BOOST_CHECK(raptor.labels[1].pt_is_initialized(SpIdx(*d.stop_points_map.at("stop3"))));
+    BOOST_CHECK(raptor.labels[1].pt_is_initialized(SpIdx(*d.stop_points_map.at("stop2"))));
+    const auto count = raptor.count;
+
+    // the scan of the whole queue, kept for benchmark_raptor_loop, does the same rounds
+    raptor.scan_whole_queue = true;
+    raptor.isochrone(departures, DateTimeUtils::set(0, 7000), DateTimeUtils::set(0, 12000));
+    BOOST_CHECK_EQUAL(raptor.count, count);
+    BOOST_CHECK(raptor.labels[1].pt_is_initialized(SpIdx(*d.stop_points_map.at("stop3"))));
+    BOOST_CHECK(raptor.labels[1].pt_is_initialized(SpIdx(*d.stop_points_map.at("stop2"))));
+}
+
+// the stop times used by the raptor scan are the same as the ones of the vjs
+BOOST_AUTO_TEST_CASE(dataraptor_stop_times) {
+    ed::builder b("20120614");
+    b.vj("A")("stop1", 8000, 8050)("stop2", 8100, 8150, 42, true, false)("stop3", 8200, 8250, 42, false, true);
+    b.vj("B")("stop3", 9000, 9050, std::numeric_limits<uint16_t>::max(), true, true, 10, 20)("stop1", 9100, 9150);
+    b.finish();
+    b.data->pt_data->index();
+    b.data->build_raptor();
+
+    const auto& stop_times = b.data->dataRaptor->stop_times;
+    for (const auto* vj: b.data->pt_data->vehicle_journeys) {
+        for (const auto& st: vj->stop_time_list) {
+            const auto st_idx = stop_times.st_idx(st);
+            BOOST_CHECK_EQUAL(st_idx, stop_times.first_st(*vj) + st.order());
+            BOOST_CHECK_EQUAL(stop_times.section_end(st_idx, 42, true), st.section_end(42, true));
+            BOOST_CHECK_EQUAL(stop_times.section_end(st_idx, 42, false), st.section_end(42, false));
+            BOOST_CHECK_EQUAL(stop_times.valid_end(st_idx, true), st.valid_end(true));
+            BOOST_CHECK_EQUAL(stop_times.valid_end(st_idx, false), st.valid_end(false));
+            BOOST_CHECK_EQUAL(stop_times.local_traffic_zone(st_idx), st.local_traffic_zone);
+        }
+    }
+}
@@ -815,6 +815,54 @@ BOOST_AUTO_TEST_CASE(journey_array){
 }
 
 
+// the datetimes computed in parallel must give the same journeys as the sequential computation
+BOOST_AUTO_TEST_CASE(journey_array_in_parallel){
+    ed::builder b("20120614");
+    b.vj("A")("stop_area:stop1", 8*3600 +10*60, 8*3600 + 11 * 60)("stop_area:stop2", 8*3600 + 20 * 60 ,8*3600 + 21*60);
+    b.vj("A")("stop_area:stop1", 9*3600 +10*60, 9*3600 + 11 * 60)("stop_area:stop2",  9*3600 + 20 * 60 ,9*3600 + 21*60);
+    b.vj("A")("stop_area:stop1", 10*3600 +10*60, 10*3600 + 11 * 60)("stop_area:stop2",  10*3600 + 20 * 60 ,10*3600 + 21*60);
+    b.finish();
+    b.generate_dummy_basis();
+    b.data->pt_data->index();
+    b.data->build_raptor();
+    b.data->build_uri();
+    b.data->geo_ref->init();
+    b.data->build_proximity_list();
+    b.data->meta->production_date = boost::gregorian::date_period(boost::gregorian::date(2012,06,14), boost::gregorian::days(7));
+
+    navitia::type::EntryPoint origin(b.data->get_type_of_id("stop_area:stop1"), "stop_area:stop1");
+    navitia::type::EntryPoint destination(b.data->get_type_of_id("stop_area:stop2"), "stop_area:stop2");
+    std::vector<uint64_t> datetimes({ntest::to_posix_timestamp("20120614T080000"),
+                                     ntest::to_posix_timestamp("20120614T080500"),
+                                     ntest::to_posix_timestamp("20120614T090000"),
+                                     ntest::to_posix_timestamp("20120614T100000")});
+    auto * data_ptr = b.data.get();
+
+    auto compute = [&](const std::vector<nr::RAPTOR*>& datetime_planners) {
+        nr::RAPTOR raptor(*b.data);
+        ng::StreetNetwork sn_worker(*b.data->geo_ref);
+        navitia::PbCreator pb_creator(data_ptr, boost::gregorian::not_a_date_time, null_time_period);
+        nr::make_response(pb_creator, raptor, origin, destination, datetimes, true,
+                          navitia::type::AccessibiliteParams(),
+                          {}, {}, sn_worker, nt::RTLevel::Base, 2_min,
+                          std::numeric_limits<uint32_t>::max(), std::numeric_limits<uint32_t>::max(), 0,
+                          datetime_planners);
+        return pb_creator.get_response();
+    };
+    const auto sequential = compute({});
+    nr::RAPTOR planner1(*b.data), planner2(*b.data);
+    const auto parallel = compute({&planner1, &planner2});
+
+    BOOST_REQUIRE_EQUAL(sequential.response_type(), pbnavitia::ITINERARY_FOUND);
+    BOOST_REQUIRE_EQUAL(parallel.response_type(), sequential.response_type());
+    BOOST_REQUIRE_EQUAL(parallel.journeys_size(), sequential.journeys_size());
+    for (int i = 0; i < sequential.journeys_size(); ++i) {
+        BOOST_CHECK_EQUAL(parallel.journeys(i).departure_date_time(), sequential.journeys(i).departure_date_time());
+        BOOST_CHECK_EQUAL(parallel.journeys(i).arrival_date_time(), sequential.journeys(i).arrival_date_time());
+        BOOST_CHECK_EQUAL(parallel.journeys(i).requested_date_time(), sequential.journeys(i).requested_date_time());
+    }
+}
+
 template <typename speed_provider_trait>
 struct streetnetworkmode_fixture : public routing_api_data<speed_provider_trait> {
 
@@ -1852,11 +1900,12 @@ BOOST_AUTO_TEST_CASE(use_crow_fly){
     ep.uri = "admin";
     navitia::type::StopPoint sp2;
     navitia::type::StopArea sa2;
+    sa2.idx = 42;
     sp2.stop_area = &sa2;
     BOOST_CHECK(nr::use_crow_fly(ep, sp2, empty_sn_path, data));
     BOOST_CHECK(! nr::use_crow_fly(ep, sp2, filled_sn_path, data));
 
-    admin->main_stop_areas.push_back(&sa2);
+    admin->main_stop_areas.push_back(sa2.idx);
     BOOST_CHECK(nr::use_crow_fly(ep, sp2, empty_sn_path, data));
     BOOST_CHECK(nr::use_crow_fly(ep, sp2, filled_sn_path, data));
 }
@@ -0,0 +1,131 @@
+/* Copyright © 2001-2014, Canal TP and/or its affiliates. All rights reserved.
+  
+This file is part of Navitia,
+    the software to build cool stuff with public transport.
+ 
+Hope you'll enjoy and contribute to this project,
+    powered by Canal TP (www.canaltp.fr).
+Help us simplify mobility and open public transport:
+    a non ending quest to the responsive locomotion way of traveling!
+  
+LICENCE: This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU Affero General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+   
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU Affero General Public License for more details.
+   
+You should have received a copy of the GNU Affero General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+  
+Stay tuned using
+twitter @navitia 
+IRC #navitia on freenode
+https://groups.google.com/d/forum/navitia
+www.navitia.io
+*/
+
+#include "build_scheduler.h"
+#include "utils/exception.h"
+
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include <log4cplus/logger.h>
+#include <log4cplus/loggingmacros.h>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <thread>
+
+namespace pt = boost::posix_time;
+
+namespace navitia { namespace type {
+
+BuildScheduler::Stage BuildScheduler::add(const std::string& name,
+                                          const std::function<void()>& build,
+                                          const std::vector<Stage>& dependencies) {
+    const Stage stage = stages.size();
+    for (const auto dependency: dependencies) {
+        if (dependency >= stage) {
+            throw navitia::exception("build stage " + name + " depends on an unknown stage");
+        }
+        stages[dependency].dependents.push_back(stage);
+    }
+    stages.push_back({name, build, dependencies.size(), {}});
+    return stage;
+}
+
+void BuildScheduler::run(size_t nb_threads) {
+    auto logger = log4cplus::Logger::getInstance("log");
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::deque<Stage> ready;
+    std::vector<size_t> nb_waited_dependencies;
+    std::vector<bool> skipped(stages.size(), false);
+    for (Stage stage = 0; stage < stages.size(); ++stage) {
+        nb_waited_dependencies.push_back(stages[stage].nb_dependencies);
+        if (stages[stage].nb_dependencies == 0) { ready.push_back(stage); }
+    }
+    // stages neither finished nor skipped
+    size_t nb_pending = stages.size();
+    std::exception_ptr error;
+
+    // the dependents of a failed stage, and their own dependents, are never run
+    std::function<void(Stage)> skip_dependents = [&](Stage stage) {
+        for (const auto dependent: stages[stage].dependents) {
+            if (skipped[dependent]) { continue; }
+            skipped[dependent] = true;
+            --nb_pending;
+            LOG4CPLUS_WARN(logger, "Skipping " << stages[dependent].name);
+            skip_dependents(dependent);
+        }
+    };
+
+    auto work = [&]() {
+        std::unique_lock<std::mutex> lock(mutex);
+        for (;;) {
+            cv.wait(lock, [&]() { return ! ready.empty() || nb_pending == 0; });
+            if (ready.empty()) { return; }
+            const Stage stage = ready.front();
+            ready.pop_front();
+            lock.unlock();
+
+            LOG4CPLUS_INFO(logger, "Building " << stages[stage].name);
+            const auto start = pt::microsec_clock::local_time();
+            std::exception_ptr stage_error;
+            try {
+                stages[stage].build();
+            } catch (...) {
+                stage_error = std::current_exception();
+            }
+            LOG4CPLUS_INFO(logger, "\t Building " << stages[stage].name << ": "
+                           << (pt::microsec_clock::local_time() - start).total_milliseconds() << "ms");
+
+            lock.lock();
+            if (stage_error) {
+                if (! error) { error = stage_error; }
+                skip_dependents(stage);
+            } else {
+                for (const auto dependent: stages[stage].dependents) {
+                    if (--nb_waited_dependencies[dependent] == 0) { ready.push_back(dependent); }
+                }
+            }
+            --nb_pending;
+            cv.notify_all();
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (size_t i = 1; i < nb_threads && i < stages.size(); ++i) {
+        threads.emplace_back(work);
+    }
+    work();
+    for (auto& thread: threads) { thread.join(); }
+
+    if (error) { std::rethrow_exception(error); }
+}
+
+}} // namespace navitia::type
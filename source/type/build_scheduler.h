@@ -0,0 +1,68 @@
+/* Copyright © 2001-2014, Canal TP and/or its affiliates. All rights reserved.
+  
+This file is part of Navitia,
+    the software to build cool stuff with public transport.
+ 
+Hope you'll enjoy and contribute to this project,
+    powered by Canal TP (www.canaltp.fr).
+Help us simplify mobility and open public transport:
+    a non ending quest to the responsive locomotion way of traveling!
+  
+LICENCE: This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU Affero General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+   
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU Affero General Public License for more details.
+   
+You should have received a copy of the GNU Affero General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+  
+Stay tuned using
+twitter @navitia 
+IRC #navitia on freenode
+https://groups.google.com/d/forum/navitia
+www.navitia.io
+*/
+
+#pragma once
+
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace navitia { namespace type {
+
+/**
+ * Runs build stages on a few threads, respecting their dependencies.
+ *
+ * A stage starts as soon as all the stages it depends on are finished.
+ * A stage can only depend on stages added before it, so there is no cycle.
+ * When a stage throws, the stages depending on it are not run, the other
+ * ones go on, and run() rethrows the first exception.
+ */
+class BuildScheduler {
+public:
+    typedef size_t Stage;
+
+    Stage add(const std::string& name,
+              const std::function<void()>& build,
+              const std::vector<Stage>& dependencies = {});
+
+    /// Runs all the stages, nb_threads at a time at most, the calling thread included
+    void run(size_t nb_threads);
+
+private:
+    struct StageData {
+        std::string name;
+        std::function<void()> build;
+        size_t nb_dependencies;
+        std::vector<Stage> dependents;
+    };
+    std::vector<StageData> stages;
+};
+
+}} // namespace navitia::type
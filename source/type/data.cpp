@@ -43,17 +43,21 @@ www.navitia.io
 #include <boost/range/algorithm/find.hpp>
 #include <boost/container/container_fwd.hpp>
 #include <thread>
+#include <set>
 
 #include "third_party/eos_portable_archive/portable_iarchive.hpp"
 #include "third_party/eos_portable_archive/portable_oarchive.hpp"
 #include "lz4_filter/filter.h"
+#include "lz4_filter/block_container.h"
 #include "utils/functions.h"
 #include "utils/exception.h"
 #include "utils/threadbuf.h"
 
 #include "pt_data.h"
+#include "build_scheduler.h"
 #include "routing/dataraptor.h"
 #include "georef/georef.h"
+#include "autocomplete/autocomplete_cache.h"
 #include "fare/fare.h"
 #include "type/meta_data.h"
 #include "kraken/fill_disruption_from_database.h"
@@ -64,19 +68,16 @@ namespace navitia { namespace type {
 
 wrong_version::~wrong_version() noexcept {}
 
-const unsigned int Data::data_version = 66; //< *INCREMENT* every time serialized data are modified
+const unsigned int Data::data_version = 73; //< *INCREMENT* every time serialized data are modified
 
 Data::Data(size_t data_identifier) :
     data_identifier(data_identifier),
     meta(std::make_unique<MetaData>()),
     pt_data(std::make_unique<PT_Data>()),
-    geo_ref(std::make_unique<navitia::georef::GeoRef>()),
+    geo_ref(boost::make_shared<navitia::georef::GeoRef>()),
     dataRaptor(std::make_unique<navitia::routing::dataRAPTOR>()),
-    fare(std::make_unique<navitia::fare::Fare>()),
-    find_admins(
-            [&](const GeographicalCoord &c){
-            return geo_ref->find_admins(c);
-            })
+    fare(boost::make_shared<navitia::fare::Fare>()),
+    autocomplete_cache(std::make_unique<navitia::autocomplete::AutocompleteCache<idx_t>>(1000000))
 {
     loaded = false;
     is_connected_to_rabbitmq = false;
@@ -85,6 +86,30 @@ Data::Data(size_t data_identifier) :
 
 Data::~Data(){}
 
+// The admins of the stop areas and stop points are owned by the geo_ref.
+// Since the pt_data is streamed alone (see clone_from and load_sections),
+// they have been deep cloned with it (with their parent admins), we make the
+// pt objects point to the shared admins and we delete the clones.
+static void collect_cloned_admins(const georef::Admin* admin, std::set<const georef::Admin*>& cloned) {
+    if (! cloned.insert(admin).second) { return; }
+    for (const auto* parent: admin->admin_list) {
+        collect_cloned_admins(parent, cloned);
+    }
+}
+
+static void relink_admins(const georef::GeoRef& geo_ref, PT_Data& pt_data) {
+    std::set<const georef::Admin*> cloned;
+    auto relink = [&](std::vector<georef::Admin*>& admin_list) {
+        for (auto& admin: admin_list) {
+            collect_cloned_admins(admin, cloned);
+            admin = geo_ref.admins.at(admin->idx);
+        }
+    };
+    for (auto* sa: pt_data.stop_areas) { relink(sa->admin_list); }
+    for (auto* sp: pt_data.stop_points) { relink(sp->admin_list); }
+    for (const auto* admin: cloned) { delete admin; }
+}
+
 bool Data::load(const std::string& filename,
                 const boost::optional<std::string>& chaos_database,
                 const std::vector<std::string>& contributors,
@@ -103,10 +128,17 @@ bool Data::load(const std::string& filename,
                        % pt_data->stop_point_connections.size()
                        % pt_data->stop_points.size()
             );
+        // the street network and the public transport are built side by side
+        BuildScheduler scheduler;
+        scheduler.add("csr graph", [&]() { geo_ref->build_csr_graph(); });
+        std::vector<BuildScheduler::Stage> disruptions;
         if (chaos_database) {
-            fill_disruption_from_database(*chaos_database, *pt_data, *meta, contributors);
+            disruptions.push_back(scheduler.add("disruptions", [&]() {
+                fill_disruption_from_database(*chaos_database, *pt_data, *meta, contributors);
+            }));
         }
-        build_raptor(raptor_cache_size);
+        scheduler.add("dataRaptor", [&]() { build_raptor(raptor_cache_size); }, disruptions);
+        scheduler.run(2);
     } catch(const wrong_version& ex) {
         LOG4CPLUS_ERROR(logger, "Cannot load data: " << ex.what());
         last_load = false;
@@ -122,6 +154,13 @@ bool Data::load(const std::string& filename,
 }
 
 void Data::load(std::istream& ifs) {
+    // the cached ids refer to the autocompletes being replaced
+    autocomplete_cache->clear();
+    if (LZ4BlockReader::is_block_container(ifs)) {
+        load_sections(ifs);
+        return;
+    }
+    // former format: a single lz4 stream
     boost::iostreams::filtering_streambuf<boost::iostreams::input> in;
     in.push(LZ4Decompressor(2048*500),8192*500, 8192*500);
     in.push(ifs);
@@ -129,6 +168,44 @@ void Data::load(std::istream& ifs) {
     ia >> *this;
 }
 
+// Each section has its own archive, they are deserialized concurrently.  As
+// in clone_from, the admins of the pt objects are relinked to the ones of the
+// street network afterwards.
+void Data::load_sections(std::istream& ifs) {
+    LZ4BlockReader reader(ifs);
+    if (reader.get_user_version() != data_version) {
+        unsigned int v = data_version;
+        auto msg = boost::format("Warning data version don't match with the data version of kraken %u (current version: %d)")
+                % reader.get_user_version() % v;
+        throw wrong_version(msg.str());
+    }
+    version = reader.get_user_version();
+
+    auto load_section = [&](const std::string& name, const std::function<void(eos::portable_iarchive&)>& load) {
+        return [&reader, name, load]() {
+            boost::iostreams::filtering_streambuf<boost::iostreams::input> in;
+            in.push(LZ4SectionSource(reader, name), 8192*500, 8192*500);
+            eos::portable_iarchive ia(in);
+            load(ia);
+        };
+    };
+    BuildScheduler scheduler;
+    const auto pt = scheduler.add("pt_data section", load_section("pt_data", [&](eos::portable_iarchive& ia) {
+        ia >> *pt_data;
+    }));
+    const auto geo = scheduler.add("geo_ref section", load_section("geo_ref", [&](eos::portable_iarchive& ia) {
+        ia >> *geo_ref;
+    }));
+    scheduler.add("meta section", load_section("meta", [&](eos::portable_iarchive& ia) {
+        ia >> *meta >> last_load_at >> loaded >> last_load >> is_connected_to_rabbitmq >> is_realtime_loaded;
+    }));
+    scheduler.add("fare section", load_section("fare", [&](eos::portable_iarchive& ia) {
+        ia >> *fare;
+    }));
+    scheduler.add("admins relinking", [&]() { relink_admins(*geo_ref, *pt_data); }, {pt, geo});
+    scheduler.run(4);
+}
+
 
 void Data::save(const std::string& filename) const {
     log4cplus::Logger logger = log4cplus::Logger::getInstance(LOG4CPLUS_TEXT("logger"));
@@ -172,11 +249,24 @@ void Data::save(const std::string& filename) const {
 }
 
 void Data::save(std::ostream& ofs) const {
-    boost::iostreams::filtering_streambuf<boost::iostreams::output> out;
-    out.push(LZ4Compressor(2048*500), 1024*500, 1024*500);
-    out.push(ofs);
-    eos::portable_oarchive oa(out);
-    oa << *this;
+    LZ4BlockWriter writer(ofs, data_version);
+    auto save_section = [&](const std::string& name, const std::function<void(eos::portable_oarchive&)>& save) {
+        writer.begin_section(name);
+        {
+            boost::iostreams::filtering_streambuf<boost::iostreams::output> out;
+            out.push(LZ4BlockSink(writer), 1024*500, 1024*500);
+            eos::portable_oarchive oa(out);
+            save(oa);
+        }
+        writer.end_section();
+    };
+    save_section("pt_data", [&](eos::portable_oarchive& oa) { oa << *pt_data; });
+    save_section("geo_ref", [&](eos::portable_oarchive& oa) { oa << *geo_ref; });
+    save_section("meta", [&](eos::portable_oarchive& oa) {
+        oa << *meta << last_load_at << loaded << last_load << is_connected_to_rabbitmq << is_realtime_loaded;
+    });
+    save_section("fare", [&](eos::portable_oarchive& oa) { oa << *fare; });
+    writer.finish();
 }
 
 void Data::build_uri(){
@@ -188,24 +278,62 @@ ITERATE_NAVITIA_PT_TYPES(CLEAR_EXT_CODE)
     geo_ref->build_admin_map();
 }
 
-void Data::build_proximity_list(){
+void Data::build_proximity_list(size_t nb_threads){
     this->pt_data->build_proximity_list();
     this->geo_ref->build_proximity_list();
-    this->geo_ref->project_stop_points(this->pt_data->stop_points);
+    this->geo_ref->project_stop_points(this->pt_data->stop_points, nb_threads);
 }
 
-void  Data::build_administrative_regions() {
+std::vector<std::vector<georef::Admin*>>
+Data::find_admins_of(const std::vector<const GeographicalCoord*>& coords, size_t nb_threads) const {
+    std::vector<std::vector<georef::Admin*>> admins(coords.size());
+    if (find_admins) {
+        // a replaced find_admins is not required to be thread safe
+        for (size_t i = 0; i < coords.size(); ++i) {
+            admins[i] = find_admins(*coords[i]);
+        }
+        return admins;
+    }
+    std::vector<std::exception_ptr> errors(std::max(nb_threads, size_t(1)));
+    auto run = [&](size_t thread_idx) {
+        try {
+            for (size_t i = thread_idx; i < coords.size(); i += errors.size()) {
+                admins[i] = geo_ref->find_admins(*coords[i]);
+            }
+        } catch (...) {
+            errors[thread_idx] = std::current_exception();
+        }
+    };
+    std::vector<std::thread> threads;
+    for (size_t thread_idx = 1; thread_idx < errors.size() && thread_idx < coords.size(); ++thread_idx) {
+        threads.emplace_back(run, thread_idx);
+    }
+    run(0);
+    for (auto& thread: threads) { thread.join(); }
+    for (const auto& error: errors) {
+        if (error) { std::rethrow_exception(error); }
+    }
+    return admins;
+}
+
+void  Data::build_administrative_regions(size_t nb_threads) {
     auto log = log4cplus::Logger::getInstance("ed::Data");
 
     // set admins to stop points
-    int cpt_no_projected = 0;
+    std::vector<type::StopPoint*> stop_points;
+    std::vector<const GeographicalCoord*> coords;
     for (type::StopPoint* stop_point : pt_data->stop_points) {
         if (!stop_point->admin_list.empty()) {
             continue;
         }
-        const auto &admins = find_admins(stop_point->coord);
-        boost::push_back(stop_point->admin_list, admins);
-        if (admins.empty()) ++cpt_no_projected;
+        stop_points.push_back(stop_point);
+        coords.push_back(&stop_point->coord);
+    }
+    int cpt_no_projected = 0;
+    auto stop_point_admins = find_admins_of(coords, nb_threads);
+    for (size_t i = 0; i < stop_points.size(); ++i) {
+        boost::push_back(stop_points[i]->admin_list, stop_point_admins[i]);
+        if (stop_point_admins[i].empty()) ++cpt_no_projected;
     }
     if (cpt_no_projected)
         LOG4CPLUS_WARN(log, cpt_no_projected << "/" << pt_data->stop_points.size()
@@ -214,6 +342,8 @@ void  Data::build_administrative_regions() {
     // set admins to poi
     cpt_no_projected = 0;
     int cpt_no_initialized = 0;
+    std::vector<georef::POI*> pois;
+    coords.clear();
     for (georef::POI* poi: geo_ref->pois) {
         if (!poi->coord.is_initialized()) {
             cpt_no_initialized++;
@@ -222,9 +352,13 @@ void  Data::build_administrative_regions() {
         if (!poi->admin_list.empty()) {
             continue;
         }
-        const auto &admins = find_admins(poi->coord);
-        boost::push_back(poi->admin_list, admins);
-        if (admins.empty()) {
+        pois.push_back(poi);
+        coords.push_back(&poi->coord);
+    }
+    auto poi_admins = find_admins_of(coords, nb_threads);
+    for (size_t i = 0; i < pois.size(); ++i) {
+        boost::push_back(pois[i]->admin_list, poi_admins[i]);
+        if (poi_admins[i].empty()) {
             ++cpt_no_projected;
         }
     }
@@ -240,32 +374,44 @@ void  Data::build_administrative_regions() {
     for (const auto* sa: pt_data->stop_areas)
         for (auto admin: sa->admin_list)
             if (!admin->from_original_dataset)
-                admin->main_stop_areas.push_back(sa);
+                admin->main_stop_areas.push_back(sa->idx);
 }
 
 void Data::build_autocomplete(){
     pt_data->build_autocomplete(*geo_ref);
     geo_ref->build_autocomplete_list();
     pt_data->compute_score_autocomplete(*geo_ref);
+    // the ids of the autocompletes have changed
+    autocomplete_cache->clear();
+}
+
+void Data::build_autocomplete_cache(size_t max_nb_ids) {
+    autocomplete_cache = std::make_unique<navitia::autocomplete::AutocompleteCache<idx_t>>(max_nb_ids);
 }
 
 void Data::build_raptor(size_t cache_size) {
     LOG4CPLUS_DEBUG(log4cplus::Logger::getInstance("log"),
                     "Start to build dataRaptor");
     dataRaptor->load(*this->pt_data, cache_size);
+    pt_data->modified_routes.clear();
     LOG4CPLUS_DEBUG(log4cplus::Logger::getInstance("log"),
                     "Finished to build dataRaptor");
 }
 
-ValidityPattern* Data::get_similar_validity_pattern(ValidityPattern* vp) const{
-    auto find_vp_predicate = [&](ValidityPattern* vp1) { return ((*vp) == (*vp1));};
-    auto it = std::find_if(this->pt_data->validity_patterns.begin(),
-                        this->pt_data->validity_patterns.end(), find_vp_predicate);
-    if(it != this->pt_data->validity_patterns.end()) {
-        return *(it);
-    } else {
-        return nullptr;
+void Data::update_raptor(const Data& previous, size_t cache_size) {
+    auto logger = log4cplus::Logger::getInstance("log");
+    if (previous.pt_data->routes.size() != pt_data->routes.size()
+            || previous.dataRaptor->jp_container.get_jps_from_route().size() != pt_data->routes.size()) {
+        // the previous raptor data cannot be reused
+        LOG4CPLUS_INFO(logger, "the routes have changed, dataRaptor is fully rebuilt");
+        build_raptor(cache_size);
+        return;
     }
+    LOG4CPLUS_DEBUG(logger, "Start to update dataRaptor, " << pt_data->modified_routes.size()
+                    << "/" << pt_data->routes.size() << " routes modified");
+    dataRaptor->update(*this->pt_data, *previous.dataRaptor, pt_data->modified_routes, cache_size);
+    pt_data->modified_routes.clear();
+    LOG4CPLUS_DEBUG(logger, "Finished to update dataRaptor");
 }
 
 using list_cal_bitset = std::vector<std::pair<const Calendar*, ValidityPattern::year_bitset>>;
@@ -305,40 +451,54 @@ find_matching_calendar(const Data&, const std::string& name, const ValidityPatte
 }
 
 void Data::complete(){
-    auto logger = log4cplus::Logger::getInstance("log");
-    pt::ptime start;
-    int admin, sort, autocomplete;
+    const size_t nb_threads = std::max(1u, std::thread::hardware_concurrency());
+    BuildScheduler scheduler;
+    typedef std::vector<BuildScheduler::Stage> Stages;
 
-    build_grid_validity_pattern();
+    const auto validity_patterns = scheduler.add("validity patterns", [&]() { build_grid_validity_pattern(); });
     //build_associated_calendar(); read from database
-    
-    start = pt::microsec_clock::local_time();
-    LOG4CPLUS_INFO(logger, "Building administrative regions");
-    build_administrative_regions();
-    admin = (pt::microsec_clock::local_time() - start).total_milliseconds();
-
-    aggregate_odt();
-
-    build_relations();
 
-    compute_labels();
-
-    start = pt::microsec_clock::local_time();
-    pt_data->sort();
-    sort = (pt::microsec_clock::local_time() - start).total_milliseconds();
-
-    start = pt::microsec_clock::local_time();
-    LOG4CPLUS_INFO(logger, "Building proximity list");
-    build_proximity_list();
-    LOG4CPLUS_INFO(logger, "Building uri maps");
-    build_uri();
-    LOG4CPLUS_INFO(logger, "Building autocomplete");
-    build_autocomplete();
-    autocomplete = (pt::microsec_clock::local_time() - start).total_milliseconds();
-
-    LOG4CPLUS_INFO(logger, "\t Building admins: " << admin << "ms");
-    LOG4CPLUS_INFO(logger, "\t Sorting data: " << sort << "ms");
-    LOG4CPLUS_INFO(logger, "\t Building autocomplete " << autocomplete << "ms");
+    // the admins are found with the street network proximity list, it must not be rebuilt meanwhile
+    const auto admins = scheduler.add("administrative regions", [&]() {
+        build_administrative_regions(nb_threads);
+    });
+    const auto relations = scheduler.add("relations", [&]() { build_relations(); });
+    const auto odt = scheduler.add("odt", [&]() { aggregate_odt(); }, Stages{admins, relations});
+    const auto labels = scheduler.add("labels", [&]() { compute_labels(); }, Stages{admins});
+    // the sort changes the idx of the pt objects
+    std::vector<const StopArea*> stop_areas_before_sort;
+    std::vector<const StopPoint*> stop_points_before_sort;
+    const auto sort = scheduler.add("sort", [&]() {
+        stop_areas_before_sort.assign(pt_data->stop_areas.begin(), pt_data->stop_areas.end());
+        stop_points_before_sort.assign(pt_data->stop_points.begin(), pt_data->stop_points.end());
+        pt_data->sort();
+    }, Stages{validity_patterns, odt, labels});
+    scheduler.add("admins stops", [&]() {
+        renumber_admins_stops(stop_areas_before_sort, stop_points_before_sort);
+    }, Stages{sort});
+
+    scheduler.add("pt proximity list", [&]() { pt_data->build_proximity_list(); }, Stages{sort});
+    const auto geo_proximity_list = scheduler.add("street network proximity list", [&]() {
+        geo_ref->build_proximity_list();
+    }, Stages{admins});
+    scheduler.add("stop points projection", [&]() {
+        geo_ref->project_stop_points(pt_data->stop_points, nb_threads);
+    }, Stages{geo_proximity_list, sort});
+
+    scheduler.add("uri maps", [&]() { build_uri(); }, Stages{sort});
+
+    const auto pt_autocomplete = scheduler.add("pt autocomplete", [&]() {
+        pt_data->build_autocomplete(*geo_ref);
+    }, Stages{sort});
+    const auto geo_autocomplete = scheduler.add("street network autocomplete", [&]() {
+        geo_ref->build_autocomplete_list();
+    }, Stages{admins});
+    scheduler.add("autocomplete scores", [&]() {
+        pt_data->compute_score_autocomplete(*geo_ref);
+        autocomplete_cache->clear();
+    }, Stages{pt_autocomplete, geo_autocomplete});
+
+    scheduler.run(nb_threads);
 }
 
 static ValidityPattern get_union_validity_pattern(const MetaVehicleJourney& meta_vj) {
@@ -458,6 +618,18 @@ void Data::build_relations(){
     }
 }
 
+void Data::renumber_admins_stops(const std::vector<const StopArea*>& stop_areas_before_sort,
+                                 const std::vector<const StopPoint*>& stop_points_before_sort) {
+    for (auto* admin: geo_ref->admins) {
+        for (auto& idx: admin->main_stop_areas) {
+            idx = stop_areas_before_sort.at(idx)->idx;
+        }
+        for (auto& idx: admin->odt_stop_points) {
+            idx = stop_points_before_sort.at(idx)->idx;
+        }
+    }
+}
+
 void Data::aggregate_odt(){
     // TODO ODT NTFSv0.3: remove that when we stop to support NTFSv0.1
     //
@@ -485,7 +657,7 @@ void Data::aggregate_odt(){
     //we first store the stops in a set not to have dupplicates
     for (const auto& p: odt_stops_by_admin) {
         for (const auto& sp: p.second) {
-            p.first->odt_stop_points.push_back(sp);
+            p.first->odt_stop_points.push_back(sp->idx);
         }
     }
 }
@@ -644,14 +816,18 @@ Indexes Data::get_all_index(Type_e type) const {
 Indexes
 Data::get_target_by_source(Type_e source, Type_e target,
                            Indexes source_idx) const {
-    Indexes result;
-    result.reserve(source_idx.size());
-    for(idx_t idx : source_idx) {
-        Indexes tmp = get_target_by_one_source(source, target, idx);
-        // TODO: Use flat_set's merge when we pass to boost 1.62
-        result.insert(boost::container::ordered_unique_range_t(),
-                      tmp.begin(), tmp.end());
-    }
+    return get_target_by_source(source, target, IndexBitmap(source_idx)).to_indexes();
+}
+
+IndexBitmap
+Data::get_target_by_source(Type_e source, Type_e target,
+                           const IndexBitmap& source_idx) const {
+    // merging the targets in a sorted vector would move its tail for each source
+    IndexBitmap result;
+    source_idx.for_each([&](idx_t idx) {
+        const Indexes tmp = get_target_by_one_source(source, target, idx);
+        result.insert(tmp.begin(), tmp.end());
+    });
     return result;
 }
 
@@ -788,11 +964,33 @@ struct Pipe {
 // stream the source object in a binary_oarchive, and then stream it
 // in our object.  To avoid having the whole binary_oarchive in
 // memory, we construct a pipe between 2 threads.
+//
+// The realtime only modifies the pt_data (and reads the meta), thus we
+// only stream those, the street network and the fares (which are by far
+// the biggest part of a Data) are shared with the cloned Data.
 void Data::clone_from(const Data& from) {
+    autocomplete_cache->clear();
+    geo_ref = from.geo_ref;
+    fare = from.fare;
     Pipe p;
-    std::thread write([&]() {boost::archive::binary_oarchive oa(p.out); oa << from;});
-    { boost::archive::binary_iarchive ia(p.in); ia >> *this; }
+    std::thread write([&]() {
+        boost::archive::binary_oarchive oa(p.out);
+        oa << *from.pt_data << *from.meta;
+    });
+    {
+        boost::archive::binary_iarchive ia(p.in);
+        ia >> *pt_data >> *meta;
+    }
     write.join();
+    relink_admins(*geo_ref, *pt_data);
+
+    version = from.version;
+    last_load_at = from.last_load_at;
+    last_load = from.last_load;
+    last_rt_data_loaded = from.last_rt_data_loaded;
+    loaded = from.loaded.load();
+    is_connected_to_rabbitmq = from.is_connected_to_rabbitmq.load();
+    is_realtime_loaded = from.is_realtime_loaded.load();
 }
 
 }} //namespace navitia::type
@@ -32,10 +32,13 @@ www.navitia.io
 #include "utils/logger.h"
 #include <boost/utility.hpp>
 #include <boost/serialization/version.hpp>
+#include <boost/serialization/shared_ptr.hpp>
 #include <boost/format.hpp>
 #include <boost/optional.hpp>
+#include <boost/shared_ptr.hpp>
 #include <atomic>
 #include "type/type.h"
+#include "type/index_bitmap.h"
 #include "utils/serialization_unique_ptr.h"
 #include "utils/serialization_atomic.h"
 #include "utils/exception.h"
@@ -51,6 +54,9 @@ namespace navitia {
     namespace fare {
         struct Fare;
     }
+    namespace autocomplete {
+        template<class T> class AutocompleteCache;
+    }
     namespace routing {
         struct dataRAPTOR;
         struct JourneyPattern;
@@ -142,15 +148,20 @@ public:
     /// public transport (PT) referential
     std::unique_ptr<PT_Data> pt_data;
 
-    std::unique_ptr<navitia::georef::GeoRef> geo_ref;
+    /// street network referential
+    /// it is never modified by the realtime, so it is shared between the snapshots (see clone_from)
+    boost::shared_ptr<navitia::georef::GeoRef> geo_ref;
 
     /// precomputed data for raptor (public transport routing algorithm)
     std::unique_ptr<navitia::routing::dataRAPTOR> dataRaptor;
 
-    /// Fare data
-    std::unique_ptr<navitia::fare::Fare> fare;
+    /// Fare data, shared between the snapshots like geo_ref
+    boost::shared_ptr<navitia::fare::Fare> fare;
+
+    /// ids found by the last autocomplete queries, not serialized (see build_autocomplete_cache)
+    std::unique_ptr<navitia::autocomplete::AutocompleteCache<idx_t>> autocomplete_cache;
 
-    // functor to find admins
+    // functor to find admins, if empty the admins are found in the street network (see find_admins_of)
     std::function<std::vector<georef::Admin*>(const GeographicalCoord&)> find_admins;
 
     /** Return the vector containing all the objects of type T*/
@@ -179,6 +190,7 @@ public:
       * retourne une liste d'indexes pointant vers target
       */
     Indexes get_target_by_source(Type_e source, Type_e target, Indexes source_idx) const;
+    IndexBitmap get_target_by_source(Type_e source, Type_e target, const IndexBitmap& source_idx) const;
 
     /** Étant donné un index pointant vers source,
       * retourne une liste d'indexes pointant vers target
@@ -237,19 +249,40 @@ public:
 
 
     /** Construit l'indexe ProximityList */
-    void build_proximity_list();
+    void build_proximity_list(size_t nb_threads = 1);
     /** Set admins*/
-    void build_administrative_regions();
+    void build_administrative_regions(size_t nb_threads = 1);
+    /** The admins of each coord, searched on nb_threads threads unless find_admins has been replaced */
+    std::vector<std::vector<georef::Admin*>>
+    find_admins_of(const std::vector<const GeographicalCoord*>& coords, size_t nb_threads) const;
     /** Construit les données raptor */
     void build_raptor(size_t cache_size = 10);
 
+    /// Replace the autocomplete cache by an empty one keeping at most max_nb_ids ids
+    void build_autocomplete_cache(size_t max_nb_ids);
+
+    /** Build the raptor data reusing the ones of previous for the routes
+      * not modified since (see PT_Data::modified_routes).
+      *
+      * This Data must have been cloned from previous (see clone_from).
+      */
+    void update_raptor(const Data& previous, size_t cache_size = 10);
+
     void build_associated_calendar();
 
     void aggregate_odt();
     void build_relations();
 
+    /** The admins store the idx of their main stop areas and odt stop points,
+      * given the stop areas and stop points indexed before the sort, the idx
+      * are replaced by the ones after the sort
+      */
+    void renumber_admins_stops(const std::vector<const StopArea*>& stop_areas_before_sort,
+                               const std::vector<const StopPoint*>& stop_points_before_sort);
+
     void build_grid_validity_pattern();
 
+    /** Builds all the indexes of freshly read data, the independent stages in parallel */
     void complete();
 
     /** For some pt object we compute the label */
@@ -263,17 +296,28 @@ public:
       *
       * La compression LZ4 est extrèmement rapide mais moyennement performante
       * Le but est que la lecture du fichier compression soit aussi rapide que sans compression
+      * Both the block container written by save and the former single LZ4 stream are read.
       */
     void load(std::istream& ifs);
 
-    /** Sauvegarde les données en binaire compressé avec LZ4*/
+    /** Sauvegarde les données en binaire compressé avec LZ4
+     *
+     * pt_data, geo_ref, meta and fare are written in separate sections of a
+     * LZ4 block container (see lz4_filter/block_container.h), so that they can be
+     * decompressed and deserialized in parallel.
+     */
     void save(std::ostream& ifs) const;
 
-    // Deep clone from the given Data.
+    /** Clone the given Data to build a new snapshot on which the realtime can be applied.
+     *
+     * Only the parts modified by the realtime (pt_data and meta) are deep cloned,
+     * geo_ref and fare are shared with the given Data.
+     * dataRaptor is not cloned, build_raptor has to be called on the new snapshot.
+     */
     void clone_from(const Data&);
 private:
-    /** Get similar validitypattern **/
-    ValidityPattern* get_similar_validity_pattern(ValidityPattern* vp) const;
+    /** Reads the sections written by save, concurrently */
+    void load_sections(std::istream& ifs);
 };
 
 
@@ -0,0 +1,315 @@
+/* Copyright © 2001-2014, Canal TP and/or its affiliates. All rights reserved.
+  
+This file is part of Navitia,
+    the software to build cool stuff with public transport.
+ 
+Hope you'll enjoy and contribute to this project,
+    powered by Canal TP (www.canaltp.fr).
+Help us simplify mobility and open public transport:
+    a non ending quest to the responsive locomotion way of traveling!
+  
+LICENCE: This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU Affero General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+   
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU Affero General Public License for more details.
+   
+You should have received a copy of the GNU Affero General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+  
+Stay tuned using
+twitter @navitia 
+IRC #navitia on freenode
+https://groups.google.com/d/forum/navitia
+www.navitia.io
+*/
+
+#include "index_bitmap.h"
+#include <algorithm>
+#include <iterator>
+
+namespace navitia { namespace type {
+
+static_assert(sizeof(idx_t) <= 4, "the indexes are split in 16 high bits and 16 low bits");
+
+static const size_t bitset_size = (1 << 16) / 64;
+
+static size_t popcount(const std::vector<uint64_t>& bits) {
+    size_t res = 0;
+    for (const uint64_t word: bits) { res += size_t(__builtin_popcountll(word)); }
+    return res;
+}
+
+void IndexBitmap::Container::insert(uint16_t low) {
+    if (is_bitset()) {
+        uint64_t& word = bits[low / 64];
+        const uint64_t mask = uint64_t(1) << (low % 64);
+        if (! (word & mask)) {
+            word |= mask;
+            ++cardinality;
+        }
+        return;
+    }
+    // the indexes are mostly inserted in increasing order
+    if (array.empty() || array.back() < low) {
+        array.push_back(low);
+    } else {
+        auto it = std::lower_bound(array.begin(), array.end(), low);
+        if (*it == low) { return; }
+        array.insert(it, low);
+    }
+    ++cardinality;
+    if (array.size() > max_array_size) { to_bitset(); }
+}
+
+bool IndexBitmap::Container::contains(uint16_t low) const {
+    if (is_bitset()) {
+        return (bits[low / 64] & (uint64_t(1) << (low % 64))) != 0;
+    }
+    return std::binary_search(array.begin(), array.end(), low);
+}
+
+void IndexBitmap::Container::to_bitset() {
+    bits.assign(bitset_size, 0);
+    for (const uint16_t low: array) {
+        bits[low / 64] |= uint64_t(1) << (low % 64);
+    }
+    std::vector<uint16_t>().swap(array);
+}
+
+void IndexBitmap::Container::to_array() {
+    array.clear();
+    array.reserve(cardinality);
+    for_each_in(*this, 0, [&](idx_t low) { array.push_back(uint16_t(low)); });
+    std::vector<uint64_t>().swap(bits);
+}
+
+void IndexBitmap::Container::normalize() {
+    if (is_bitset() && cardinality <= max_array_size) {
+        to_array();
+    } else if (! is_bitset() && cardinality > max_array_size) {
+        to_bitset();
+    }
+}
+
+IndexBitmap::Container IndexBitmap::intersection(const Container& a, const Container& b) {
+    Container res;
+    if (a.is_bitset() && b.is_bitset()) {
+        res.bits.resize(bitset_size);
+        for (size_t i = 0; i < bitset_size; ++i) { res.bits[i] = a.bits[i] & b.bits[i]; }
+        res.cardinality = popcount(res.bits);
+        res.normalize();
+    } else if (a.is_bitset() || b.is_bitset()) {
+        const Container& array = a.is_bitset() ? b : a;
+        const Container& bitset = a.is_bitset() ? a : b;
+        for (const uint16_t low: array.array) {
+            if (bitset.contains(low)) { res.array.push_back(low); }
+        }
+        res.cardinality = res.array.size();
+    } else {
+        std::set_intersection(a.array.begin(), a.array.end(), b.array.begin(), b.array.end(),
+                              std::back_inserter(res.array));
+        res.cardinality = res.array.size();
+    }
+    return res;
+}
+
+IndexBitmap::Container IndexBitmap::union_of(const Container& a, const Container& b) {
+    Container res;
+    if (a.is_bitset() || b.is_bitset()) {
+        const Container& other = a.is_bitset() ? b : a;
+        res.bits = a.is_bitset() ? a.bits : b.bits;
+        if (other.is_bitset()) {
+            for (size_t i = 0; i < bitset_size; ++i) { res.bits[i] |= other.bits[i]; }
+        } else {
+            for (const uint16_t low: other.array) { res.bits[low / 64] |= uint64_t(1) << (low % 64); }
+        }
+        res.cardinality = popcount(res.bits);
+    } else {
+        std::set_union(a.array.begin(), a.array.end(), b.array.begin(), b.array.end(),
+                       std::back_inserter(res.array));
+        res.cardinality = res.array.size();
+        res.normalize();
+    }
+    return res;
+}
+
+IndexBitmap::Container IndexBitmap::difference(const Container& a, const Container& b) {
+    Container res;
+    if (a.is_bitset()) {
+        res.bits = a.bits;
+        if (b.is_bitset()) {
+            for (size_t i = 0; i < bitset_size; ++i) { res.bits[i] &= ~b.bits[i]; }
+        } else {
+            for (const uint16_t low: b.array) { res.bits[low / 64] &= ~(uint64_t(1) << (low % 64)); }
+        }
+        res.cardinality = popcount(res.bits);
+        res.normalize();
+    } else if (b.is_bitset()) {
+        for (const uint16_t low: a.array) {
+            if (! b.contains(low)) { res.array.push_back(low); }
+        }
+        res.cardinality = res.array.size();
+    } else {
+        std::set_difference(a.array.begin(), a.array.end(), b.array.begin(), b.array.end(),
+                            std::back_inserter(res.array));
+        res.cardinality = res.array.size();
+    }
+    return res;
+}
+
+IndexBitmap::IndexBitmap(const Indexes& indexes) {
+    insert(indexes.begin(), indexes.end());
+}
+
+void IndexBitmap::insert(idx_t idx) {
+    const uint16_t key = uint16_t(idx >> 16);
+    const uint16_t low = uint16_t(idx & 0xFFFF);
+    if (keys.empty() || keys.back() < key) {
+        keys.push_back(key);
+        containers.emplace_back();
+        containers.back().insert(low);
+        return;
+    }
+    auto it = std::lower_bound(keys.begin(), keys.end(), key);
+    const auto pos = std::distance(keys.begin(), it);
+    if (*it != key) {
+        keys.insert(it, key);
+        containers.emplace(containers.begin() + pos);
+    }
+    containers[size_t(pos)].insert(low);
+}
+
+bool IndexBitmap::contains(idx_t idx) const {
+    const uint16_t key = uint16_t(idx >> 16);
+    auto it = std::lower_bound(keys.begin(), keys.end(), key);
+    if (it == keys.end() || *it != key) { return false; }
+    return containers[size_t(std::distance(keys.begin(), it))].contains(uint16_t(idx & 0xFFFF));
+}
+
+size_t IndexBitmap::size() const {
+    size_t res = 0;
+    for (const auto& c: containers) { res += c.cardinality; }
+    return res;
+}
+
+void IndexBitmap::clear() {
+    keys.clear();
+    containers.clear();
+}
+
+IndexBitmap& IndexBitmap::operator&=(const IndexBitmap& other) {
+    std::vector<uint16_t> res_keys;
+    std::vector<Container> res_containers;
+    size_t i = 0, j = 0;
+    while (i < keys.size() && j < other.keys.size()) {
+        if (keys[i] < other.keys[j]) {
+            ++i;
+        } else if (other.keys[j] < keys[i]) {
+            ++j;
+        } else {
+            Container c = intersection(containers[i], other.containers[j]);
+            if (c.cardinality != 0) {
+                res_keys.push_back(keys[i]);
+                res_containers.push_back(std::move(c));
+            }
+            ++i;
+            ++j;
+        }
+    }
+    keys = std::move(res_keys);
+    containers = std::move(res_containers);
+    return *this;
+}
+
+IndexBitmap& IndexBitmap::operator|=(const IndexBitmap& other) {
+    std::vector<uint16_t> res_keys;
+    std::vector<Container> res_containers;
+    size_t i = 0, j = 0;
+    while (i < keys.size() || j < other.keys.size()) {
+        if (j == other.keys.size() || (i < keys.size() && keys[i] < other.keys[j])) {
+            res_keys.push_back(keys[i]);
+            res_containers.push_back(std::move(containers[i]));
+            ++i;
+        } else if (i == keys.size() || other.keys[j] < keys[i]) {
+            res_keys.push_back(other.keys[j]);
+            res_containers.push_back(other.containers[j]);
+            ++j;
+        } else {
+            res_keys.push_back(keys[i]);
+            res_containers.push_back(union_of(containers[i], other.containers[j]));
+            ++i;
+            ++j;
+        }
+    }
+    keys = std::move(res_keys);
+    containers = std::move(res_containers);
+    return *this;
+}
+
+IndexBitmap& IndexBitmap::operator-=(const IndexBitmap& other) {
+    std::vector<uint16_t> res_keys;
+    std::vector<Container> res_containers;
+    size_t j = 0;
+    for (size_t i = 0; i < keys.size(); ++i) {
+        while (j < other.keys.size() && other.keys[j] < keys[i]) { ++j; }
+        if (j == other.keys.size() || other.keys[j] != keys[i]) {
+            res_keys.push_back(keys[i]);
+            res_containers.push_back(std::move(containers[i]));
+            continue;
+        }
+        Container c = difference(containers[i], other.containers[j]);
+        if (c.cardinality != 0) {
+            res_keys.push_back(keys[i]);
+            res_containers.push_back(std::move(c));
+        }
+    }
+    keys = std::move(res_keys);
+    containers = std::move(res_containers);
+    return *this;
+}
+
+bool IndexBitmap::operator==(const IndexBitmap& other) const {
+    if (keys != other.keys) { return false; }
+    // the representation of a group depends only on its content
+    for (size_t i = 0; i < containers.size(); ++i) {
+        if (containers[i].array != other.containers[i].array
+                || containers[i].bits != other.containers[i].bits) {
+            return false;
+        }
+    }
+    return true;
+}
+
+Indexes IndexBitmap::to_indexes() const {
+    return to_indexes(0, size());
+}
+
+Indexes IndexBitmap::to_indexes(size_t first, size_t count) const {
+    std::vector<idx_t> res;
+    res.reserve(std::min(count, size()));
+    size_t nb_skipped = 0;
+    for (size_t i = 0; i < keys.size() && res.size() < count; ++i) {
+        // the groups before the page are skipped as a whole
+        if (nb_skipped + containers[i].cardinality <= first) {
+            nb_skipped += containers[i].cardinality;
+            continue;
+        }
+        for_each_in(containers[i], keys[i], [&](idx_t idx) {
+            if (nb_skipped < first) {
+                ++nb_skipped;
+            } else if (res.size() < count) {
+                res.push_back(idx);
+            }
+        });
+    }
+    Indexes indexes;
+    indexes.insert(boost::container::ordered_unique_range_t(), res.begin(), res.end());
+    return indexes;
+}
+
+}} // namespace navitia::type
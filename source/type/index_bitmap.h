@@ -0,0 +1,128 @@
+/* Copyright © 2001-2014, Canal TP and/or its affiliates. All rights reserved.
+  
+This file is part of Navitia,
+    the software to build cool stuff with public transport.
+ 
+Hope you'll enjoy and contribute to this project,
+    powered by Canal TP (www.canaltp.fr).
+Help us simplify mobility and open public transport:
+    a non ending quest to the responsive locomotion way of traveling!
+  
+LICENCE: This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU Affero General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+   
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU Affero General Public License for more details.
+   
+You should have received a copy of the GNU Affero General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+  
+Stay tuned using
+twitter @navitia 
+IRC #navitia on freenode
+https://groups.google.com/d/forum/navitia
+www.navitia.io
+*/
+
+#pragma once
+#include "type/type_interfaces.h"
+#include <cstdint>
+#include <vector>
+
+namespace navitia { namespace type {
+
+/**
+ * Compressed bitmap of indexes (a roaring bitmap)
+ *
+ * The indexes are grouped by their 16 high bits. The 16 low bits of a group
+ * are stored in a sorted array while it is sparse, else in a bitset of 2^16
+ * bits. Thus the set algebra of ptref (intersection of the filters, removal
+ * of the forbidden uris, merge of the targets of the sources) is done group
+ * by group, with word operations on the dense groups, instead of element by
+ * element on sorted vectors.
+ */
+class IndexBitmap {
+public:
+    IndexBitmap() = default;
+    explicit IndexBitmap(const Indexes& indexes);
+
+    void insert(idx_t idx);
+    template<typename It> void insert(It begin, It end) {
+        for (; begin != end; ++begin) { insert(*begin); }
+    }
+    bool contains(idx_t idx) const;
+
+    size_t size() const;
+    bool empty() const { return keys.empty(); }
+    void clear();
+
+    IndexBitmap& operator&=(const IndexBitmap& other);
+    IndexBitmap& operator|=(const IndexBitmap& other);
+    // and not
+    IndexBitmap& operator-=(const IndexBitmap& other);
+
+    bool operator==(const IndexBitmap& other) const;
+    bool operator!=(const IndexBitmap& other) const { return !(*this == other); }
+
+    /// call f on each index, in increasing order
+    template<typename F> void for_each(F f) const {
+        for (size_t i = 0; i < keys.size(); ++i) {
+            for_each_in(containers[i], keys[i], f);
+        }
+    }
+
+    /// the sorted indexes
+    Indexes to_indexes() const;
+
+    /// the sorted indexes from the first-th one, at most count of them (a page)
+    Indexes to_indexes(size_t first, size_t count) const;
+
+private:
+    struct Container {
+        // the sorted low bits, while there are at most max_array_size of them
+        std::vector<uint16_t> array;
+        // else a bit per low bits
+        std::vector<uint64_t> bits;
+        size_t cardinality = 0;
+
+        bool is_bitset() const { return ! bits.empty(); }
+        void insert(uint16_t low);
+        bool contains(uint16_t low) const;
+        // the representation of a group depends only on its cardinality
+        void normalize();
+        void to_bitset();
+        void to_array();
+    };
+    static const size_t max_array_size = 4096;
+
+    template<typename F> static void for_each_in(const Container& c, uint16_t key, F&& f) {
+        const idx_t high = idx_t(key) << 16;
+        if (c.is_bitset()) {
+            for (size_t w = 0; w < c.bits.size(); ++w) {
+                for (uint64_t word = c.bits[w]; word != 0; word &= word - 1) {
+                    f(high | idx_t(w * 64 + size_t(__builtin_ctzll(word))));
+                }
+            }
+        } else {
+            for (const uint16_t low: c.array) { f(high | low); }
+        }
+    }
+
+    static Container intersection(const Container& a, const Container& b);
+    static Container union_of(const Container& a, const Container& b);
+    static Container difference(const Container& a, const Container& b);
+
+    // the high bits of the groups, sorted
+    std::vector<uint16_t> keys;
+    std::vector<Container> containers;
+};
+
+inline IndexBitmap operator&(IndexBitmap a, const IndexBitmap& b) { return a &= b; }
+inline IndexBitmap operator|(IndexBitmap a, const IndexBitmap& b) { return a |= b; }
+inline IndexBitmap operator-(IndexBitmap a, const IndexBitmap& b) { return a -= b; }
+
+}} // namespace navitia::type
@@ -32,14 +32,26 @@ www.navitia.io
 #include "utils/functions.h"
 
 #include <boost/range/algorithm/find_if.hpp>
+#include <unordered_set>
 
 namespace navitia { namespace type {
 
+ValidityPattern* PT_Data::find_validity_pattern(const ValidityPattern& vp_ref) {
+    // the first of the similar patterns is kept, like a scan would do
+    for (; nb_indexed_validity_patterns < validity_patterns.size(); ++nb_indexed_validity_patterns) {
+        auto* vp = validity_patterns[nb_indexed_validity_patterns];
+        validity_patterns_index.emplace(vp, vp);
+    }
+    const auto it = validity_patterns_index.find(&vp_ref);
+    if (it == validity_patterns_index.end()) {
+        return nullptr;
+    }
+    return it->second;
+}
+
 ValidityPattern* PT_Data::get_or_create_validity_pattern(const ValidityPattern& vp_ref) {
-    for (auto vp : validity_patterns) {
-        if (vp->days == vp_ref.days && vp->beginning_date == vp_ref.beginning_date) {
-            return vp;
-        }
+    if (auto* vp = find_validity_pattern(vp_ref)) {
+        return vp;
     }
     auto vp = new nt::ValidityPattern();
     vp->idx = validity_patterns.size();
@@ -51,6 +63,33 @@ ValidityPattern* PT_Data::get_or_create_validity_pattern(const ValidityPattern&
     return vp;
 }
 
+size_t PT_Data::clean_unused_validity_patterns() {
+    std::unordered_set<const ValidityPattern*> used_vps;
+    for (const auto* vj: vehicle_journeys) {
+        for (const auto l: enum_range<RTLevel>()) {
+            if (vj->validity_patterns[l]) { used_vps.insert(vj->validity_patterns[l]); }
+        }
+    }
+
+    std::vector<ValidityPattern*> kept_vps;
+    kept_vps.reserve(used_vps.size());
+    for (auto* vp: validity_patterns) {
+        if (used_vps.count(vp)) {
+            kept_vps.push_back(vp);
+            continue;
+        }
+        validity_patterns_map.erase(vp->uri);
+        delete vp;
+    }
+    const size_t nb_deleted = validity_patterns.size() - kept_vps.size();
+    validity_patterns.swap(kept_vps);
+    std::for_each(validity_patterns.begin(), validity_patterns.end(), Indexer<nt::idx_t>());
+
+    validity_patterns_index.clear();
+    nb_indexed_validity_patterns = 0;
+    return nb_deleted;
+}
+
 void PT_Data::sort(){
 
 #define SORT_AND_INDEX(type_name, collection_name)\
@@ -61,6 +100,10 @@ void PT_Data::sort(){
 
     std::stable_sort(stop_point_connections.begin(), stop_point_connections.end());
     std::for_each(stop_point_connections.begin(), stop_point_connections.end(), Indexer<idx_t>());
+
+    // the validity patterns have been reordered, they must be indexed again
+    validity_patterns_index.clear();
+    nb_indexed_validity_patterns = 0;
 }
 
 
@@ -210,6 +253,12 @@ void PT_Data::clean_weak_impacts() {
     for (const auto& obj: meta_vjs) { obj->clean_weak_impacts(); }
 }
 
+void PT_Data::mark_as_modified(const MetaVehicleJourney& mvj) {
+    mvj.for_all_vjs([&](const VehicleJourney& vj) {
+        if (vj.route) { modified_routes.insert(vj.route->idx); }
+    });
+}
+
 Indexes
 PT_Data::get_impacts_idx(const std::vector<boost::shared_ptr<disruption::Impact>>& impacts) const {
     Indexes result;
@@ -48,6 +48,7 @@ www.navitia.io
 #include <boost/serialization/map.hpp>
 #include "utils/serialization_unordered_map.h"
 #include "utils/serialization_tuple.h"
+#include <unordered_map>
 
 namespace navitia {
 template <>
@@ -110,6 +111,19 @@ struct PT_Data : boost::noncopyable{
     // timezone manager
     TimeZoneManager tz_manager;
 
+    // idx of the routes whose vehicle journeys have been modified (by the
+    // disruptions or the realtime) since the last build of the raptor data.
+    // Used to update the raptor data incrementally, not serialized.
+    std::set<idx_t> modified_routes;
+
+    // validity patterns indexed by their content, to find an existing
+    // pattern without scanning them all. The patterns can be pushed directly
+    // in validity_patterns, thus the index is completed lazily from
+    // nb_indexed_validity_patterns. Not serialized.
+    std::unordered_map<const ValidityPattern*, ValidityPattern*,
+                       ValidityPatternContentHash, ValidityPatternContentEqual> validity_patterns_index;
+    size_t nb_indexed_validity_patterns = 0;
+
     template<class Archive> void serialize(Archive & ar, const unsigned int) {
         ar
         #define SERIALIZE_ELEMENTS(type_name, collection_name) & collection_name & collection_name##_map
@@ -161,6 +175,14 @@ struct PT_Data : boost::noncopyable{
 
     type::ValidityPattern* get_or_create_validity_pattern(const ValidityPattern& vp_ref);
 
+    /// the validity pattern with the same days and beginning date, nullptr if none
+    type::ValidityPattern* find_validity_pattern(const ValidityPattern& vp_ref);
+
+    /// delete the validity patterns not used anymore by a vehicle journey
+    /// (the patterns left by the disruptions and the realtime), and reindex
+    /// the others. Return the number of deleted patterns
+    size_t clean_unused_validity_patterns();
+
     /** Retrouve un élément par un attribut arbitraire de type chaine de caractères
       *
       * Le template a été surchargé pour gérer des const char* (string passée comme literal)
@@ -175,6 +197,9 @@ struct PT_Data : boost::noncopyable{
 
     void clean_weak_impacts();
 
+    /// flag the routes of the vehicle journeys of the meta vj as modified
+    void mark_as_modified(const MetaVehicleJourney&);
+
     Indexes
     get_impacts_idx(const std::vector<boost::shared_ptr<disruption::Impact>>& impacts) const;
 
@@ -0,0 +1,94 @@
+/* Copyright © 2001-2014, Canal TP and/or its affiliates. All rights reserved.
+  
+This file is part of Navitia,
+    the software to build cool stuff with public transport.
+ 
+Hope you'll enjoy and contribute to this project,
+    powered by Canal TP (www.canaltp.fr).
+Help us simplify mobility and open public transport:
+    a non ending quest to the responsive locomotion way of traveling!
+  
+LICENCE: This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU Affero General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+   
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU Affero General Public License for more details.
+   
+You should have received a copy of the GNU Affero General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+  
+Stay tuned using
+twitter @navitia 
+IRC #navitia on freenode
+https://groups.google.com/d/forum/navitia
+www.navitia.io
+*/
+
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE build_scheduler_test
+
+#include <boost/test/unit_test.hpp>
+#include "type/build_scheduler.h"
+#include "utils/exception.h"
+#include "tests/utils_test.h"
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+
+using navitia::type::BuildScheduler;
+typedef std::vector<BuildScheduler::Stage> Stages;
+
+struct logger_initialized {
+    logger_initialized()   { init_logger(); }
+};
+BOOST_GLOBAL_FIXTURE( logger_initialized );
+
+BOOST_AUTO_TEST_CASE(stages_run_after_their_dependencies) {
+    for (const size_t nb_threads: {1, 2, 8}) {
+        std::mutex mutex;
+        std::vector<std::string> done;
+        auto stage = [&](const std::string& name) {
+            return [&, name]() {
+                std::lock_guard<std::mutex> lock(mutex);
+                done.push_back(name);
+            };
+        };
+        BuildScheduler scheduler;
+        const auto a = scheduler.add("a", stage("a"));
+        const auto b = scheduler.add("b", stage("b"));
+        const auto c = scheduler.add("c", stage("c"), Stages{a});
+        scheduler.add("d", stage("d"), Stages{b, c});
+        scheduler.run(nb_threads);
+
+        BOOST_REQUIRE_EQUAL(done.size(), 4);
+        auto pos = [&](const std::string& name) {
+            return std::find(done.begin(), done.end(), name) - done.begin();
+        };
+        BOOST_CHECK_LT(pos("a"), pos("c"));
+        BOOST_CHECK_LT(pos("b"), pos("d"));
+        BOOST_CHECK_LT(pos("c"), pos("d"));
+    }
+}
+
+// the dependents of a failed stage are skipped, the other stages are run
+BOOST_AUTO_TEST_CASE(failed_stage) {
+    std::atomic<int> nb_runs(0);
+    BuildScheduler scheduler;
+    const auto failing = scheduler.add("failing", []() { throw navitia::exception("bob"); });
+    const auto ok = scheduler.add("ok", [&]() { ++nb_runs; });
+    const auto skipped = scheduler.add("skipped", [&]() { nb_runs += 100; }, Stages{failing, ok});
+    scheduler.add("skipped too", [&]() { nb_runs += 100; }, Stages{skipped});
+    scheduler.add("ok too", [&]() { ++nb_runs; }, Stages{ok});
+
+    BOOST_CHECK_THROW(scheduler.run(4), navitia::exception);
+    BOOST_CHECK_EQUAL(nb_runs, 2);
+}
+
+BOOST_AUTO_TEST_CASE(unknown_dependency) {
+    BuildScheduler scheduler;
+    BOOST_CHECK_THROW(scheduler.add("a", []() {}, Stages{0}), navitia::exception);
+}
@@ -95,3 +95,43 @@ BOOST_AUTO_TEST_CASE(create_vj_test) {
     BOOST_CHECK_EQUAL(rt_vj->adapted_validity_pattern()->days, year("0000000" "0000000"));
     BOOST_CHECK_EQUAL(rt_vj->rt_validity_pattern()->days, year("0000000" "0000110"));
 }
+
+BOOST_AUTO_TEST_CASE(validity_patterns_interning_test) {
+    using year = navitia::type::ValidityPattern::year_bitset;
+    namespace nt = navitia::type;
+
+    ed::builder b("20120614");
+    const auto* vj1 = b.vj("A", "0011")("stop1", 8000, 8000)("stop2", 8100, 8100).make();
+    const auto* vj2 = b.vj("B", "0011")("stop1", 9000, 9000)("stop2", 9100, 9100).make();
+    auto& pt_data = *b.data->pt_data;
+
+    // the similar patterns are shared
+    BOOST_CHECK_EQUAL(vj1->base_validity_pattern(), vj2->base_validity_pattern());
+    const auto nb_vps = pt_data.validity_patterns.size();
+    auto vp = *vj1->base_validity_pattern();
+    BOOST_CHECK_EQUAL(pt_data.get_or_create_validity_pattern(vp), vj1->base_validity_pattern());
+    BOOST_CHECK_EQUAL(pt_data.validity_patterns.size(), nb_vps);
+
+    // a pattern pushed directly is found too
+    auto* pushed_vp = new nt::ValidityPattern(vp.beginning_date, "0110");
+    pushed_vp->idx = pt_data.validity_patterns.size();
+    pt_data.validity_patterns.push_back(pushed_vp);
+    BOOST_CHECK_EQUAL(pt_data.find_validity_pattern(*pushed_vp), pushed_vp);
+
+    // same days, another beginning date: a new pattern
+    nt::ValidityPattern shifted_vp(vp.beginning_date + boost::gregorian::days(1), "0011");
+    auto* new_vp = pt_data.get_or_create_validity_pattern(shifted_vp);
+    BOOST_CHECK_NE(new_vp, vj1->base_validity_pattern());
+    BOOST_CHECK_EQUAL(new_vp->days, year("0011"));
+    BOOST_CHECK_EQUAL(pt_data.validity_patterns.size(), nb_vps + 2);
+
+    // the patterns used by no vj are deleted, the others are reindexed
+    BOOST_CHECK_EQUAL(pt_data.clean_unused_validity_patterns(), 2);
+    BOOST_REQUIRE_EQUAL(pt_data.validity_patterns.size(), nb_vps);
+    for (size_t i = 0; i < pt_data.validity_patterns.size(); ++i) {
+        BOOST_CHECK_EQUAL(pt_data.validity_patterns[i]->idx, i);
+    }
+    BOOST_CHECK(! pt_data.find_validity_pattern(shifted_vp));
+    BOOST_CHECK_EQUAL(pt_data.find_validity_pattern(vp), vj1->base_validity_pattern());
+    BOOST_CHECK_EQUAL(pt_data.validity_patterns_map.count(vj1->base_validity_pattern()->uri), 1);
+}
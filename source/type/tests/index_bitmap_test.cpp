@@ -0,0 +1,131 @@
+/* Copyright © 2001-2014, Canal TP and/or its affiliates. All rights reserved.
+  
+This file is part of Navitia,
+    the software to build cool stuff with public transport.
+ 
+Hope you'll enjoy and contribute to this project,
+    powered by Canal TP (www.canaltp.fr).
+Help us simplify mobility and open public transport:
+    a non ending quest to the responsive locomotion way of traveling!
+  
+LICENCE: This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU Affero General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+   
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU Affero General Public License for more details.
+   
+You should have received a copy of the GNU Affero General Public License
+along with this program. If not, see <http://www.gnu.org/licenses/>.
+  
+Stay tuned using
+twitter @navitia 
+IRC #navitia on freenode
+https://groups.google.com/d/forum/navitia
+www.navitia.io
+*/
+
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE index_bitmap_test
+
+#include <boost/test/unit_test.hpp>
+#include "type/index_bitmap.h"
+#include <algorithm>
+#include <iterator>
+#include <random>
+#include <set>
+
+using navitia::type::IndexBitmap;
+using navitia::type::Indexes;
+using navitia::type::idx_t;
+
+static void check_equal(const IndexBitmap& bitmap, const std::set<idx_t>& expected) {
+    BOOST_REQUIRE_EQUAL(bitmap.size(), expected.size());
+    const Indexes indexes = bitmap.to_indexes();
+    BOOST_CHECK_EQUAL_COLLECTIONS(indexes.begin(), indexes.end(), expected.begin(), expected.end());
+    for (const idx_t idx: expected) {
+        BOOST_CHECK(bitmap.contains(idx));
+    }
+    // the representation depends only on the content
+    IndexBitmap inserted_backward;
+    inserted_backward.insert(expected.rbegin(), expected.rend());
+    BOOST_CHECK(inserted_backward == bitmap);
+}
+
+BOOST_AUTO_TEST_CASE(insert_and_convert) {
+    IndexBitmap bitmap;
+    BOOST_CHECK(bitmap.empty());
+    bitmap.insert(70000);
+    bitmap.insert(3);
+    bitmap.insert(70000);
+    bitmap.insert(65535);
+    BOOST_CHECK(! bitmap.empty());
+    check_equal(bitmap, {3, 65535, 70000});
+    BOOST_CHECK(! bitmap.contains(4));
+    BOOST_CHECK(! bitmap.contains(65536));
+
+    const auto indexes = navitia::type::make_indexes({1, 2, 100000});
+    BOOST_CHECK(IndexBitmap(indexes).to_indexes() == indexes);
+
+    bitmap.clear();
+    BOOST_CHECK(bitmap.empty());
+    BOOST_CHECK_EQUAL(bitmap.size(), 0);
+}
+
+// the sparse and the dense groups are mixed on random sets
+BOOST_AUTO_TEST_CASE(set_algebra) {
+    std::mt19937 rng(42);
+    for (const idx_t range: {idx_t(30000), idx_t(300000), idx_t(10000000)}) {
+        for (int i = 0; i < 10; ++i) {
+            std::set<idx_t> a_idx, b_idx;
+            IndexBitmap a, b;
+            for (size_t n = rng() % 20000; n > 0; --n) {
+                const idx_t idx = rng() % range;
+                a_idx.insert(idx);
+                a.insert(idx);
+            }
+            for (size_t n = rng() % 20000; n > 0; --n) {
+                const idx_t idx = rng() % range;
+                b_idx.insert(idx);
+                b.insert(idx);
+            }
+            check_equal(a, a_idx);
+
+            std::set<idx_t> expected;
+            std::set_intersection(a_idx.begin(), a_idx.end(), b_idx.begin(), b_idx.end(),
+                                  std::inserter(expected, expected.end()));
+            check_equal(a & b, expected);
+
+            expected.clear();
+            std::set_union(a_idx.begin(), a_idx.end(), b_idx.begin(), b_idx.end(),
+                           std::inserter(expected, expected.end()));
+            check_equal(a | b, expected);
+
+            expected.clear();
+            std::set_difference(a_idx.begin(), a_idx.end(), b_idx.begin(), b_idx.end(),
+                                std::inserter(expected, expected.end()));
+            check_equal(a - b, expected);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(pages) {
+    IndexBitmap bitmap;
+    std::vector<idx_t> all;
+    // a dense group, a sparse group, and a dense group again
+    for (idx_t idx = 0; idx < 10000; ++idx) { all.push_back(idx); }
+    for (idx_t idx = 65536; idx < 70000; idx += 10) { all.push_back(idx); }
+    for (idx_t idx = 200000; idx < 210000; ++idx) { all.push_back(idx); }
+    bitmap.insert(all.begin(), all.end());
+
+    for (const size_t first: {size_t(0), size_t(9990), size_t(10000), size_t(10400), size_t(24000)}) {
+        const Indexes page = bitmap.to_indexes(first, 25);
+        const auto begin = all.begin() + long(std::min(first, all.size()));
+        const auto end = all.begin() + long(std::min(first + 25, all.size()));
+        BOOST_CHECK_EQUAL_COLLECTIONS(page.begin(), page.end(), begin, end);
+    }
+    BOOST_CHECK(bitmap.to_indexes(all.size(), 10).empty());
+}
@@ -39,9 +39,12 @@ www.navitia.io
 #include "tests/utils_test.h"
 #include "type/meta_data.h"
 #include "ed/build_helper.h"
+#include "georef/adminref.h"
+#include "georef/georef.h"
 
 #include <boost/geometry.hpp>
 #include <boost/make_shared.hpp>
+#include <sstream>
 
 namespace pt = boost::posix_time;
 namespace bg = boost::gregorian;
@@ -270,3 +273,133 @@ BOOST_AUTO_TEST_CASE(get_sections_stop_points){
     BOOST_CHECK_EQUAL(vj->get_sections_stop_points(sa("0"), sa("2")),
                       std::set<type::StopPoint*>({sp("0"), sp("2"), sp("4")}));
 }
+
+/*
+ * The admins store the idx of their stop areas and stop points, they must
+ * still point to the same objects once the sort of complete() has renumbered them
+ */
+BOOST_AUTO_TEST_CASE(admins_stops_after_sort) {
+    ed::builder b("20120614");
+    // the stop points are sorted by uri, thus in the reverse order of their creation
+    b.sa("z");
+    b.sa("m");
+    b.sa("a");
+    auto* admin = new navitia::georef::Admin(8);
+    admin->uri = "admin";
+    admin->idx = b.data->geo_ref->admins.size();
+    b.data->geo_ref->admins.push_back(admin);
+    b.data->pt_data->index();
+    std::vector<std::string> main_stop_areas;
+    for (const auto* sa: b.data->pt_data->stop_areas) {
+        admin->main_stop_areas.push_back(sa->idx);
+        main_stop_areas.push_back(sa->uri);
+    }
+    admin->odt_stop_points.push_back(b.get<StopPoint>("stop_point:z")->idx);
+    admin->odt_stop_points.push_back(b.get<StopPoint>("stop_point:a")->idx);
+    BOOST_REQUIRE_EQUAL(b.get<StopPoint>("stop_point:z")->idx, 0);
+
+    b.data->complete();
+
+    BOOST_CHECK_EQUAL(b.get<StopPoint>("stop_point:a")->idx, 0);
+    const auto& stop_points = b.data->pt_data->stop_points;
+    BOOST_REQUIRE_EQUAL(admin->odt_stop_points.size(), 2);
+    BOOST_CHECK_EQUAL(stop_points[admin->odt_stop_points[0]]->uri, "stop_point:z");
+    BOOST_CHECK_EQUAL(stop_points[admin->odt_stop_points[1]]->uri, "stop_point:a");
+    std::vector<std::string> main_stop_areas_after_sort;
+    for (const auto idx: admin->main_stop_areas) {
+        main_stop_areas_after_sort.push_back(b.data->pt_data->stop_areas[idx]->uri);
+    }
+    BOOST_CHECK_EQUAL_RANGE(main_stop_areas_after_sort, main_stop_areas);
+}
+
+template<typename T>
+static std::vector<std::string> get_uris(const std::vector<T*>& objects) {
+    std::vector<std::string> uris;
+    for (const auto* object: objects) {
+        uris.push_back(object->uri);
+    }
+    return uris;
+}
+
+/*
+ * save writes pt_data, geo_ref, meta and fare in the sections of a LZ4 block
+ * container, load reads them concurrently: the data must be the same after the
+ * reload, with the admins of the stops being the ones of the geo_ref
+ */
+BOOST_AUTO_TEST_CASE(save_load_sections) {
+    ed::builder b("20120614");
+    b.vj("A")("stop1", 8000, 8050)("stop2", 8100, 8150)("stop3", 8200, 8250);
+    b.vj("B")("stop3", 9000, 9000)("stop1", 9100, 9100);
+    b.finish();
+    b.data->pt_data->index();
+
+    auto& geo_ref = *b.data->geo_ref;
+    auto* region = new navitia::georef::Admin(4);
+    region->uri = "region";
+    auto* city = new navitia::georef::Admin(8);
+    city->uri = "city";
+    city->admin_list.push_back(region);
+    for (auto* admin: {region, city}) {
+        admin->idx = geo_ref.admins.size();
+        geo_ref.admins.push_back(admin);
+    }
+    b.get<StopArea>("stop1")->admin_list.push_back(city);
+    b.get<StopPoint>("stop1")->admin_list.push_back(city);
+    b.get<StopPoint>("stop2")->admin_list.push_back(region);
+
+    for (const auto& xy: std::vector<std::pair<double, double>>{{2.1, 48.1}, {2.2, 48.1}, {2.2, 48.2}}) {
+        boost::add_vertex(navitia::georef::Vertex(xy.first, xy.second), geo_ref.graph);
+    }
+    boost::add_edge(0, 1, navitia::georef::Edge(0, navitia::seconds(10)), geo_ref.graph);
+    boost::add_edge(1, 2, navitia::georef::Edge(0, navitia::seconds(20)), geo_ref.graph);
+    boost::add_edge(2, 0, navitia::georef::Edge(0, navitia::seconds(30)), geo_ref.graph);
+
+    std::stringstream ss;
+    b.data->save(ss);
+    Data loaded;
+    loaded.load(ss);
+
+    const auto& pt_data = *b.data->pt_data;
+    const auto& loaded_pt_data = *loaded.pt_data;
+    BOOST_CHECK_EQUAL(loaded.version, Data::data_version);
+    BOOST_CHECK_EQUAL_RANGE(get_uris(loaded_pt_data.stop_areas), get_uris(pt_data.stop_areas));
+    BOOST_CHECK_EQUAL_RANGE(get_uris(loaded_pt_data.stop_points), get_uris(pt_data.stop_points));
+    BOOST_CHECK_EQUAL_RANGE(get_uris(loaded_pt_data.lines), get_uris(pt_data.lines));
+    BOOST_CHECK_EQUAL_RANGE(get_uris(loaded_pt_data.routes), get_uris(pt_data.routes));
+    BOOST_CHECK_EQUAL_RANGE(get_uris(loaded_pt_data.vehicle_journeys), get_uris(pt_data.vehicle_journeys));
+    BOOST_CHECK_EQUAL(loaded_pt_data.nb_stop_times(), pt_data.nb_stop_times());
+
+    const auto& loaded_geo_ref = *loaded.geo_ref;
+    BOOST_REQUIRE_EQUAL(boost::num_vertices(loaded_geo_ref.graph), boost::num_vertices(geo_ref.graph));
+    BOOST_REQUIRE_EQUAL(boost::num_edges(loaded_geo_ref.graph), boost::num_edges(geo_ref.graph));
+    for (navitia::georef::vertex_t v = 0; v < boost::num_vertices(geo_ref.graph); ++v) {
+        BOOST_CHECK_EQUAL(loaded_geo_ref.graph[v].coord, geo_ref.graph[v].coord);
+        BOOST_CHECK_EQUAL(boost::out_degree(v, loaded_geo_ref.graph), boost::out_degree(v, geo_ref.graph));
+        for (auto range = boost::out_edges(v, geo_ref.graph); range.first != range.second; ++range.first) {
+            const auto target = boost::target(*range.first, geo_ref.graph);
+            const auto loaded_edge = boost::edge(v, target, loaded_geo_ref.graph);
+            BOOST_REQUIRE(loaded_edge.second);
+            BOOST_CHECK_EQUAL(loaded_geo_ref.graph[loaded_edge.first].duration, geo_ref.graph[*range.first].duration);
+        }
+    }
+
+    // the admins of the stops are the ones of the geo_ref, not copies
+    BOOST_CHECK_EQUAL_RANGE(get_uris(loaded_geo_ref.admins), get_uris(geo_ref.admins));
+    for (size_t i = 0; i < pt_data.stop_areas.size(); ++i) {
+        const auto& admins = loaded_pt_data.stop_areas[i]->admin_list;
+        BOOST_CHECK_EQUAL_RANGE(get_uris(admins), get_uris(pt_data.stop_areas[i]->admin_list));
+        for (const auto* admin: admins) {
+            BOOST_CHECK_EQUAL(admin, loaded_geo_ref.admins.at(admin->idx));
+        }
+    }
+    for (size_t i = 0; i < pt_data.stop_points.size(); ++i) {
+        const auto& admins = loaded_pt_data.stop_points[i]->admin_list;
+        BOOST_CHECK_EQUAL_RANGE(get_uris(admins), get_uris(pt_data.stop_points[i]->admin_list));
+        for (const auto* admin: admins) {
+            BOOST_CHECK_EQUAL(admin, loaded_geo_ref.admins.at(admin->idx));
+        }
+    }
+    const auto* loaded_city = loaded_geo_ref.admins.at(city->idx);
+    BOOST_REQUIRE_EQUAL(loaded_city->admin_list.size(), 1);
+    BOOST_CHECK_EQUAL(loaded_city->admin_list[0], loaded_geo_ref.admins.at(region->idx));
+}
@@ -478,6 +478,9 @@ void cleanup_useless_vj_link(const nt::VehicleJourney* vj, nt::PT_Data& pt_data)
 }// anonymous namespace
 
 void MetaVehicleJourney::clean_up_useless_vjs(nt::PT_Data& pt_data) {
+    // the vjs might have been modified before the cleanup, and their
+    // routes must be flagged before the useless vjs are removed
+    pt_data.mark_as_modified(*this);
     std::vector<std::pair<RTLevel, size_t>> vj_idx_to_remove;
     for (const auto& rt_vjs: rtlevel_to_vjs_map) {
         auto& vjs = rt_vjs.second;
@@ -578,6 +581,7 @@ VJ* MetaVehicleJourney::impl_create_vj(const std::string& uri,
     pt_data.vehicle_journeys_map[ret->uri] = ret;
     if (route) {
         get_vjs<VJ>(route).push_back(ret);
+        pt_data.modified_routes.insert(route->idx);
     }
     rtlevel_to_vjs_map[level].emplace_back(std::move(vj_ptr));
     return ret;
@@ -608,6 +612,7 @@ void MetaVehicleJourney::cancel_vj(RTLevel level,
                                    const std::vector<boost::posix_time::time_period>& periods,
                                    nt::PT_Data& pt_data,
                                    const Route* filtering_route) {
+    pt_data.mark_as_modified(*this);
     for (auto vj_level: reverse_enum_range_from<RTLevel>(level)) {
         for (auto& vj: rtlevel_to_vjs_map[vj_level]) {
             // for each vj, we want to cancel vp at all levels above cancel level
@@ -30,6 +30,7 @@ www.navitia.io
 #pragma once
 #include "type_interfaces.h"
 #include <boost/date_time/gregorian/gregorian.hpp>
+#include <boost/functional/hash.hpp>
 #include <bitset>
 
 namespace navitia {
@@ -70,5 +71,21 @@ public:
     bool operator==(const ValidityPattern & other) const { return (this->beginning_date == other.beginning_date) && (this->days == other.days);}
 };
 
+/// hash and equality on the content (days and beginning date) of the pointed
+/// validity patterns, to index them by content
+struct ValidityPatternContentHash {
+    size_t operator()(const ValidityPattern* vp) const {
+        size_t seed = std::hash<ValidityPattern::year_bitset>()(vp->days);
+        boost::hash_combine(seed, vp->beginning_date.day_number());
+        return seed;
+    }
+};
+
+struct ValidityPatternContentEqual {
+    bool operator()(const ValidityPattern* vp1, const ValidityPattern* vp2) const {
+        return *vp1 == *vp2;
+    }
+};
+
 }
 }